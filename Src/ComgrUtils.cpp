@@ -5,79 +5,129 @@
 /// \brief  This is a high level C++ interface of comgr utility functionality for tools.
 //============================================================================================
 #include "ComgrUtils.h"
+#include "ComgrUtilsElf.h"
+#include "ComgrUtilsMsgPack.h"
+#include "ComgrUtilsDiskCache.h"
+#include "ComgrUtilsProcessPool.h"
+#include "ComgrUtilsWorkerPool.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <limits>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 namespace AMDT
 {
-ComgrEntryPoints* ComgrEntryPoints::m_pInstance = nullptr;
+std::atomic<ComgrEntryPoints*> ComgrEntryPoints::m_pInstance(nullptr);
+std::mutex                     ComgrEntryPoints::m_instanceMutex;
 
-/// Helper macro to avoid warnings about unused arguments for callbacks.
-#define COMGRUTILS_UNUSED(x)  ((void)(x))
+// Seed of the tag hash, found offline so that every tag of the registry gets its own slot.
+static constexpr uint32_t s_PAL_MD_TAG_HASH_SEED = 0x811cbf39;
 
-static void strncpy_safe(char* dest, const char* src, size_t copySize, size_t sourceBufferSize)
+// Number of slots of the tag hash table; the hash yields 8 bits.
+static constexpr size_t s_PAL_MD_TAG_NUM_SLOTS = 256;
+
+// Hash a metadata key to its slot: FNV-1a with a tuned seed, top 8 bits.
+static constexpr uint32_t HashPalMDKey(const char* pKey, size_t keyLen)
 {
-#ifdef _WIN32
-    strncpy_s(dest, copySize, src, sourceBufferSize);
-#else
+    uint32_t hash = s_PAL_MD_TAG_HASH_SEED;
 
-    COMGRUTILS_UNUSED(sourceBufferSize);
-    strncpy(dest, src, copySize);
+    for (size_t i = 0; i < keyLen; ++i)
+    {
+        hash = (hash ^ static_cast<uint8_t>(pKey[i])) * 16777619u;
+    }
 
-#endif
+    return hash >> 24;
+}
+
+// Slot to tag table of the perfect hash.
+struct PalMDTagSlots
+{
+    uint8_t m_tags[s_PAL_MD_TAG_NUM_SLOTS];   // The PalMDTag stored in each slot, PalMDTag::Unknown if empty.
+};
+
+// Build the slot table at compile time
+static constexpr PalMDTagSlots BuildPalMDTagSlots()
+{
+    PalMDTagSlots slots = {};
+
+    for (size_t slot = 0; slot < s_PAL_MD_TAG_NUM_SLOTS; ++slot)
+    {
+        slots.m_tags[slot] = static_cast<uint8_t>(PalMDTag::Unknown);
+    }
+
+    for (size_t tag = 0; tag < static_cast<size_t>(PalMDTag::Count); ++tag)
+    {
+        slots.m_tags[HashPalMDKey(gs_PAL_MD_TAG_NAMES[tag], gs_PAL_MD_TAG_LENGTHS[tag])] = static_cast<uint8_t>(tag);
+    }
+
+    return slots;
+}
+
+// The slot table of the perfect hash.
+static constexpr PalMDTagSlots s_PAL_MD_TAG_SLOTS = BuildPalMDTagSlots();
+
+// Check that no two tags share a slot
+static constexpr bool IsPalMDTagHashPerfect()
+{
+    for (size_t tag = 0; tag < static_cast<size_t>(PalMDTag::Count); ++tag)
+    {
+        if (s_PAL_MD_TAG_SLOTS.m_tags[HashPalMDKey(gs_PAL_MD_TAG_NAMES[tag], gs_PAL_MD_TAG_LENGTHS[tag])] != tag)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(IsPalMDTagHashPerfect(), "PAL metadata tags collide, choose another s_PAL_MD_TAG_HASH_SEED");
+
+// Resolve a metadata key to its tag with one hash and one string comparison, usable at compile time.
+static constexpr PalMDTag FindPalMDTag(const char* pKey, size_t keyLen)
+{
+    uint8_t tag = s_PAL_MD_TAG_SLOTS.m_tags[HashPalMDKey(pKey, keyLen)];
+
+    if (tag == static_cast<uint8_t>(PalMDTag::Unknown) || gs_PAL_MD_TAG_LENGTHS[tag] != keyLen)
+    {
+        return PalMDTag::Unknown;
+    }
+
+    for (size_t i = 0; i < keyLen; ++i)
+    {
+        if (gs_PAL_MD_TAG_NAMES[tag][i] != pKey[i])
+        {
+            return PalMDTag::Unknown;
+        }
+    }
+
+    return static_cast<PalMDTag>(tag);
 }
 
-// Metadata tags
-const char*  gs_PAL_MD_TAG_PIPELINE_VERSION            = "amdpal.version";
-const char*  gs_PAL_MD_TAG_PIPELINE_NAME               = ".name";
-const char*  gs_PAL_MD_TAG_PIPELINE_TYPE               = ".type";
-const char*  gs_PAL_MD_TAG_PIPELINE_HASH               = ".pipeline_compiler_hash";
-const char*  gs_PAL_MD_TAG_PIPELINES                   = "amdpal.pipelines";
-const char*  gs_PAL_MD_TAG_SHADERS                     = ".shaders";
-const char*  gs_PAL_MD_TAG_SHADER_TYPE_VERTEX          = ".vertex";
-const char*  gs_PAL_MD_TAG_SHADER_TYPE_HULL            = ".hull";
-const char*  gs_PAL_MD_TAG_SHADER_TYPE_DOMAIN          = ".domain";
-const char*  gs_PAL_MD_TAG_SHADER_TYPE_GEOMETRY        = ".geometry";
-const char*  gs_PAL_MD_TAG_SHADER_TYPE_PIXEL           = ".pixel";
-const char*  gs_PAL_MD_TAG_SHADER_TYPE_COMPUTE         = ".compute";
-const char*  gs_PAL_MD_TAG_SHADER_HASH                 = ".api_shader_hash";
-const char*  gs_PAL_MD_TAG_SHADER_HARDWARE_MAPPING     = ".hardware_mapping";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGES             = ".hardware_stages";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_LS           = ".ls";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_HS           = ".hs";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_ES           = ".es";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_GS           = ".gs";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_VS           = ".vs";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_PS           = ".ps";
-const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_CS           = ".cs";
-const char*  gs_PAL_MD_TAG_ENTRY_POINT_SYMBOL_NAME     = ".entry_point";
-const char*  gs_PAL_MD_TAG_SCRATCH_MEMORY_SIZE         = ".scratch_memory_size";
-const char*  gs_PAL_MD_TAG_LOCAL_DATA_SHARE_SIZE       = ".lds_size";
-const char*  gs_PAL_MD_TAG_PERF_DATA_BUFFER_SIZE       = "PerformanceDataBufferSize";
-const char*  gs_PAL_MD_TAG_NUM_USED_VGPRS              = ".vgpr_count";
-const char*  gs_PAL_MD_TAG_NUM_USED_SGPRS              = ".sgpr_count";
-const char*  gs_PAL_MD_TAG_NUM_AVAILABLE_VGPRS         = ".vgpr_limit";
-const char*  gs_PAL_MD_TAG_NUM_AVAILABLE_SGPRS         = ".sgpr_limit";
-const char*  gs_PAL_MD_TAG_WAVES_PER_GROUP             = ".waves_per_group";
-const char*  gs_PAL_MD_TAG_USES_UAVS                   = ".uses_uavs";
-const char*  gs_PAL_MD_TAG_USES_ROVS                   = ".uses_rovs";
-const char*  gs_PAL_MD_TAG_WRITES_UAVS                 = ".writes_uavs";
-const char*  gs_PAL_MD_TAG_WRITES_DEPTH                = ".writes_depth";
-const char*  gs_PAL_MD_TAG_MAX_PRIMS_PER_PS_WAVE       = ".max_prims_per_ps_wave";
-const char*  gs_PAL_MD_TAG_NUM_INTERPOLANTS            = ".num_interpolants";
-const char*  gs_PAL_MD_TAG_REGISTERS                   = ".registers";
-const char*  gs_PAL_MD_TAG_USER_DATA_LIMIT             = ".user_data_limit";
-const char*  gs_PAL_MD_TAG_SPILL_SHRESHOLD             = ".spill_threshold";
-const char*  gs_PAL_MD_TAG_USES_VIEWPORT_ARRAY_INDEX   = ".uses_viewport_array_index";
-const char*  gs_PAL_MD_TAG_ES_GS_LOCAL_DATA_SHARE_SIZE = ".es_gs_lds_size";
-const char*  gs_PAL_MD_TAG_WAVEFRONT_SIZE              = ".wavefront_size";
-const char*  gs_PAL_MD_TAG_API                         = ".api";
-const char*  gs_PAL_MD_TAG_API_CREATE_INFO             = ".api_create_info";
+static_assert(FindPalMDTag(".hardware_stages", 16) == PalMDTag::HARDWARE_STAGES, "PAL metadata tag lookup is broken");
 
+PalMDTag LookupPalMDTag(const char* pKey, size_t keyLen)
+{
+    return FindPalMDTag(pKey, keyLen);
+}
+
+/// Helper macro to avoid warnings about unused arguments for callbacks.
+#define COMGRUTILS_UNUSED(x)  ((void)(x))
 
 // Iteration state for symbols
 struct CodeObjSymbolIterState
@@ -87,26 +137,132 @@ struct CodeObjSymbolIterState
     uint32_t        m_symbolCount;              // Num symbols
     uint32_t        m_currentPosition;          // Current position
     CodeObjSymbol*  m_pCodeObjectSymbols;       // Array of symbols that is filled
-    CodeObjSymbolIterState():m_pScratchBuffer(nullptr), m_scratchBuffersizeInBytes(0), m_symbolCount(0), m_currentPosition(0), m_pCodeObjectSymbols(nullptr) {}
+    char*           m_pNamePool;                // Pool the symbol names are copied into, back to back
+    size_t          m_namePoolSize;             // Size of the name pool, including null terminators
+    size_t          m_namePoolUsed;             // Bytes of the name pool filled so far
+    CodeObjSymbolIterState():m_pScratchBuffer(nullptr), m_scratchBuffersizeInBytes(0), m_symbolCount(0), m_currentPosition(0), m_pCodeObjectSymbols(nullptr),
+                             m_pNamePool(nullptr), m_namePoolSize(0), m_namePoolUsed(0) {}
+};
+
+thread_local amd_comgr_status_t CodeObj::m_status = AMD_COMGR_STATUS_SUCCESS;
+thread_local std::string        CodeObj::m_errMsg;
+
+std::mutex                 CodeObj::m_diskCacheMutex;
+std::shared_ptr<DiskCache> CodeObj::m_pDisassemblyDiskCache;
+std::shared_ptr<DiskCache> CodeObj::m_pCompileDiskCache;
+
+// The cache is never deleted, so data sets still cached at exit are not released after comgr has shut down.
+std::mutex                                                                      CodeObj::m_compileDataSetMutex;
+std::unordered_map<std::string, std::shared_ptr<const CodeObj::CompileDataSets>>* CodeObj::m_pCompileDataSets =
+    new std::unordered_map<std::string, std::shared_ptr<const CodeObj::CompileDataSets>>;
+
+std::mutex                   CodeObj::m_processPoolMutex;
+std::shared_ptr<ProcessPool> CodeObj::m_pProcessPool;
+
+// Options of the compile, link and codegen steps of ConvertSourceToCodeObject
+static const char* s_COMPILE_OPTIONS = "-mno-code-object-v3";
+
+// Version of the results ComgrUtils stores in the disk caches, part of every key;
+// bump it when the content of a cached result changes for the same comgr library
+static const unsigned int s_DISK_CACHE_FORMAT_VERSION = 1;
+
+
+// Numbers read from metadata strings fit this buffer, including the null terminator
+static const size_t s_MD_NUMBER_BUFFER_SIZE = 64;
+
+// State of a MDNode::VisitMap iteration
+struct MapVisitState
+{
+    MDNode::MapVisitor  m_pVisitor;         // The callback of the caller
+    void*               m_pUserData;        // User data of the caller
+    std::vector<char>   m_keyBuffer;        // Buffer the keys are read into, reused for every entry
+    bool                m_visitorFailed;    // True if the callback stopped the iteration
+    MapVisitState(MDNode::MapVisitor pVisitor, void* pUserData) : m_pVisitor(pVisitor), m_pUserData(pUserData), m_visitorFailed(false) {}
 };
 
-amd_comgr_status_t CodeObj::m_status;
-std::string        CodeObj::m_errMsg;
+// Read the string of a metadata node into a buffer, the length excludes the null terminator
+static amd_comgr_status_t ReadMDString(amd_comgr_metadata_node_t node, std::vector<char>& buf, size_t& length)
+{
+    size_t size = 0;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(node, &size, nullptr);
 
-static std::vector<std::string> gMapKeys; ///< Global keys map for MapIterCallback.
+    if (status == AMD_COMGR_STATUS_SUCCESS)
+    {
+        // The size includes the null terminator.
+        buf.resize(size + 1);
+        status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(node, &size, buf.data());
+        buf[size] = '\0';
+        length = strlen(buf.data());
+    }
 
+    return status;
+}
 
 extern "C" amd_comgr_status_s
 MapIterCallback(amd_comgr_metadata_node_t key, amd_comgr_metadata_node_t val, void* data)
 {
-    COMGRUTILS_UNUSED(val);
-    COMGRUTILS_UNUSED(data);
-    const std::string& keyVal = MDNode(key).value<std::string>();
-    gMapKeys.push_back(keyVal);
-    return (CodeObj::GetLastError().first == AMD_COMGR_STATUS_SUCCESS ?
-            AMD_COMGR_STATUS_SUCCESS : AMD_COMGR_STATUS_ERROR);
+    // The callback owns both nodes.
+    ComgrMetadataNode keyNode(key);
+    ComgrMetadataNode valNode(val);
+    std::vector<std::string>* pKeys = static_cast<std::vector<std::string>*>(data);
+
+    if (pKeys == nullptr)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Report the status of reading this key, not the last error of the thread, which may be
+    // left over from an earlier failed lookup of an optional item.
+    std::vector<char> buf;
+    size_t length = 0;
+    amd_comgr_status_t status = ReadMDString(key, buf, length);
+
+    if (status == AMD_COMGR_STATUS_SUCCESS)
+    {
+        pKeys->emplace_back(buf.data(), length);
+    }
+
+    return status;
 };
 
+extern "C" amd_comgr_status_t
+MapVisitCallback(amd_comgr_metadata_node_t key, amd_comgr_metadata_node_t val, void* data)
+{
+    MapVisitState* pState = static_cast<MapVisitState*>(data);
+
+    // The callback owns both nodes, the value node is handed to the visitor as an MDNode.
+    ComgrMetadataNode keyNode(key);
+    MDNode valNode(val);
+
+    if (pState == nullptr)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t keyLen = 0;
+    amd_comgr_status_t status = ReadMDString(key, pState->m_keyBuffer, keyLen);
+
+    if (status != AMD_COMGR_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    const char* pKey = pState->m_keyBuffer.data();
+
+    if (!pState->m_pVisitor(LookupPalMDTag(pKey, keyLen), pKey, keyLen, valNode, pState->m_pUserData))
+    {
+        pState->m_visitorFailed = true;
+        return AMD_COMGR_STATUS_ERROR;
+    }
+
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+// Function symbols are STT_FUNC and STT_AMDGPU_HSA_KERNEL entries; comgr reports the ELF symbol type
+static bool IsFunctionSymbolType(amd_comgr_symbol_type_t type)
+{
+    return type == AMD_COMGR_SYMBOL_TYPE_FUNC || static_cast<uint32_t>(type) == ELF_STT_AMDGPU_HSA_KERNEL;
+}
 
 amd_comgr_status_t countFuncSymbolCallback(amd_comgr_symbol_t symbol, void* pUserData)
 {
@@ -117,10 +273,14 @@ amd_comgr_status_t countFuncSymbolCallback(amd_comgr_symbol_t symbol, void* pUse
         void* buffer = pState->m_pScratchBuffer;
         status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_TYPE, buffer);
 
-        if (*((amd_comgr_symbol_type_t*)buffer) == AMD_COMGR_SYMBOL_TYPE_FUNC)
+        if (status == AMD_COMGR_STATUS_SUCCESS && IsFunctionSymbolType(*((amd_comgr_symbol_type_t*)buffer)))
         {
-            // if its a function print some more info
+            // if its a function, count it and reserve room for its name in the pool
             pState->m_symbolCount += 1;
+
+            size_t nameLen = 0;
+            status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_NAME_LENGTH, &nameLen);
+            pState->m_namePoolSize += nameLen + 1;
         }
     }
 
@@ -144,8 +304,13 @@ amd_comgr_status_t appendToSymbolVectorCallback(amd_comgr_symbol_t symbol, void*
 
     status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_TYPE, buffer);
 
-    if (*((amd_comgr_symbol_type_t*)buffer) == AMD_COMGR_SYMBOL_TYPE_FUNC)
+    if (IsFunctionSymbolType(*((amd_comgr_symbol_type_t*)buffer)))
     {
+        if (pState->m_currentPosition >= pState->m_symbolCount)
+        {
+            return AMD_COMGR_STATUS_ERROR;
+        }
+
         CodeObjSymbol* functionSymbol = &(pState->m_pCodeObjectSymbols[pState->m_currentPosition]);
 
         functionSymbol->m_type = COMGR_UTILS_SYMBOL_TYPE_FUNC;
@@ -154,13 +319,19 @@ amd_comgr_status_t appendToSymbolVectorCallback(amd_comgr_symbol_t symbol, void*
         status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_NAME_LENGTH, buffer);
         functionSymbol->m_symbolFunction.m_nameLen = *(size_t*)(buffer);
 
-        functionSymbol->m_symbolFunction.m_pName = (char*)malloc(functionSymbol->m_symbolFunction.m_nameLen + 1);
-        if (functionSymbol->m_symbolFunction.m_pName != nullptr)
+        // The name goes into the next free slot of the pool sized by countFuncSymbolCallback
+        size_t nameSize = static_cast<size_t>(functionSymbol->m_symbolFunction.m_nameLen) + 1;
+
+        if (nameSize > pState->m_namePoolSize - pState->m_namePoolUsed)
         {
-            memset(functionSymbol->m_symbolFunction.m_pName, '\0', functionSymbol->m_symbolFunction.m_nameLen + 1);
-            status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_NAME, functionSymbol->m_symbolFunction.m_pName);
+            return AMD_COMGR_STATUS_ERROR;
         }
 
+        functionSymbol->m_symbolFunction.m_pName = pState->m_pNamePool + pState->m_namePoolUsed;
+        pState->m_namePoolUsed += nameSize;
+        memset(functionSymbol->m_symbolFunction.m_pName, '\0', nameSize);
+        status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_NAME, functionSymbol->m_symbolFunction.m_pName);
+
         memset(buffer, 0, buffersize);
         status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(symbol, AMD_COMGR_SYMBOL_INFO_SIZE, buffer);
         functionSymbol->m_symbolFunction.m_symbolSize =  *(uint64_t*)buffer;
@@ -176,441 +347,2026 @@ amd_comgr_status_t appendToSymbolVectorCallback(amd_comgr_symbol_t symbol, void*
     return status;
 }
 
-std::unique_ptr<CodeObj>
-CodeObj::OpenFile(const std::string& fileName)
-{
-    std::ifstream file(fileName, std::ios::in | std::ios::binary);
-    std::vector<char> buf;
-    file.seekg(0, std::ios::end);
-    int size = static_cast<int>(file.tellg());
-    file.seekg(0, std::ios::beg);
-    buf.resize(size);
-    file.read(&buf[0], size);
-    return OpenBuffer(buf);
-}
-
-std::unique_ptr<CodeObj>
-CodeObj::OpenFile(const std::string& fileName, const amd_comgr_data_kind_t& dataKind)
-{
-    std::ifstream file(fileName, std::ios::in | std::ios::binary);
-    std::vector<char> buf;
-    file.seekg(0, std::ios::end);
-    int size = static_cast<int>(file.tellg());
-    file.seekg(0, std::ios::beg);
-    buf.resize(size);
-    file.read(&buf[0], size);
-    return OpenBuffer(buf, dataKind);
-}
-
-std::unique_ptr<CodeObj>
-CodeObj::OpenBufferRaw(const char* pBuf, const size_t sizeInBytes)
+std::unique_ptr<MappedFile>
+MappedFile::Open(const std::string& fileName)
 {
-    std::unique_ptr<CodeObj> retHandle = nullptr;
+    std::unique_ptr<MappedFile> pMappedFile(new (std::nothrow) MappedFile);
 
-    if (pBuf != nullptr && sizeInBytes > 0)
+    if (pMappedFile == nullptr)
     {
-        std::vector<char> buffer;
-        buffer.assign(pBuf, pBuf + sizeInBytes);
-        retHandle = OpenBuffer(buffer);
+        return nullptr;
     }
 
-    return retHandle;
-}
-
-std::unique_ptr<CodeObj>
-CodeObj::OpenBuffer(const std::vector<char>& buf)
-{
-    amd_comgr_data_t coData;
-    amd_comgr_data_set_t coDataSet;
-    amd_comgr_status_t status = AMD_COMGR_STATUS_ERROR;
-
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_fn(AMD_COMGR_DATA_KIND_RELOCATABLE, &coData);
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_set_data_fn(coData, buf.size(), &buf[0]);
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_set_data_name_fn(coData, "data");
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&coDataSet);
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_data_set_add_fn(coDataSet, coData);
-    CheckStatus(status, nullptr);
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 
-    std::unique_ptr<CodeObj> pCodeObj(new (std::nothrow) CodeObj(buf, coData, coDataSet));
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
 
-    return pCodeObj;
-}
+    pMappedFile->m_hFile = hFile;
 
-std::unique_ptr<CodeObj>
-CodeObj::OpenBuffer(const std::vector<char>& buf, const amd_comgr_data_kind_t& dataKind)
-{
-    amd_comgr_data_t coData;
-    amd_comgr_data_set_t coDataSet;
-    amd_comgr_status_t status = AMD_COMGR_STATUS_ERROR;
+    LARGE_INTEGER fileSize;
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_fn(dataKind, &coData);
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_set_data_fn(coData, buf.size(), &buf[0]);
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_set_data_name_fn(coData, "data");
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&coDataSet);
-    CheckStatus(status, nullptr);
-    status = ComgrEntryPoints::Instance()->amd_comgr_data_set_add_fn(coDataSet, coData);
-    CheckStatus(status, nullptr);
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart <= 0 || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+    {
+        return nullptr;
+    }
 
-    std::unique_ptr<CodeObj> pCodeObj(new (std::nothrow) CodeObj(buf, coData, coDataSet));
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
 
-    return pCodeObj;
-}
+    if (hMapping == nullptr)
+    {
+        return nullptr;
+    }
 
-MDNode CodeObj::GetMD()
-{
-    amd_comgr_metadata_node_t md;
-    amd_comgr_status_t status;
-    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_metadata_fn(m_data, &md);
-    CheckStatus(status, 0);
-    // the root must be map
-    amd_comgr_metadata_kind_t kind = AMD_COMGR_METADATA_KIND_NULL;
-    status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_kind_fn(md, &kind);
-    CheckStatus(status, 0);
-    return (kind == AMD_COMGR_METADATA_KIND_MAP ? MDNode(md) : 0);
-}
+    pMappedFile->m_hMapping = hMapping;
+    pMappedFile->m_pData = static_cast<const char*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
 
+    if (pMappedFile->m_pData == nullptr)
+    {
+        return nullptr;
+    }
 
-bool CodeObj::ExtractSymbolData(CodeObjSymbolInfo& data)
-{
+    pMappedFile->m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = open(fileName.c_str(), O_RDONLY);
 
-    // scratch buffer to hold symbol info within callback over symbols
-    CodeObjSymbolIterState* iterState = (CodeObjSymbolIterState*)malloc(sizeof(CodeObjSymbolIterState));
-    if (iterState == nullptr)
+    if (fd < 0)
     {
-        return false;
+        return nullptr;
     }
-    memset(iterState, 0, sizeof(CodeObjSymbolIterState));
-    static const size_t s_SCRATCH_BUFER_SIZE = 1024;
-    iterState->m_scratchBuffersizeInBytes = s_SCRATCH_BUFER_SIZE;
-    iterState->m_pScratchBuffer = (char*)malloc(iterState->m_scratchBuffersizeInBytes);
-    if (iterState->m_pScratchBuffer == nullptr)
+
+    struct stat fileStat;
+
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0 || static_cast<uint64_t>(fileStat.st_size) > SIZE_MAX)
     {
-        return false;
+        close(fd);
+        return nullptr;
     }
 
-    bool retCode = false;
-    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_iterate_symbols_fn(
-        m_data,
-        countFuncSymbolCallback,
-        iterState);
-    CheckStatus(status, retCode);
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* pData = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
 
-    memset(iterState->m_pScratchBuffer, 0, iterState->m_scratchBuffersizeInBytes);
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
 
-    if (iterState->m_symbolCount > 0)
+    if (pData == MAP_FAILED)
     {
-        iterState->m_pCodeObjectSymbols = (CodeObjSymbol*)malloc(sizeof(CodeObjSymbol)*iterState->m_symbolCount);
-        if (iterState->m_pCodeObjectSymbols != nullptr)
-        {
-            status = ComgrEntryPoints::Instance()->amd_comgr_iterate_symbols_fn(
-                m_data,
-                appendToSymbolVectorCallback,
-                iterState);
-            CheckStatus(status, retCode);
-
-            if (status == AMD_COMGR_STATUS_SUCCESS)
-            {
-                data.m_numSymbols = iterState->m_symbolCount;
-                data.m_pSymbols = iterState->m_pCodeObjectSymbols;
-                retCode = true;
-            }
-        }
+        return nullptr;
     }
 
-    // Dont free iterState->m_pSymbols.
-    // The pointer to the symbols, it will be cleared when you call Clear symbol data
-    free(iterState->m_pScratchBuffer);
-    free(iterState);
+    pMappedFile->m_pData = static_cast<const char*>(pData);
+    pMappedFile->m_size = size;
+#endif
 
-    return retCode;
+    return pMappedFile;
 }
 
-void CodeObj::ClearSymbolData(CodeObjSymbolInfo& data)
+MappedFile::~MappedFile()
 {
-    if ((data.m_numSymbols > 0) && (data.m_pSymbols != nullptr))
+#ifdef _WIN32
+    if (m_pData != nullptr)
     {
-        for (uint32_t i = 0; i < data.m_numSymbols; ++i)
-        {
-            if (data.m_pSymbols[i].m_type == COMGR_UTILS_SYMBOL_TYPE_FUNC)
-            {
-                if (data.m_pSymbols[i].m_symbolFunction.m_pName != nullptr)
-                {
-                    free(data.m_pSymbols[i].m_symbolFunction.m_pName);
-                }
-            }
-        }
-        free(data.m_pSymbols);
-        data.m_numSymbols = 0;
+        UnmapViewOfFile(m_pData);
+    }
+
+    if (m_hMapping != nullptr)
+    {
+        CloseHandle(m_hMapping);
+    }
+
+    if (m_hFile != nullptr)
+    {
+        CloseHandle(m_hFile);
+    }
+#else
+    if (m_pData != nullptr)
+    {
+        munmap(const_cast<char*>(m_pData), m_size);
     }
+#endif
 }
 
-bool CodeObj::ExtractPalPipelineData(PalPipelineData& data)
+CodeObj::CodeObj(std::unique_ptr<MappedFile> pMappedFile, ComgrData&& coData, ComgrDataSet&& coDataSet) :
+    m_pMappedFile(std::move(pMappedFile)), m_pData(m_pMappedFile->GetData()), m_dataSize(m_pMappedFile->GetSize()), m_data(std::move(coData)), m_dataSet(std::move(coDataSet)),
+    m_symbolLookupBuilt(false), m_disassemblyInfo()
 {
-    MDNode md = GetMD();
+}
 
-    // Extract version.
-    GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINE_VERSION, md, version);
-    size_t versionEntries = version.size();
+CodeObj::~CodeObj()
+{
+    ReleaseDisassemblyInfo();
+}
 
-    if (versionEntries < 2)
+bool CodeObj::ReadFile(const std::string& fileName, std::vector<char>& buf)
+{
+    std::ifstream file(fileName, std::ios::in | std::ios::binary);
+
+    if (!file.is_open())
     {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to open file: " + fileName);
         return false;
     }
 
-    data.m_version.m_major = version[0].value<uint32_t>();
-    data.m_version.m_minor = version[1].value<uint32_t>();
-
-    // Extract Pipelines.
-    GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINES, md, pipelines);
-    size_t pipelinesNum = pipelines.size();
-    data.m_numPipelines = static_cast<uint32_t>(pipelinesNum);
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
 
-    data.m_pPipelines = (Pipeline*) malloc(pipelinesNum * sizeof(Pipeline));
-    if (nullptr == data.m_pPipelines)
+    if (size <= 0 || static_cast<uint64_t>(size) > SIZE_MAX)
     {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Invalid file size: " + fileName);
         return false;
     }
 
-    memset(data.m_pPipelines, 0, pipelinesNum * sizeof(Pipeline));
-    bool retCode = true;
+    buf.resize(static_cast<size_t>(size));
+    file.read(buf.data(), size);
 
-    for (size_t i = 0; i < pipelinesNum; i++)
+    if (!file)
     {
-        Pipeline* pPipelineData = &data.m_pPipelines[i];
-        MDNode ppln = pipelines[i];
-
-        // Name.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_PIPELINE_NAME, ppln))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINE_NAME, ppln, pplnName);
-            const std::string& name = pplnName.value<std::string>();
-            pPipelineData->m_pName = (char*)malloc(name.size() + 1);
-            if (nullptr == pPipelineData->m_pName)
-            {
-                retCode = false;
-                break;
-            }
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to read file: " + fileName);
+        return false;
+    }
 
-            memset(pPipelineData->m_pName, '\0', name.size() + 1);
-            strncpy_safe(pPipelineData->m_pName, name.c_str(), name.size() + 1, name.length() + 1);
-        }
+    return true;
+}
 
+bool CodeObj::CreateComgrData(const char* pBuf, size_t sizeInBytes, const amd_comgr_data_kind_t& dataKind, ComgrData& coData, ComgrDataSet& coDataSet)
+{
+    amd_comgr_status_t status = AMD_COMGR_STATUS_ERROR;
+    ComgrData data;
+    ComgrDataSet dataSet;
 
-        // Type. (Not supported yet)
-        //GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINE_TYPE, ppln, pplnType);
-        //pPipelineData->m_type = pplnType.int32Val();
-        // Hash.
-        GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINE_HASH, ppln, pplnHash);
-        pPipelineData->m_hash = pplnHash.value<uint64_t>();
-        // User Data Limit.
-        GetPalMDMapItemRequired(gs_PAL_MD_TAG_USER_DATA_LIMIT, ppln, userDataLimit);
-        pPipelineData->m_userDataLimit = userDataLimit.value<uint32_t>();
-        // Spill threshold.
-        GetPalMDMapItemRequired(gs_PAL_MD_TAG_SPILL_SHRESHOLD, ppln, spillThreashold);
-        pPipelineData->m_spillThreshold = spillThreashold.value<uint32_t>();
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_fn(dataKind, data.Receive());
+    CheckStatus(status, false);
+    status = ComgrEntryPoints::Instance()->amd_comgr_set_data_fn(data.Get(), sizeInBytes, pBuf);
+    CheckStatus(status, false);
+    status = ComgrEntryPoints::Instance()->amd_comgr_set_data_name_fn(data.Get(), "data");
+    CheckStatus(status, false);
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSet.Receive());
+    CheckStatus(status, false);
+    status = ComgrEntryPoints::Instance()->amd_comgr_data_set_add_fn(dataSet.Get(), data.Get());
+    CheckStatus(status, false);
 
-        // UsesViewportArrayIndex
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_USES_VIEWPORT_ARRAY_INDEX, ppln))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_USES_VIEWPORT_ARRAY_INDEX, ppln, viewportArrIndex);
-            pPipelineData->m_usesViewportArrayIndex = viewportArrIndex.value<uint32_t>();
-        }
+    coData = std::move(data);
+    coDataSet = std::move(dataSet);
+    return true;
+}
 
-        // EsGsLocalDataShareSize
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_ES_GS_LOCAL_DATA_SHARE_SIZE, ppln))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_ES_GS_LOCAL_DATA_SHARE_SIZE, ppln, esgsLocDataShareSize);
-            pPipelineData->m_esGsLocalDataShareSize = esgsLocDataShareSize.value<uint32_t>();
-        }
+std::unique_ptr<CodeObj>
+CodeObj::OpenFile(const std::string& fileName)
+{
+    return OpenFile(fileName, AMD_COMGR_DATA_KIND_RELOCATABLE);
+}
 
-        // Scratch Memory Size
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_SCRATCH_MEMORY_SIZE, ppln))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_SCRATCH_MEMORY_SIZE, ppln, scratchSize);
-            pPipelineData->m_scratchMemorySize = scratchSize.value<uint32_t>();
-        }
+std::unique_ptr<CodeObj>
+CodeObj::OpenFile(const std::string& fileName, const amd_comgr_data_kind_t& dataKind)
+{
+    std::vector<char> buf;
+
+    if (!ReadFile(fileName, buf))
+    {
+        return nullptr;
+    }
+
+    return OpenBuffer(std::move(buf), dataKind);
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenMapped(const std::string& fileName)
+{
+    return OpenMapped(fileName, AMD_COMGR_DATA_KIND_RELOCATABLE);
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenMapped(const std::string& fileName, const amd_comgr_data_kind_t& dataKind)
+{
+    std::unique_ptr<MappedFile> pMappedFile = MappedFile::Open(fileName);
+
+    if (pMappedFile == nullptr)
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to map file: " + fileName);
+        return nullptr;
+    }
+
+    ComgrData coData;
+    ComgrDataSet coDataSet;
+
+    if (!CreateComgrData(pMappedFile->GetData(), pMappedFile->GetSize(), dataKind, coData, coDataSet))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<CodeObj> pCodeObj(new (std::nothrow) CodeObj(std::move(pMappedFile), std::move(coData), std::move(coDataSet)));
+
+    return pCodeObj;
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBufferRaw(const char* pBuf, const size_t sizeInBytes)
+{
+    std::unique_ptr<CodeObj> retHandle = nullptr;
+
+    if (pBuf != nullptr && sizeInBytes > 0)
+    {
+        std::vector<char> buffer(pBuf, pBuf + sizeInBytes);
+        retHandle = OpenBuffer(std::move(buffer));
+    }
+
+    return retHandle;
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBufferView(const char* pBuf, size_t sizeInBytes)
+{
+    return OpenBufferView(pBuf, sizeInBytes, AMD_COMGR_DATA_KIND_RELOCATABLE);
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBufferView(const char* pBuf, size_t sizeInBytes, const amd_comgr_data_kind_t& dataKind)
+{
+    if (pBuf == nullptr || sizeInBytes == 0)
+    {
+        return nullptr;
+    }
+
+    ComgrData coData;
+    ComgrDataSet coDataSet;
+
+    if (!CreateComgrData(pBuf, sizeInBytes, dataKind, coData, coDataSet))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<CodeObj> pCodeObj(new (std::nothrow) CodeObj(pBuf, sizeInBytes, std::move(coData), std::move(coDataSet)));
+
+    return pCodeObj;
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBuffer(const std::vector<char>& buf)
+{
+    return OpenBuffer(buf, AMD_COMGR_DATA_KIND_RELOCATABLE);
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBuffer(const std::vector<char>& buf, const amd_comgr_data_kind_t& dataKind)
+{
+    ComgrData coData;
+    ComgrDataSet coDataSet;
+
+    if (!CreateComgrData(buf.data(), buf.size(), dataKind, coData, coDataSet))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<CodeObj> pCodeObj(new (std::nothrow) CodeObj(buf, std::move(coData), std::move(coDataSet)));
+
+    return pCodeObj;
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBuffer(std::vector<char>&& buf)
+{
+    return OpenBuffer(std::move(buf), AMD_COMGR_DATA_KIND_RELOCATABLE);
+}
+
+std::unique_ptr<CodeObj>
+CodeObj::OpenBuffer(std::vector<char>&& buf, const amd_comgr_data_kind_t& dataKind)
+{
+    ComgrData coData;
+    ComgrDataSet coDataSet;
+
+    if (!CreateComgrData(buf.data(), buf.size(), dataKind, coData, coDataSet))
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<CodeObj> pCodeObj(new (std::nothrow) CodeObj(std::move(buf), std::move(coData), std::move(coDataSet)));
+
+    return pCodeObj;
+}
+
+MDNode CodeObj::GetMD()
+{
+    ComgrMetadataNode md;
+    amd_comgr_status_t status;
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_metadata_fn(m_data.Get(), md.Receive());
+    CheckStatus(status, 0);
+    // the root must be map
+    amd_comgr_metadata_kind_t kind = AMD_COMGR_METADATA_KIND_NULL;
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_kind_fn(md.Get(), &kind);
+    CheckStatus(status, 0);
+    return (kind == AMD_COMGR_METADATA_KIND_MAP ? MDNode(md.Release()) : 0);
+}
+
+const MetadataSnapshot* CodeObj::GetMDSnapshot()
+{
+    if (m_pMDSnapshot == nullptr)
+    {
+        amd_comgr_metadata_node_t md;
+        amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_data_metadata_fn(m_data.Get(), &md);
+        CheckStatus(status, nullptr);
+
+        MDNode root(md);
+        std::unique_ptr<MetadataSnapshot> pSnapshot(new (std::nothrow) MetadataSnapshot);
+        bool retCode = (pSnapshot != nullptr) && pSnapshot->Build(root);
+
+        if (!retCode)
+        {
+            return nullptr;
+        }
+
+        m_pMDSnapshot = std::move(pSnapshot);
+    }
+
+    return m_pMDSnapshot.get();
+}
+
+
+bool CodeObj::ExtractSymbolData(CodeObjSymbolInfo& data)
+{
+    return ExtractSymbolData(data, COMGR_UTILS_PARSE_BACKEND_AUTO);
+}
+
+bool CodeObj::ExtractSymbolData(CodeObjSymbolInfo& data, CodeObjParseBackend backend)
+{
+    switch (backend)
+    {
+        case COMGR_UTILS_PARSE_BACKEND_NATIVE:
+            return ExtractSymbolDataNative(data, false);
+
+        case COMGR_UTILS_PARSE_BACKEND_COMGR:
+            return ExtractSymbolDataComgr(data);
+
+        case COMGR_UTILS_PARSE_BACKEND_AUTO:
+        default:
+            if (ExtractSymbolDataNative(data, true))
+            {
+                return true;
+            }
+
+            GetLastError();
+            return ExtractSymbolDataComgr(data);
+    }
+}
+
+bool CodeObj::ExtractSymbolDataUncopied(CodeObjSymbolInfo& data)
+{
+    if (ExtractSymbolDataNative(data, false))
+    {
+        return true;
+    }
+
+    GetLastError();
+    return ExtractSymbolDataComgr(data);
+}
+
+bool CodeObj::ExtractSymbolDataNative(CodeObjSymbolInfo& data, bool copyNames)
+{
+    ElfReader elf;
+
+    if (!elf.Init(m_pData, m_dataSize))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Code object is not an ELF64 file.");
+        return false;
+    }
+
+    Elf64SectionHeader symbolTable;
+    Elf64SectionHeader stringTable;
+    bool hasSymbolTable = false;
+
+    for (uint32_t i = 0; i < elf.GetNumSections() && !hasSymbolTable; ++i)
+    {
+        hasSymbolTable = elf.GetSection(i, symbolTable) && symbolTable.m_type == ELF_SHT_SYMTAB;
+    }
+
+    data.m_numSymbols = 0;
+    data.m_pSymbols = nullptr;
+    data.m_pNamePool = nullptr;
+    data.m_namesInCodeObj = !copyNames;
+
+    // A code object without a symbol table has no function symbols.
+    if (!hasSymbolTable)
+    {
+        return true;
+    }
+
+    const char* pSymbols = elf.GetSectionData(symbolTable);
+
+    if (pSymbols == nullptr || symbolTable.m_entsize != sizeof(Elf64Symbol) || !elf.GetSection(symbolTable.m_link, stringTable))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Invalid ELF symbol table.");
+        return false;
+    }
+
+    uint64_t numEntries = symbolTable.m_size / sizeof(Elf64Symbol);
+
+    if (numEntries > UINT32_MAX)
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Invalid ELF symbol table.");
+        return false;
+    }
+
+    // Sized for every entry so the table is walked once; the unused tail is trimmed below.
+    CodeObjSymbol* pCodeObjSymbols = (CodeObjSymbol*)malloc(static_cast<size_t>(numEntries) * sizeof(CodeObjSymbol));
+
+    if (pCodeObjSymbols == nullptr && numEntries > 0)
+    {
+        return false;
+    }
+
+    uint32_t numFuncSymbols = 0;
+    size_t namePoolSize = 0;
+
+    for (uint64_t i = 0; i < numEntries; ++i)
+    {
+        Elf64Symbol symbol;
+        memcpy(&symbol, pSymbols + i * sizeof(Elf64Symbol), sizeof(Elf64Symbol));
+
+        uint8_t type = symbol.m_info & 0xf;
+
+        if (type != ELF_STT_FUNC && type != ELF_STT_AMDGPU_HSA_KERNEL)
+        {
+            continue;
+        }
+
+        size_t nameLen = 0;
+        const char* pName = elf.GetString(stringTable, symbol.m_name, &nameLen);
+
+        if (pName == nullptr)
+        {
+            free(pCodeObjSymbols);
+            SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Invalid ELF symbol name.");
+            return false;
+        }
+
+        CodeObjSymbol* pFunctionSymbol = &pCodeObjSymbols[numFuncSymbols++];
+        pFunctionSymbol->m_type = COMGR_UTILS_SYMBOL_TYPE_FUNC;
+        pFunctionSymbol->m_symbolFunction.m_symbolSize = symbol.m_size;
+        pFunctionSymbol->m_symbolFunction.m_nameLen = nameLen;
+        pFunctionSymbol->m_symbolFunction.m_symbolValue = symbol.m_value;
+        pFunctionSymbol->m_symbolFunction.m_pName = const_cast<char*>(pName);
+        namePoolSize += nameLen + 1;
+    }
+
+    if (numFuncSymbols == 0)
+    {
+        free(pCodeObjSymbols);
+        return true;
+    }
+
+    if (copyNames)
+    {
+        // One allocation for all of the names, so they outlive the CodeObj like the comgr names.
+        char* pNamePool = (char*)malloc(namePoolSize);
+
+        if (pNamePool == nullptr)
+        {
+            free(pCodeObjSymbols);
+            return false;
+        }
+
+        char* pNextName = pNamePool;
+
+        for (uint32_t i = 0; i < numFuncSymbols; ++i)
+        {
+            CodeObjSymbolFunction& function = pCodeObjSymbols[i].m_symbolFunction;
+            memcpy(pNextName, function.m_pName, function.m_nameLen);
+            pNextName[function.m_nameLen] = '\0';
+            function.m_pName = pNextName;
+            pNextName += function.m_nameLen + 1;
+        }
+
+        data.m_pNamePool = pNamePool;
+        data.m_namesInCodeObj = false;
+    }
+
+    if (numFuncSymbols < numEntries)
+    {
+        CodeObjSymbol* pTrimmed = (CodeObjSymbol*)realloc(pCodeObjSymbols, numFuncSymbols * sizeof(CodeObjSymbol));
+
+        if (pTrimmed != nullptr)
+        {
+            pCodeObjSymbols = pTrimmed;
+        }
+    }
+
+    data.m_numSymbols = numFuncSymbols;
+    data.m_pSymbols = pCodeObjSymbols;
+    return true;
+}
+
+bool CodeObj::ExtractSymbolDataComgr(CodeObjSymbolInfo& data)
+{
+    data.m_numSymbols = 0;
+    data.m_pSymbols = nullptr;
+    data.m_pNamePool = nullptr;
+    data.m_namesInCodeObj = false;
+
+    // scratch buffer to hold symbol info within callback over symbols
+    CodeObjSymbolIterState iterState;
+    static const size_t s_SCRATCH_BUFER_SIZE = 1024;
+    iterState.m_scratchBuffersizeInBytes = s_SCRATCH_BUFER_SIZE;
+    iterState.m_pScratchBuffer = (char*)malloc(iterState.m_scratchBuffersizeInBytes);
+    if (iterState.m_pScratchBuffer == nullptr)
+    {
+        return false;
+    }
+
+    bool retCode = false;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_iterate_symbols_fn(
+        m_data.Get(),
+        countFuncSymbolCallback,
+        &iterState);
+
+    if (status != AMD_COMGR_STATUS_SUCCESS)
+    {
+        SetError(status);
+        free(iterState.m_pScratchBuffer);
+        return retCode;
+    }
+
+    memset(iterState.m_pScratchBuffer, 0, iterState.m_scratchBuffersizeInBytes);
+
+    // A code object without function symbols succeeds with none, like the native reader
+    retCode = (iterState.m_symbolCount == 0);
+
+    if (iterState.m_symbolCount > 0)
+    {
+        // One allocation for the symbols and one for all of their names
+        iterState.m_pCodeObjectSymbols = (CodeObjSymbol*)malloc(sizeof(CodeObjSymbol)*iterState.m_symbolCount);
+        iterState.m_pNamePool = (char*)malloc(iterState.m_namePoolSize);
+
+        if (iterState.m_pCodeObjectSymbols != nullptr && iterState.m_pNamePool != nullptr)
+        {
+            status = ComgrEntryPoints::Instance()->amd_comgr_iterate_symbols_fn(
+                m_data.Get(),
+                appendToSymbolVectorCallback,
+                &iterState);
+
+            if (status == AMD_COMGR_STATUS_SUCCESS)
+            {
+                data.m_numSymbols = iterState.m_currentPosition;
+                data.m_pSymbols = iterState.m_pCodeObjectSymbols;
+                data.m_pNamePool = iterState.m_pNamePool;
+                retCode = true;
+            }
+            else
+            {
+                SetError(status);
+            }
+        }
+
+        if (!retCode)
+        {
+            free(iterState.m_pCodeObjectSymbols);
+            free(iterState.m_pNamePool);
+        }
+    }
+
+    // Dont free iterState.m_pCodeObjectSymbols or iterState.m_pNamePool on success.
+    // They are owned by data now, and will be cleared when you call Clear symbol data
+    free(iterState.m_pScratchBuffer);
+
+    return retCode;
+}
+
+bool CodeObj::FindSymbol(const std::string& name, CodeObjSymbol& symbol)
+{
+    if (!m_symbolLookupBuilt)
+    {
+        CodeObjSymbolInfo symbolData;
+
+        if (ExtractSymbolDataUncopied(symbolData))
+        {
+            m_lookupSymbols.reserve(symbolData.m_numSymbols);
+
+            for (uint32_t i = 0; i < symbolData.m_numSymbols; ++i)
+            {
+                // Point at the interned copy so the name outlives symbolData
+                CodeObjSymbol lookupSymbol = symbolData.m_pSymbols[i];
+                CodeObjSymbolFunction& function = lookupSymbol.m_symbolFunction;
+                function.m_pName = const_cast<char*>(m_symbolNameIndex.Insert(function.m_pName, static_cast<size_t>(function.m_nameLen), i));
+                m_lookupSymbols.push_back(lookupSymbol);
+            }
+        }
+
+        ClearSymbolData(symbolData);
+        GetLastError();
+        m_symbolLookupBuilt = true;
+    }
+
+    uint32_t index = m_symbolNameIndex.Find(name);
+
+    if (index != SymbolNameIndex::s_INVALID_SYMBOL_INDEX)
+    {
+        symbol = m_lookupSymbols[index];
+        return true;
+    }
+
+    // Not a function symbol of the symbol table, ask comgr
+    amd_comgr_symbol_t comgrSymbol;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_symbol_lookup_fn(m_data.Get(), name.c_str(), &comgrSymbol);
+    CheckStatus(status, false);
+
+    amd_comgr_symbol_type_t type = AMD_COMGR_SYMBOL_TYPE_NOTYPE;
+    status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(comgrSymbol, AMD_COMGR_SYMBOL_INFO_TYPE, &type);
+    CheckStatus(status, false);
+
+    if (!IsFunctionSymbolType(type))
+    {
+        return false;
+    }
+
+    CodeObjSymbol found;
+    found.m_type = COMGR_UTILS_SYMBOL_TYPE_FUNC;
+    found.m_symbolFunction.m_nameLen = name.size();
+
+    status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(comgrSymbol, AMD_COMGR_SYMBOL_INFO_SIZE, &found.m_symbolFunction.m_symbolSize);
+    CheckStatus(status, false);
+
+    status = ComgrEntryPoints::Instance()->amd_comgr_symbol_get_info_fn(comgrSymbol, AMD_COMGR_SYMBOL_INFO_VALUE, &found.m_symbolFunction.m_symbolValue);
+    CheckStatus(status, false);
+
+    found.m_symbolFunction.m_pName = const_cast<char*>(m_symbolNameIndex.Insert(name.data(), name.size(), static_cast<uint32_t>(m_lookupSymbols.size())));
+    m_lookupSymbols.push_back(found);
+
+    symbol = found;
+    return true;
+}
+
+void CodeObj::ClearSymbolData(CodeObjSymbolInfo& data)
+{
+    // The names live in the name pool or in the code object, never in separate allocations
+    free(data.m_pSymbols);
+    free(data.m_pNamePool);
+    data.m_numSymbols = 0;
+    data.m_pSymbols = nullptr;
+    data.m_pNamePool = nullptr;
+    data.m_namesInCodeObj = false;
+}
+
+bool CodeObj::ExtractPalPipelineData(PalPipelineData& data)
+{
+    return ExtractPalPipelineData(data, COMGR_UTILS_PARSE_BACKEND_AUTO);
+}
+
+bool CodeObj::ExtractPalPipelineData(PalPipelineData& data, CodeObjParseBackend backend)
+{
+    return ExtractPalPipelineData(data, backend, COMGR_UTILS_PAL_LAYOUT_SEPARATE);
+}
+
+// Owner name and type of the note that holds the MsgPack encoded PAL metadata
+static const char*    s_AMDGPU_NOTE_NAME        = "AMDGPU";
+static const uint32_t s_NT_AMDGPU_METADATA      = 32;
+
+// Size of the first arena chunk when the size of the metadata is not known
+static const size_t s_PAL_ARENA_DEFAULT_SIZE = 16 * 1024;
+
+// Header of one arena chunk. PalPipelineData::m_pArena points at the newest chunk,
+// which links back to the chunks allocated before it.
+struct PalArenaChunk
+{
+    PalArenaChunk*  m_pPrev;    // The previously allocated chunk, nullptr for the first one
+    size_t          m_size;     // Usable bytes following the header
+    size_t          m_used;     // Bytes handed out so far
+};
+
+// Allocates the arrays and strings of PalPipelineData, either one malloc each or out of an arena.
+// All memory is zero initialized and is released by CodeObj::ClearPalPipelineData.
+class PalDataAllocator
+{
+public:
+    // sizeHint is the expected total size of the data, used to size the first arena chunk
+    PalDataAllocator(PalPipelineData& data, PalPipelineDataLayout layout, size_t sizeHint) :
+        m_data(data), m_layout(layout), m_nextChunkSize(sizeHint > 0 ? sizeHint : s_PAL_ARENA_DEFAULT_SIZE) {}
+
+    void* Alloc(size_t size)
+    {
+        void* pMemory = nullptr;
+
+        if (m_layout == COMGR_UTILS_PAL_LAYOUT_ARENA)
+        {
+            static const size_t s_ALIGNMENT = alignof(std::max_align_t);
+            size = (size + s_ALIGNMENT - 1) & ~(s_ALIGNMENT - 1);
+            PalArenaChunk* pChunk = static_cast<PalArenaChunk*>(m_data.m_pArena);
+
+            if (pChunk == nullptr || pChunk->m_size - pChunk->m_used < size)
+            {
+                // Chunks grow geometrically so a bad size hint costs few extra allocations
+                size_t chunkSize = std::max(m_nextChunkSize, size);
+                PalArenaChunk* pNewChunk = (PalArenaChunk*)malloc(s_CHUNK_HEADER_SIZE + chunkSize);
+
+                if (pNewChunk == nullptr)
+                {
+                    return nullptr;
+                }
+
+                pNewChunk->m_pPrev = pChunk;
+                pNewChunk->m_size = chunkSize;
+                pNewChunk->m_used = 0;
+                m_data.m_pArena = pNewChunk;
+                m_nextChunkSize = 2 * chunkSize;
+                pChunk = pNewChunk;
+            }
+
+            pMemory = reinterpret_cast<char*>(pChunk) + s_CHUNK_HEADER_SIZE + pChunk->m_used;
+            pChunk->m_used += size;
+        }
+        else
+        {
+            pMemory = malloc(size);
+        }
+
+        if (pMemory != nullptr)
+        {
+            memset(pMemory, 0, size);
+        }
+
+        return pMemory;
+    }
+
+    char* AllocString(const char* pString, size_t length)
+    {
+        char* pCopy = static_cast<char*>(Alloc(length + 1));
+
+        if (pCopy != nullptr)
+        {
+            memcpy(pCopy, pString, length);
+        }
+
+        return pCopy;
+    }
+
+    // Arena memory is only released with the whole arena
+    void Free(void* pMemory)
+    {
+        if (m_layout != COMGR_UTILS_PAL_LAYOUT_ARENA)
+        {
+            free(pMemory);
+        }
+    }
+
+private:
+    static const size_t s_CHUNK_HEADER_SIZE = (sizeof(PalArenaChunk) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    PalPipelineData&        m_data;             // The data owning the arena
+    PalPipelineDataLayout   m_layout;           // The memory layout
+    size_t                  m_nextChunkSize;    // Size of the next arena chunk
+};
+
+bool CodeObj::ExtractPalPipelineData(PalPipelineData& data, CodeObjParseBackend backend, PalPipelineDataLayout layout)
+{
+    // The decoded data is close to the size of its MsgPack encoding, so the note size makes a good arena size.
+    size_t sizeHint = 0;
+
+    if (layout == COMGR_UTILS_PAL_LAYOUT_ARENA)
+    {
+        ElfReader elf;
+        const uint8_t* pNote = nullptr;
+        size_t noteSize = 0;
+
+        if (elf.Init(m_pData, m_dataSize) && elf.FindNote(s_AMDGPU_NOTE_NAME, s_NT_AMDGPU_METADATA, pNote, noteSize))
+        {
+            sizeHint = noteSize + noteSize / 2;
+        }
+    }
+
+    PalDataAllocator allocator(data, layout, sizeHint);
+    bool retCode = false;
+
+    switch (backend)
+    {
+        case COMGR_UTILS_PARSE_BACKEND_NATIVE:
+            retCode = ExtractPalPipelineDataNative(data, allocator);
+            break;
+
+        case COMGR_UTILS_PARSE_BACKEND_COMGR:
+            retCode = ExtractPalPipelineDataComgr(data, allocator);
+            break;
+
+        case COMGR_UTILS_PARSE_BACKEND_AUTO:
+        default:
+            retCode = ExtractPalPipelineDataNative(data, allocator);
+
+            if (!retCode)
+            {
+                ClearPalPipelineData(data);
+                GetLastError();
+
+                PalDataAllocator comgrAllocator(data, layout, sizeHint);
+                retCode = ExtractPalPipelineDataComgr(data, comgrAllocator);
+            }
+
+            break;
+    }
+
+    return retCode;
+}
+
+// Map a shader key of the ".shaders" map to its API shader type, leaving the type unchanged for other tags
+static bool GetShaderInfoType(PalMDTag tag, ShaderInfoType& shaderType)
+{
+    switch (tag)
+    {
+        case PalMDTag::SHADER_TYPE_VERTEX:      shaderType = ShaderInfoType::VERTEX_SHADER;     return true;
+        case PalMDTag::SHADER_TYPE_HULL:        shaderType = ShaderInfoType::HULL_SHADER;       return true;
+        case PalMDTag::SHADER_TYPE_DOMAIN:      shaderType = ShaderInfoType::DOMAIN_SHADER;     return true;
+        case PalMDTag::SHADER_TYPE_GEOMETRY:    shaderType = ShaderInfoType::GEOMETRY_SHADER;   return true;
+        case PalMDTag::SHADER_TYPE_PIXEL:       shaderType = ShaderInfoType::PIXEL_SHADER;      return true;
+        case PalMDTag::SHADER_TYPE_COMPUTE:     shaderType = ShaderInfoType::COMPUTE_SHADER;    return true;
+        default:                                return false;
+    }
+}
+
+// Map a stage key of the ".hardware_stages" map to its hardware stage type, leaving the type unchanged for other tags
+static bool GetHwStageType(PalMDTag tag, HwStageType& stageType)
+{
+    switch (tag)
+    {
+        case PalMDTag::HARDWARE_STAGE_LS:   stageType = HwStageType::LS;    return true;
+        case PalMDTag::HARDWARE_STAGE_HS:   stageType = HwStageType::HS;    return true;
+        case PalMDTag::HARDWARE_STAGE_ES:   stageType = HwStageType::ES;    return true;
+        case PalMDTag::HARDWARE_STAGE_GS:   stageType = HwStageType::GS;    return true;
+        case PalMDTag::HARDWARE_STAGE_PS:   stageType = HwStageType::PS;    return true;
+        case PalMDTag::HARDWARE_STAGE_VS:   stageType = HwStageType::VS;    return true;
+        case PalMDTag::HARDWARE_STAGE_CS:   stageType = HwStageType::CS;    return true;
+        default:                            return false;
+    }
+}
+
+// Decode a numeric metadata value. Values of any other kind are skipped and read as 0,
+// the same as MDNode::value() does for non-scalar nodes.
+static bool DecodePalMDUInt(MsgPackReader& reader, uint64_t& value)
+{
+    value = 0;
+    return reader.ReadUInt(value) || reader.Skip();
+}
+
+static bool DecodePalMDUInt(MsgPackReader& reader, uint32_t& value)
+{
+    uint64_t value64 = 0;
+    bool retCode = DecodePalMDUInt(reader, value64);
+    value = static_cast<uint32_t>(value64);
+    return retCode;
+}
+
+// Decode a string metadata value into a null terminated copy.
+// Values of any other kind are skipped and read as an empty string.
+static bool DecodePalMDString(MsgPackReader& reader, PalDataAllocator& allocator, char*& pString)
+{
+    const char* pValue = "";
+    uint32_t length = 0;
+
+    if (!reader.ReadString(pValue, length) && !reader.Skip())
+    {
+        return false;
+    }
+
+    pString = allocator.AllocString(pValue, length);
+    return nullptr != pString;
+}
+
+static bool DecodePalMDShaders(MsgPackReader& reader, PalDataAllocator& allocator, Pipeline& pipeline)
+{
+    uint32_t shadersNum = 0;
+
+    if (!reader.ReadMap(shadersNum))
+    {
+        return false;
+    }
+
+    if (shadersNum > 0)
+    {
+        pipeline.m_pShaderList = (ShaderInfo*)allocator.Alloc(shadersNum * sizeof(ShaderInfo));
+
+        if (nullptr == pipeline.m_pShaderList)
+        {
+            return false;
+        }
+    }
+
+    pipeline.m_numShaders = shadersNum;
+
+    for (uint32_t shaderN = 0; shaderN < shadersNum; ++shaderN)
+    {
+        ShaderInfo* pShaderInfoData = &pipeline.m_pShaderList[shaderN];
+        const char* pKey = nullptr;
+        uint32_t keyLen = 0;
+
+        if (!reader.ReadString(pKey, keyLen))
+        {
+            return false;
+        }
+
+        GetShaderInfoType(LookupPalMDTag(pKey, keyLen), pShaderInfoData->m_shaderType);
+
+        uint32_t numEntries = 0;
+
+        if (!reader.ReadMap(numEntries))
+        {
+            return false;
+        }
+
+        bool hasHwMapping = false;
+
+        for (uint32_t i = 0; i < numEntries; ++i)
+        {
+            bool ok = reader.ReadString(pKey, keyLen);
+
+            if (ok && LookupPalMDTag(pKey, keyLen) == PalMDTag::SHADER_HARDWARE_MAPPING)
+            {
+                hasHwMapping = true;
+                ok = DecodePalMDUInt(reader, pShaderInfoData->m_hardwareMapping);
+            }
+            else
+            {
+                ok = (ok || reader.Skip()) && reader.Skip();
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        if (!hasHwMapping)
+        {
+            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to get required MD value:shaderHwMapping");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool DecodePalMDHardwareStage(MsgPackReader& reader, PalDataAllocator& allocator, HWStageInfo& stage)
+{
+    uint32_t numEntries = 0;
+
+    if (!reader.ReadMap(numEntries))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numEntries; ++i)
+    {
+        const char* pKey = nullptr;
+        uint32_t keyLen = 0;
+        bool ok = true;
+
+        if (!reader.ReadString(pKey, keyLen))
+        {
+            ok = reader.Skip() && reader.Skip();
+        }
+        else
+        {
+            switch (LookupPalMDTag(pKey, keyLen))
+            {
+                case PalMDTag::ENTRY_POINT_SYMBOL_NAME:
+                    allocator.Free(stage.m_pEntryPointSymbolName);
+                    stage.m_pEntryPointSymbolName = nullptr;
+                    ok = DecodePalMDString(reader, allocator, stage.m_pEntryPointSymbolName);
+                    break;
+
+                case PalMDTag::SCRATCH_MEMORY_SIZE:
+                    ok = DecodePalMDUInt(reader, stage.m_scratchMemorySize);
+                    break;
+
+                case PalMDTag::LOCAL_DATA_SHARE_SIZE:
+                    ok = DecodePalMDUInt(reader, stage.m_localDataShareSize);
+                    break;
+
+                case PalMDTag::PERF_DATA_BUFFER_SIZE:
+                    ok = DecodePalMDUInt(reader, stage.m_performanceDataBufferSize);
+                    break;
+
+                case PalMDTag::NUM_USED_VGPRS:
+                    ok = DecodePalMDUInt(reader, stage.m_numUsedVgprs);
+                    break;
+
+                case PalMDTag::NUM_USED_SGPRS:
+                    ok = DecodePalMDUInt(reader, stage.m_numUsedSgprs);
+                    break;
+
+                case PalMDTag::NUM_AVAILABLE_VGPRS:
+                    ok = DecodePalMDUInt(reader, stage.m_numAvailableVgprs);
+                    break;
+
+                case PalMDTag::NUM_AVAILABLE_SGPRS:
+                    ok = DecodePalMDUInt(reader, stage.m_numAvailableSgprs);
+                    break;
+
+                case PalMDTag::WAVES_PER_GROUP:
+                    ok = DecodePalMDUInt(reader, stage.m_wavesPerGroup);
+                    break;
+
+                case PalMDTag::USES_UAVS:
+                    ok = DecodePalMDUInt(reader, stage.m_usesUavs);
+                    break;
+
+                case PalMDTag::USES_ROVS:
+                    ok = DecodePalMDUInt(reader, stage.m_usesRovs);
+                    break;
+
+                case PalMDTag::WRITES_UAVS:
+                    ok = DecodePalMDUInt(reader, stage.m_writesUavs);
+                    break;
+
+                case PalMDTag::WRITES_DEPTH:
+                    ok = DecodePalMDUInt(reader, stage.m_writesDepth);
+                    break;
+
+                case PalMDTag::MAX_PRIMS_PER_PS_WAVE:
+                    ok = DecodePalMDUInt(reader, stage.m_maxPrimsPerPsWave);
+                    break;
+
+                case PalMDTag::NUM_INTERPOLANTS:
+                    ok = DecodePalMDUInt(reader, stage.m_numInterpolants);
+                    break;
+
+                default:
+                    ok = reader.Skip();
+                    break;
+            }
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    if (nullptr == stage.m_pEntryPointSymbolName)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to get required MD value:entryName");
+        return false;
+    }
+
+    return true;
+}
+
+static bool DecodePalMDHardwareStages(MsgPackReader& reader, PalDataAllocator& allocator, Pipeline& pipeline)
+{
+    uint32_t stagesNum = 0;
+
+    if (!reader.ReadMap(stagesNum))
+    {
+        return false;
+    }
+
+    if (stagesNum > 0)
+    {
+        pipeline.m_pStageList = (HWStageInfo*)allocator.Alloc(stagesNum * sizeof(HWStageInfo));
+
+        if (nullptr == pipeline.m_pStageList)
+        {
+            return false;
+        }
+    }
+
+    pipeline.m_numStages = stagesNum;
+
+    for (uint32_t stageN = 0; stageN < stagesNum; ++stageN)
+    {
+        HWStageInfo* pStageInfoData = &pipeline.m_pStageList[stageN];
+        const char* pKey = nullptr;
+        uint32_t keyLen = 0;
+
+        if (!reader.ReadString(pKey, keyLen))
+        {
+            return false;
+        }
+
+        GetHwStageType(LookupPalMDTag(pKey, keyLen), pStageInfoData->m_stageType);
+
+        if (!DecodePalMDHardwareStage(reader, allocator, *pStageInfoData))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool DecodePalMDRegisters(MsgPackReader& reader, PalDataAllocator& allocator, Pipeline& pipeline)
+{
+    uint32_t regsNum = 0;
+
+    if (!reader.ReadMap(regsNum))
+    {
+        return false;
+    }
+
+    if (regsNum > 0)
+    {
+        pipeline.m_pRegisterDataList = (RegisterData*)allocator.Alloc(regsNum * sizeof(RegisterData));
+
+        if (nullptr == pipeline.m_pRegisterDataList)
+        {
+            return false;
+        }
+    }
+
+    pipeline.m_numRegisterWrites = regsNum;
+
+    for (uint32_t regN = 0; regN < regsNum; ++regN)
+    {
+        RegisterData* pRegData = &pipeline.m_pRegisterDataList[regN];
+        uint64_t address = 0;
+
+        if (!reader.ReadUInt(address) || !DecodePalMDUInt(reader, pRegData->m_data))
+        {
+            return false;
+        }
+
+        pRegData->m_address = static_cast<uint32_t>(address);
+    }
+
+    return true;
+}
+
+static bool DecodePalMDPipeline(MsgPackReader& reader, PalDataAllocator& allocator, Pipeline& pipeline)
+{
+    uint32_t numEntries = 0;
+
+    if (!reader.ReadMap(numEntries))
+    {
+        return false;
+    }
+
+    bool hasHash = false;
+    bool hasUserDataLimit = false;
+    bool hasSpillThreshold = false;
+    bool hasShaders = false;
+    bool hasStages = false;
+    bool hasRegisters = false;
+
+    for (uint32_t i = 0; i < numEntries; ++i)
+    {
+        const char* pKey = nullptr;
+        uint32_t keyLen = 0;
+        bool ok = true;
+
+        if (!reader.ReadString(pKey, keyLen))
+        {
+            ok = reader.Skip() && reader.Skip();
+        }
+        else
+        {
+            switch (LookupPalMDTag(pKey, keyLen))
+            {
+                case PalMDTag::PIPELINE_NAME:
+                    allocator.Free(pipeline.m_pName);
+                    pipeline.m_pName = nullptr;
+                    ok = DecodePalMDString(reader, allocator, pipeline.m_pName);
+                    break;
+
+                case PalMDTag::PIPELINE_HASH:
+                {
+                    // The compiler hash is a list of 64 bit words, the first word is used.
+                    uint32_t numWords = 0;
+                    hasHash = true;
+
+                    if (reader.ReadArray(numWords))
+                    {
+                        for (uint32_t word = 0; ok && word < numWords; ++word)
+                        {
+                            ok = (word == 0 ? DecodePalMDUInt(reader, pipeline.m_hash) : reader.Skip());
+                        }
+                    }
+                    else
+                    {
+                        ok = DecodePalMDUInt(reader, pipeline.m_hash);
+                    }
+
+                    break;
+                }
+
+                case PalMDTag::USER_DATA_LIMIT:
+                    hasUserDataLimit = true;
+                    ok = DecodePalMDUInt(reader, pipeline.m_userDataLimit);
+                    break;
+
+                case PalMDTag::SPILL_SHRESHOLD:
+                    hasSpillThreshold = true;
+                    ok = DecodePalMDUInt(reader, pipeline.m_spillThreshold);
+                    break;
+
+                case PalMDTag::USES_VIEWPORT_ARRAY_INDEX:
+                    ok = DecodePalMDUInt(reader, pipeline.m_usesViewportArrayIndex);
+                    break;
+
+                case PalMDTag::ES_GS_LOCAL_DATA_SHARE_SIZE:
+                    ok = DecodePalMDUInt(reader, pipeline.m_esGsLocalDataShareSize);
+                    break;
+
+                case PalMDTag::SCRATCH_MEMORY_SIZE:
+                    ok = DecodePalMDUInt(reader, pipeline.m_scratchMemorySize);
+                    break;
+
+                case PalMDTag::WAVEFRONT_SIZE:
+                    ok = DecodePalMDUInt(reader, pipeline.m_wavefrontSize);
+                    break;
+
+                case PalMDTag::API:
+                    ok = DecodePalMDUInt(reader, pipeline.m_api);
+                    break;
+
+                case PalMDTag::API_CREATE_INFO:
+                    ok = DecodePalMDUInt(reader, pipeline.m_apiCreateInfo);
+                    break;
+
+                case PalMDTag::SHADERS:
+                    ok = hasShaders ? reader.Skip() : DecodePalMDShaders(reader, allocator, pipeline);
+                    hasShaders = true;
+                    break;
+
+                case PalMDTag::HARDWARE_STAGES:
+                    ok = hasStages ? reader.Skip() : DecodePalMDHardwareStages(reader, allocator, pipeline);
+                    hasStages = true;
+                    break;
+
+                case PalMDTag::REGISTERS:
+                    ok = hasRegisters ? reader.Skip() : DecodePalMDRegisters(reader, allocator, pipeline);
+                    hasRegisters = true;
+                    break;
+
+                default:
+                    ok = reader.Skip();
+                    break;
+            }
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    if (!hasHash || !hasUserDataLimit || !hasSpillThreshold || !hasShaders || !hasStages || !hasRegisters)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to get required MD value");
+        return false;
+    }
+
+    return true;
+}
+
+bool CodeObj::ExtractPalPipelineDataNative(PalPipelineData& data, PalDataAllocator& allocator)
+{
+    ElfReader elf;
+    const uint8_t* pNote = nullptr;
+    size_t noteSize = 0;
+
+    if (!elf.Init(m_pData, m_dataSize) || !elf.FindNote(s_AMDGPU_NOTE_NAME, s_NT_AMDGPU_METADATA, pNote, noteSize))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: No PAL metadata note found.");
+        return false;
+    }
+
+    // Single forward pass over the MsgPack document.
+    MsgPackReader reader(pNote, noteSize);
+    uint32_t numEntries = 0;
+
+    if (!reader.ReadMap(numEntries))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Invalid PAL metadata.");
+        return false;
+    }
+
+    bool hasVersion = false;
+    bool hasPipelines = false;
+
+    for (uint32_t i = 0; i < numEntries; ++i)
+    {
+        const char* pKey = nullptr;
+        uint32_t keyLen = 0;
+        bool ok = true;
+
+        if (!reader.ReadString(pKey, keyLen))
+        {
+            ok = reader.Skip() && reader.Skip();
+        }
+        else if (LookupPalMDTag(pKey, keyLen) == PalMDTag::PIPELINE_VERSION)
+        {
+            uint32_t versionEntries = 0;
+            ok = reader.ReadArray(versionEntries) && versionEntries >= 2 &&
+                 DecodePalMDUInt(reader, data.m_version.m_major) &&
+                 DecodePalMDUInt(reader, data.m_version.m_minor);
+
+            for (uint32_t entry = 2; ok && entry < versionEntries; ++entry)
+            {
+                ok = reader.Skip();
+            }
+
+            hasVersion = ok;
+        }
+        else if (LookupPalMDTag(pKey, keyLen) == PalMDTag::PIPELINES && !hasPipelines)
+        {
+            uint32_t pipelinesNum = 0;
+            ok = reader.ReadArray(pipelinesNum);
+
+            if (ok && pipelinesNum > 0)
+            {
+                data.m_pPipelines = (Pipeline*)allocator.Alloc(pipelinesNum * sizeof(Pipeline));
+                ok = (nullptr != data.m_pPipelines);
+
+                if (ok)
+                {
+                    data.m_numPipelines = pipelinesNum;
+                }
+            }
+
+            for (uint32_t pplnN = 0; ok && pplnN < pipelinesNum; ++pplnN)
+            {
+                ok = DecodePalMDPipeline(reader, allocator, data.m_pPipelines[pplnN]);
+            }
+
+            hasPipelines = ok;
+        }
+        else
+        {
+            ok = reader.Skip();
+        }
+
+        if (!ok)
+        {
+            SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Invalid PAL metadata.");
+            return false;
+        }
+    }
+
+    if (!hasVersion || !hasPipelines)
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to get required MD value");
+        return false;
+    }
 
-        // Wavefront Size
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_WAVEFRONT_SIZE, ppln))
+    return true;
+}
+
+// Fields of one pipeline collected in a single pass over its metadata map
+struct PalMDPipelineVisitState
+{
+    Pipeline*           m_pPipeline;            // The pipeline being filled
+    PalDataAllocator*   m_pAllocator;           // Allocator of the pipeline strings
+    MDNode              m_shaders;              // The ".shaders" map, invalid if missing
+    MDNode              m_stages;               // The ".hardware_stages" map, invalid if missing
+    MDNode              m_registers;            // The ".registers" map, invalid if missing
+    bool                m_hasHash;              // True if the required hash was found
+    bool                m_hasUserDataLimit;     // True if the required user data limit was found
+    bool                m_hasSpillThreshold;    // True if the required spill threshold was found
+    PalMDPipelineVisitState(Pipeline& pipeline, PalDataAllocator& allocator) : m_pPipeline(&pipeline), m_pAllocator(&allocator),
+        m_shaders(0), m_stages(0), m_registers(0), m_hasHash(false), m_hasUserDataLimit(false), m_hasSpillThreshold(false) {}
+};
+
+// Copy a metadata string into the pipeline data, reading it through the string view of the node
+static char* AllocPalMDString(const MDNode& node, PalDataAllocator& allocator)
+{
+    // Values that are not strings are stored as empty strings.
+    MDStringView view = {"", 0};
+
+    if (!node.GetStringView(view))
+    {
+        view.m_pData = "";
+        view.m_size = 0;
+    }
+
+    return allocator.AllocString(view.m_pData, view.m_size);
+}
+
+// MDNode::VisitMap callback storing one field of a pipeline map
+static bool VisitPalMDPipelineField(PalMDTag tag, const char* pKey, size_t keyLen, MDNode& val, void* pUserData)
+{
+    COMGRUTILS_UNUSED(pKey);
+    COMGRUTILS_UNUSED(keyLen);
+    PalMDPipelineVisitState* pState = static_cast<PalMDPipelineVisitState*>(pUserData);
+    Pipeline& pipeline = *pState->m_pPipeline;
+
+    switch (tag)
+    {
+        case PalMDTag::PIPELINE_NAME:
+            pipeline.m_pName = AllocPalMDString(val, *pState->m_pAllocator);
+            return pipeline.m_pName != nullptr;
+
+        case PalMDTag::PIPELINE_HASH:
+            // The compiler hash is a list of 64 bit words, the first word is used.
+            pipeline.m_hash = (val.GetKind() == MDNode::Kind::List ? val[0].value<uint64_t>() : val.value<uint64_t>());
+            pState->m_hasHash = true;
+            break;
+
+        case PalMDTag::USER_DATA_LIMIT:
+            pipeline.m_userDataLimit = val.value<uint32_t>();
+            pState->m_hasUserDataLimit = true;
+            break;
+
+        case PalMDTag::SPILL_SHRESHOLD:
+            pipeline.m_spillThreshold = val.value<uint32_t>();
+            pState->m_hasSpillThreshold = true;
+            break;
+
+        case PalMDTag::USES_VIEWPORT_ARRAY_INDEX:
+            pipeline.m_usesViewportArrayIndex = val.value<uint32_t>();
+            break;
+
+        case PalMDTag::ES_GS_LOCAL_DATA_SHARE_SIZE:
+            pipeline.m_esGsLocalDataShareSize = val.value<uint32_t>();
+            break;
+
+        case PalMDTag::SCRATCH_MEMORY_SIZE:
+            pipeline.m_scratchMemorySize = val.value<uint32_t>();
+            break;
+
+        case PalMDTag::WAVEFRONT_SIZE:
+            pipeline.m_wavefrontSize = val.value<uint32_t>();
+            break;
+
+        case PalMDTag::API:
+            pipeline.m_api = val.value<uint32_t>();
+            break;
+
+        case PalMDTag::API_CREATE_INFO:
+            pipeline.m_apiCreateInfo = val.value<uint32_t>();
+            break;
+
+        case PalMDTag::SHADERS:
+            pState->m_shaders = std::move(val);
+            break;
+
+        case PalMDTag::HARDWARE_STAGES:
+            pState->m_stages = std::move(val);
+            break;
+
+        case PalMDTag::REGISTERS:
+            pState->m_registers = std::move(val);
+            break;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
+bool CodeObj::ExtractPalPipelineDataComgr(PalPipelineData& data, PalDataAllocator& allocator)
+{
+    MDNode md = GetMD();
+
+    // Extract version.
+    GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINE_VERSION, md, version);
+    size_t versionEntries = version.size();
+
+    if (versionEntries < 2)
+    {
+        return false;
+    }
+
+    data.m_version.m_major = version[0].value<uint32_t>();
+    data.m_version.m_minor = version[1].value<uint32_t>();
+
+    // Extract Pipelines.
+    GetPalMDMapItemRequired(gs_PAL_MD_TAG_PIPELINES, md, pipelines);
+    size_t pipelinesNum = pipelines.size();
+    data.m_numPipelines = static_cast<uint32_t>(pipelinesNum);
+
+    data.m_pPipelines = (Pipeline*)allocator.Alloc(pipelinesNum * sizeof(Pipeline));
+    if (nullptr == data.m_pPipelines)
+    {
+        return false;
+    }
+    bool retCode = true;
+
+    for (size_t i = 0; i < pipelinesNum; i++)
+    {
+        Pipeline* pPipelineData = &data.m_pPipelines[i];
+        MDNode ppln = pipelines[i];
+
+        // Collect all the pipeline fields in one pass over the map.
+        PalMDPipelineVisitState state(*pPipelineData, allocator);
+
+        if (!ppln.VisitMap(VisitPalMDPipelineField, &state))
+        {
+            retCode = false;
+            break;
+        }
+
+        // Type. (Not supported yet)
+        //pPipelineData->m_type = ...
+        const char* pMissingTag = (!state.m_hasHash ? gs_PAL_MD_TAG_PIPELINE_HASH :
+                                   !state.m_hasUserDataLimit ? gs_PAL_MD_TAG_USER_DATA_LIMIT :
+                                   !state.m_hasSpillThreshold ? gs_PAL_MD_TAG_SPILL_SHRESHOLD : nullptr);
+
+        if (pMissingTag != nullptr)
+        {
+            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, std::string("ERROR: Failed to get required MD value:") + pMissingTag);
+            return false;
+        }
+
+        // Extract Shaders Info.
+        if (!ExtractPalMDShadersInfo(*pPipelineData, state.m_shaders, allocator))
+        {
+            retCode = false;
+        }
+
+        // Extract hardware stages.
+        if (!ExtractPalMDHardwareStages(*pPipelineData, state.m_stages, allocator))
+        {
+            retCode = false;
+        }
+
+        // Extract register info.
+        if (!ExtractPalMDRegisterInfo(*pPipelineData, state.m_registers, allocator))
+        {
+            retCode = false;
+        }
+
+    } // end pipleline loop
+
+    return retCode;
+}
+
+// Get diassembly size
+bool CodeObj::ExtractAssemblySizeInBytes(const char* options, uint32_t* pOutSizeInByes)
+{
+    bool retCode = false;
+    if (pOutSizeInByes != nullptr)
+    {
+        const std::vector<char>* pAssembly = GetCachedAssembly(options);
+
+        if (pAssembly != nullptr)
+        {
+            pOutSizeInByes[0] = uint32_t(pAssembly->size());
+            retCode = true;
+        }
+    }
+    return retCode;
+}
+
+// Get diassembly in a char*
+bool CodeObj::ExtractAssemblyRaw(const char* options, const uint32_t sizeInBytes, char* pOutData)
+{
+    bool retCode = false;
+    if (pOutData != nullptr)
+    {
+        const std::vector<char>* pAssembly = GetCachedAssembly(options);
+
+        if (pAssembly != nullptr && sizeInBytes == pAssembly->size())
+        {
+            memcpy(pOutData, pAssembly->data(), pAssembly->size());
+            retCode = true;
+
+            // The caller has its copy now, keeping one per options string would only grow the CodeObj.
+            m_assemblyCache.erase(options);
+        }
+    }
+    return retCode;
+}
+
+void CodeObj::ReleaseAssemblyCache()
+{
+    m_assemblyCache.clear();
+    ReleaseDisassemblyInfo();
+}
+
+const std::vector<char>* CodeObj::GetCachedAssembly(const char* options)
+{
+    if (options == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::string ipOptions(options);
+    auto cached = m_assemblyCache.find(ipOptions);
+
+    if (cached != m_assemblyCache.end())
+    {
+        return &cached->second;
+    }
+
+    // Only successful disassemblies are kept, a failure is retried on the next request.
+    std::vector<char> assemblyBuffer;
+
+    if (!ExtractAssemblyData(assemblyBuffer, ipOptions))
+    {
+        return nullptr;
+    }
+
+    return &m_assemblyCache.emplace(std::move(ipOptions), std::move(assemblyBuffer)).first->second;
+}
+
+
+bool CodeObj::ExtractAssemblyData(std::vector<char>& assemblyBuffer, std::string options)
+{
+    std::shared_ptr<DiskCache> pDiskCache = GetDiskCache(m_pDisassemblyDiskCache);
+    std::string key;
+
+    if (pDiskCache != nullptr)
+    {
+        std::string tag("disassembly object|");
+        tag.append(GetComgrVersionTag()).append("|").append(options);
+        key = DiskCache::MakeKey(m_pData, m_dataSize, tag);
+
+        if (pDiskCache->Load(key, assemblyBuffer))
+        {
+            return true;
+        }
+    }
+
+    bool retCode = DisassembleCodeObject(assemblyBuffer, options);
+
+    // The cache only speeds up later calls, a failed write is not an error.
+    if (retCode && pDiskCache != nullptr)
+    {
+        pDiskCache->Store(key, assemblyBuffer.data(), assemblyBuffer.size());
+    }
+
+    return retCode;
+}
+
+bool CodeObj::DisassembleCodeObject(std::vector<char>& assemblyBuffer, const std::string& options)
+{
+    amd_comgr_status_t status;
+    std::shared_ptr<ProcessPool> pProcessPool = GetProcessPool();
+
+    if (pProcessPool != nullptr)
+    {
+        amd_comgr_data_kind_t dataKind;
+        status = ComgrEntryPoints::Instance()->amd_comgr_get_data_kind_fn(m_data.Get(), &dataKind);
+        CheckStatus(status, false);
+
+        return pProcessPool->Run(COMGR_UTILS_PROCESS_POOL_TASK_DISASSEMBLE, m_pData, m_dataSize, dataKind, AMD_COMGR_LANGUAGE_NONE,
+                                 options, assemblyBuffer);
+    }
+
+    ComgrActionInfo actionInfo;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_action_info_fn(actionInfo.Receive());
+    CheckStatus(status, false);
+
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_isa_name_fn(actionInfo.Get(), options.c_str());
+    CheckStatus(status, false);
+
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo.Get(), "");
+    CheckStatus(status, false);
+
+    ComgrDataSet dataSetOut;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetOut.Receive());
+    CheckStatus(status, false);
+
+    status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_DISASSEMBLE_RELOCATABLE_TO_SOURCE,
+                                                                  actionInfo.Get(),
+                                                                  m_dataSet.Get(),
+                                                                  dataSetOut.Get());
+    CheckStatus(status, false);
+
+    size_t count;
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetOut.Get(), AMD_COMGR_DATA_KIND_SOURCE, &count);
+    CheckStatus(status, false);
+
+    if (1 != count)
+    {
+        std::cerr << "ERROR: Number of data object should be 1." << std::endl;
+        return false;
+    }
+
+    ComgrData dataOut;
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_get_data_fn(dataSetOut.Get(), AMD_COMGR_DATA_KIND_SOURCE, 0, dataOut.Receive());
+    CheckStatus(status, false);
+
+    // Update size only, then we can update output buffer later
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut.Get(), &count, nullptr);
+    CheckStatus(status, false);
+
+    // Update output buffer
+    assemblyBuffer.resize(count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut.Get(), &count, assemblyBuffer.data());
+    CheckStatus(status, false);
+
+    return true;
+}
+
+bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, const amd_comgr_language_t& languageInfo, const std::string& isaName)
+{
+    std::shared_ptr<DiskCache> pDiskCache = GetDiskCache(m_pCompileDiskCache);
+    std::string key;
+
+    if (pDiskCache != nullptr)
+    {
+        char language[32];
+        snprintf(language, sizeof(language), "compile %d|", static_cast<int>(languageInfo));
+        std::string tag(language);
+        tag.append(GetComgrVersionTag()).append("|").append(isaName).append("|").append(s_COMPILE_OPTIONS);
+        key = DiskCache::MakeKey(m_pData, m_dataSize, tag);
+
+        if (pDiskCache->Load(key, codeObjectBuffer))
         {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_WAVEFRONT_SIZE, ppln, wavefrontSize);
-            pPipelineData->m_wavefrontSize = wavefrontSize.value<uint32_t>();
+            return true;
         }
+    }
+
+    bool retCode = CompileSourceToExecutable(codeObjectBuffer, languageInfo, isaName);
+
+    // The cache only speeds up later calls, a failed write is not an error.
+    if (retCode && pDiskCache != nullptr)
+    {
+        pDiskCache->Store(key, codeObjectBuffer.data(), codeObjectBuffer.size());
+    }
+
+    return retCode;
+}
+
+void CodeObj::SetDisassemblyDiskCache(const std::string& directory, uint64_t maxSizeInBytes)
+{
+    SetDiskCache(m_pDisassemblyDiskCache, directory, maxSizeInBytes);
+}
+
+void CodeObj::SetCompileDiskCache(const std::string& directory, uint64_t maxSizeInBytes)
+{
+    SetDiskCache(m_pCompileDiskCache, directory, maxSizeInBytes);
+}
+
+void CodeObj::SetDiskCache(std::shared_ptr<DiskCache>& pDiskCache, const std::string& directory, uint64_t maxSizeInBytes)
+{
+    std::shared_ptr<DiskCache> pNewDiskCache;
+
+    if (!directory.empty())
+    {
+        pNewDiskCache = std::make_shared<DiskCache>(directory, maxSizeInBytes);
+    }
+
+    std::lock_guard<std::mutex> lock(m_diskCacheMutex);
+    pDiskCache = pNewDiskCache;
+}
+
+std::shared_ptr<DiskCache> CodeObj::GetDiskCache(const std::shared_ptr<DiskCache>& pDiskCache)
+{
+    std::lock_guard<std::mutex> lock(m_diskCacheMutex);
+    return pDiskCache;
+}
+
+bool CodeObj::EnableProcessPool(uint32_t numWorkers, uint32_t timeoutInSeconds)
+{
+    // The current pool is stopped before the new spawner is forked, which then has nothing of it to inherit.
+    DisableProcessPool();
+
+    std::shared_ptr<ProcessPool> pProcessPool = std::make_shared<ProcessPool>(numWorkers, timeoutInSeconds);
+
+    if (!pProcessPool->IsValid())
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Could not start the comgr worker processes");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_processPoolMutex);
+    m_pProcessPool = pProcessPool;
+    return true;
+}
+
+void CodeObj::DisableProcessPool()
+{
+    std::shared_ptr<ProcessPool> pProcessPool;
+    {
+        std::lock_guard<std::mutex> lock(m_processPoolMutex);
+        pProcessPool.swap(m_pProcessPool);
+    }
+}
+
+std::shared_ptr<ProcessPool> CodeObj::GetProcessPool()
+{
+    // The workers run the actions themselves.
+    if (ProcessPool::IsWorkerProcess())
+    {
+        return nullptr;
+    }
 
-        // API
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_API, ppln))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_API, ppln, api);
-            pPipelineData->m_api = api.value<uint32_t>();
-        }
+    std::lock_guard<std::mutex> lock(m_processPoolMutex);
+    return m_pProcessPool;
+}
 
-        // ApiCreateInfo
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_API_CREATE_INFO, ppln))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_API_CREATE_INFO, ppln, apiCreate);
-            pPipelineData->m_apiCreateInfo = apiCreate.value<uint32_t>();
-        }
+// Describe the comgr library binary an entry point lives in by its path, size and modification time,
+// so that a rebuilt library that reports the same version does not reuse stale cached results
+static std::string GetComgrLibraryIdentity(const void* pEntryPoint)
+{
+    char identity[64];
+    std::string path;
+    unsigned long long size = 0;
+    unsigned long long modifiedTime = 0;
 
-        // Extract shaders.
-        GetPalMDMapItemRequired(gs_PAL_MD_TAG_SHADERS, ppln, shaders);
-        size_t shadersNum = shaders.size();
-        pPipelineData->m_numShaders = static_cast<uint32_t>(shadersNum);
-        pPipelineData->m_pShaderList = (ShaderInfo*) malloc(shadersNum * sizeof(ShaderInfo));
+#ifdef _WIN32
+    HMODULE module = nullptr;
+    char modulePath[MAX_PATH];
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
 
-        if (nullptr == pPipelineData->m_pShaderList)
-        {
-            retCode = false;
-            break;
-        }
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCSTR>(pEntryPoint), &module) &&
+        GetModuleFileNameA(module, modulePath, sizeof(modulePath)) != 0)
+    {
+        path = modulePath;
 
-        memset(pPipelineData->m_pShaderList, 0, shadersNum * sizeof(ShaderInfo));
-        // Extract Shaders Info.
-        if (!ExtractPalMDShadersInfo(*pPipelineData, ppln))
+        if (GetFileAttributesExA(modulePath, GetFileExInfoStandard, &attributes))
         {
-            retCode = false;
+            size = (static_cast<unsigned long long>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+            modifiedTime = (static_cast<unsigned long long>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
         }
+    }
+#else
+    Dl_info info;
+    struct stat fileStat;
 
-        // Extract hardware stages.
-        if (!ExtractPalMDHardwareStages(*pPipelineData, ppln))
-        {
-            retCode = false;
-        }
+    if (dladdr(pEntryPoint, &info) != 0 && info.dli_fname != nullptr)
+    {
+        path = info.dli_fname;
 
-        // Extract register info.
-        if (!ExtractPalMDRegisterInfo(*pPipelineData, ppln))
+        if (stat(info.dli_fname, &fileStat) == 0)
         {
-            retCode = false;
+            size = static_cast<unsigned long long>(fileStat.st_size);
+            modifiedTime = static_cast<unsigned long long>(fileStat.st_mtime);
         }
+    }
+#endif
 
-
-    } // end pipleline loop
-
-    return retCode;
+    snprintf(identity, sizeof(identity), "|%llu|%llu", size, modifiedTime);
+    return path + identity;
 }
 
-// Get diassembly size
-bool CodeObj::ExtractAssemblySizeInBytes(const char* options, uint32_t* pOutSizeInByes)
+std::string CodeObj::GetComgrVersionTag()
 {
-    bool retCode = false;
-    if (pOutSizeInByes != nullptr)
-    {
-        std::vector<char> assemblyBuffer;
-        std::string ipOptions(options);
+    size_t major = 0;
+    size_t minor = 0;
+    ComgrEntryPoints* pEntryPoints = ComgrEntryPoints::Instance();
+    pEntryPoints->amd_comgr_get_version_fn(&major, &minor);
+
+    char version[64];
+    snprintf(version, sizeof(version), "comgr %zu.%zu|cache %u|", major, minor, s_DISK_CACHE_FORMAT_VERSION);
+    return version + GetComgrLibraryIdentity(reinterpret_cast<const void*>(pEntryPoints->amd_comgr_get_version_fn));
+}
 
-        ExtractAssemblyData(assemblyBuffer, ipOptions);
+void CodeObj::ReleaseCompileDataSets()
+{
+    // Each entry is released when the last compile using it drops its reference, outside the lock.
+    std::unordered_map<std::string, std::shared_ptr<const CompileDataSets>> released;
 
-        pOutSizeInByes[0] = uint32_t(assemblyBuffer.size());
-        retCode = true;
+    {
+        std::lock_guard<std::mutex> lock(m_compileDataSetMutex);
+        released.swap(*m_pCompileDataSets);
     }
-    return retCode;
 }
 
-// Get diassembly in a char*
-bool CodeObj::ExtractAssemblyRaw(const char* options, const uint32_t sizeInBytes, char* pOutData)
+bool CodeObj::GetCompileDataSets(amd_comgr_language_t languageInfo, const std::string& isaName, std::shared_ptr<const CompileDataSets>& pDataSets)
 {
-    bool retCode = false;
-    if (pOutData != nullptr)
+    std::string key = std::to_string(static_cast<int>(languageInfo)) + "|" + isaName;
+
+    // The lock is held while the data sets are created, so concurrent compiles create them once.
+    std::lock_guard<std::mutex> lock(m_compileDataSetMutex);
+    auto cached = m_pCompileDataSets->find(key);
+
+    if (cached != m_pCompileDataSets->end())
     {
-        std::vector<char> assemblyBuffer;
-        std::string ipOptions(options);
+        pDataSets = cached->second;
+        return true;
+    }
 
-        ExtractAssemblyData(assemblyBuffer, options);
-        if (sizeInBytes == assemblyBuffer.size())
-        {
-            memcpy(pOutData, assemblyBuffer.data(), assemblyBuffer.size());
-            retCode = true;
-        }
+    std::shared_ptr<CompileDataSets> pNewDataSets = std::make_shared<CompileDataSets>();
+
+    if (!CreateCompileDataSets(languageInfo, isaName, *pNewDataSets))
+    {
+        return false;
     }
-    return retCode;
-}
 
+    pDataSets = pNewDataSets;
+    m_pCompileDataSets->emplace(std::move(key), std::move(pNewDataSets));
+    return true;
+}
 
-bool CodeObj::ExtractAssemblyData(std::vector<char>& assemblyBuffer, std::string options)
+bool CodeObj::CreateCompileDataSets(amd_comgr_language_t languageInfo, const std::string& isaName, CompileDataSets& dataSets)
 {
     amd_comgr_status_t status;
 
-    amd_comgr_action_info_t actionInfo;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_action_info_fn(&actionInfo);
+    ComgrActionInfo actionInfo;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_action_info_fn(actionInfo.Receive());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_isa_name_fn(actionInfo, options.c_str());
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_language_fn(actionInfo.Get(), languageInfo);
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo, "");
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_isa_name_fn(actionInfo.Get(), isaName.c_str());
     CheckStatus(status, false);
 
-    amd_comgr_data_set_t dataSetOut;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetOut);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo.Get(), s_COMPILE_OPTIONS);
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_DISASSEMBLE_RELOCATABLE_TO_SOURCE,
-                                                                  actionInfo,
-                                                                  m_dataSet,
-                                                                  dataSetOut);
+    // The actions add their data to a copy of the input, so an empty input leaves only the added data.
+    ComgrDataSet dataSetEmpty;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetEmpty.Receive());
+    CheckStatus(status, false);
+
+    ComgrDataSet precompiledHeaders;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(precompiledHeaders.Receive());
+    CheckStatus(status, false);
+
+    status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_ADD_PRECOMPILED_HEADERS,
+                                                                  actionInfo.Get(),
+                                                                  dataSetEmpty.Get(),
+                                                                  precompiledHeaders.Get());
     CheckStatus(status, false);
 
     size_t count;
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetOut, AMD_COMGR_DATA_KIND_SOURCE, &count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(precompiledHeaders.Get(), AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER, &count);
     CheckStatus(status, false);
 
     if (1 != count)
     {
-        std::cerr << "ERROR: Number of data object should be 1." << std::endl;
+        std::cerr << "ERROR: Incorrect number of data object (expected 1)." << std::endl;
         return false;
     }
 
-    amd_comgr_data_t dataOut;
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_get_data_fn(dataSetOut, AMD_COMGR_DATA_KIND_SOURCE, 0, &dataOut);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo.Get(), "");
     CheckStatus(status, false);
 
-    // Update size only, then we can update output buffer later
-    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut, &count, nullptr);
+    ComgrDataSet deviceLibraries;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(deviceLibraries.Receive());
     CheckStatus(status, false);
 
-    // Update output buffer
-    assemblyBuffer.resize(count);
-    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut, &count, assemblyBuffer.data());
+    status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_ADD_DEVICE_LIBRARIES,
+                                                                  actionInfo.Get(),
+                                                                  dataSetEmpty.Get(),
+                                                                  deviceLibraries.Get());
     CheckStatus(status, false);
 
+    dataSets.m_precompiledHeaders = std::move(precompiledHeaders);
+    dataSets.m_deviceLibraries = std::move(deviceLibraries);
     return true;
 }
 
-bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, const amd_comgr_language_t& languageInfo, const std::string& isaName)
+bool CodeObj::AddDataSetData(amd_comgr_data_set_t from, amd_comgr_data_kind_t kind, amd_comgr_data_set_t to)
+{
+    size_t count = 0;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(from, kind, &count);
+    CheckStatus(status, false);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        ComgrData data;
+        status = ComgrEntryPoints::Instance()->amd_comgr_action_data_get_data_fn(from, kind, i, data.Receive());
+        CheckStatus(status, false);
+
+        // The data set holds its own reference, the one of action_data_get_data is released with data.
+        status = ComgrEntryPoints::Instance()->amd_comgr_data_set_add_fn(to, data.Get());
+        CheckStatus(status, false);
+    }
+
+    return true;
+}
+
+bool CodeObj::CompileSourceToExecutable(std::vector<char>& codeObjectBuffer, const amd_comgr_language_t& languageInfo, const std::string& isaName)
 {
+    std::shared_ptr<ProcessPool> pProcessPool = GetProcessPool();
+
+    if (pProcessPool != nullptr)
+    {
+        return pProcessPool->Run(COMGR_UTILS_PROCESS_POOL_TASK_COMPILE, m_pData, m_dataSize, AMD_COMGR_DATA_KIND_SOURCE, languageInfo,
+                                 isaName, codeObjectBuffer);
+    }
+
     amd_comgr_status_t status;
 
-    amd_comgr_action_info_t actionInfo;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_action_info_fn(&actionInfo);
+    ComgrActionInfo actionInfo;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_action_info_fn(actionInfo.Receive());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_language_fn(actionInfo, languageInfo);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_language_fn(actionInfo.Get(), languageInfo);
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_isa_name_fn(actionInfo, isaName.c_str());
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_isa_name_fn(actionInfo.Get(), isaName.c_str());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo, "-mno-code-object-v3");
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo.Get(), s_COMPILE_OPTIONS);
     CheckStatus(status, false);
 
-    amd_comgr_data_set_t dataSetPreCompiledHeaders;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetPreCompiledHeaders);
+    // The precompiled headers and device libraries are shared by all compiles of the language and ISA.
+    // The reference keeps them alive for the whole compile, even if ReleaseCompileDataSets runs meanwhile.
+    std::shared_ptr<const CompileDataSets> pCompileDataSets;
+
+    if (!GetCompileDataSets(languageInfo, isaName, pCompileDataSets))
+    {
+        return false;
+    }
+
+    ComgrDataSet dataSetPreCompiledHeaders;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetPreCompiledHeaders.Receive());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_ADD_PRECOMPILED_HEADERS,
-                                                                  actionInfo,
-                                                                  m_dataSet,
-                                                                  dataSetPreCompiledHeaders);
+    status = ComgrEntryPoints::Instance()->amd_comgr_data_set_add_fn(dataSetPreCompiledHeaders.Get(), m_data.Get());
     CheckStatus(status, false);
 
+    if (!AddDataSetData(pCompileDataSets->m_precompiledHeaders.Get(), AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER, dataSetPreCompiledHeaders.Get()))
+    {
+        return false;
+    }
+
     size_t count;
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetPreCompiledHeaders, AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER, &count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetPreCompiledHeaders.Get(), AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER, &count);
     CheckStatus(status, false);
 
     if (1 != count)
@@ -619,17 +2375,17 @@ bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, con
         return false;
     }
 
-    amd_comgr_data_set_t dataSetBitCode;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetBitCode);
+    ComgrDataSet dataSetBitCode;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetBitCode.Receive());
     CheckStatus(status, false);
 
     status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_COMPILE_SOURCE_TO_BC,
-                                                                  actionInfo,
-                                                                  dataSetPreCompiledHeaders,
-                                                                  dataSetBitCode);
+                                                                  actionInfo.Get(),
+                                                                  dataSetPreCompiledHeaders.Get(),
+                                                                  dataSetBitCode.Get());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetBitCode, AMD_COMGR_DATA_KIND_BC, &count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetBitCode.Get(), AMD_COMGR_DATA_KIND_BC, &count);
     CheckStatus(status, false);
 
     if (1 != count)
@@ -638,36 +2394,27 @@ bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, con
         return false;
     }
 
-    amd_comgr_data_set_t dataSetDevLibs;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetDevLibs);
+    ComgrDataSet dataSetDevLibs;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetDevLibs.Receive());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo, "");
-    CheckStatus(status, false);
-
-    status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_ADD_DEVICE_LIBRARIES,
-                                                                  actionInfo,
-                                                                  dataSetBitCode,
-                                                                  dataSetDevLibs);
-    CheckStatus(status, false);
-
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetDevLibs, AMD_COMGR_DATA_KIND_BC, &count);
-    CheckStatus(status, false);
-
-    amd_comgr_data_set_t dataSetLinked;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetLinked);
-    CheckStatus(status, false);
+    if (!AddDataSetData(dataSetBitCode.Get(), AMD_COMGR_DATA_KIND_BC, dataSetDevLibs.Get()) ||
+        !AddDataSetData(pCompileDataSets->m_deviceLibraries.Get(), AMD_COMGR_DATA_KIND_BC, dataSetDevLibs.Get()))
+    {
+        return false;
+    }
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo, "-mno-code-object-v3");
+    ComgrDataSet dataSetLinked;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetLinked.Receive());
     CheckStatus(status, false);
 
     status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_LINK_BC_TO_BC,
-                                                                  actionInfo,
-                                                                  dataSetDevLibs,
-                                                                  dataSetLinked);
+                                                                  actionInfo.Get(),
+                                                                  dataSetDevLibs.Get(),
+                                                                  dataSetLinked.Get());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetLinked, AMD_COMGR_DATA_KIND_BC, &count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetLinked.Get(), AMD_COMGR_DATA_KIND_BC, &count);
     CheckStatus(status, false);
 
     if (1 != count)
@@ -676,17 +2423,17 @@ bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, con
         return false;
     }
 
-    amd_comgr_data_set_t dataSetRelocatable;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetRelocatable);
+    ComgrDataSet dataSetRelocatable;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetRelocatable.Receive());
     CheckStatus(status, false);
 
     status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_CODEGEN_BC_TO_RELOCATABLE,
-                                                                  actionInfo,
-                                                                  dataSetLinked,
-                                                                  dataSetRelocatable);
+                                                                  actionInfo.Get(),
+                                                                  dataSetLinked.Get(),
+                                                                  dataSetRelocatable.Get());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetRelocatable, AMD_COMGR_DATA_KIND_RELOCATABLE, &count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetRelocatable.Get(), AMD_COMGR_DATA_KIND_RELOCATABLE, &count);
     CheckStatus(status, false);
 
     if (1 != count)
@@ -695,20 +2442,20 @@ bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, con
         return false;
     }
 
-    amd_comgr_data_set_t dataSetExecutable;
-    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(&dataSetExecutable);
+    ComgrDataSet dataSetExecutable;
+    status = ComgrEntryPoints::Instance()->amd_comgr_create_data_set_fn(dataSetExecutable.Receive());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo, "");
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_info_set_options_fn(actionInfo.Get(), "");
     CheckStatus(status, false);
 
     status = ComgrEntryPoints::Instance()->amd_comgr_do_action_fn(AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE,
-                                                                  actionInfo,
-                                                                  dataSetRelocatable,
-                                                                  dataSetExecutable);
+                                                                  actionInfo.Get(),
+                                                                  dataSetRelocatable.Get(),
+                                                                  dataSetExecutable.Get());
     CheckStatus(status, false);
 
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetExecutable, AMD_COMGR_DATA_KIND_EXECUTABLE, &count);
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_count_fn(dataSetExecutable.Get(), AMD_COMGR_DATA_KIND_EXECUTABLE, &count);
     CheckStatus(status, false);
 
     if (1 != count)
@@ -717,17 +2464,17 @@ bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, con
         return false;
     }
 
-    amd_comgr_data_t dataOut;
-    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_get_data_fn(dataSetExecutable, AMD_COMGR_DATA_KIND_EXECUTABLE, 0, &dataOut);
+    ComgrData dataOut;
+    status = ComgrEntryPoints::Instance()->amd_comgr_action_data_get_data_fn(dataSetExecutable.Get(), AMD_COMGR_DATA_KIND_EXECUTABLE, 0, dataOut.Receive());
     CheckStatus(status, false);
 
     // Update size only, then we can update output buffer later
-    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut, &count, nullptr);
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut.Get(), &count, nullptr);
     CheckStatus(status, false);
 
     // Update output buffer
     codeObjectBuffer.resize(count);
-    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut, &count, codeObjectBuffer.data());
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_data_fn(dataOut.Get(), &count, codeObjectBuffer.data());
     CheckStatus(status, false);
 
     return true;
@@ -735,296 +2482,358 @@ bool CodeObj::ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, con
 
 void CodeObj::ClearPalPipelineData(PalPipelineData& data)
 {
+    if (data.m_pArena != nullptr)
+    {
+        PalArenaChunk* pChunk = static_cast<PalArenaChunk*>(data.m_pArena);
+
+        while (pChunk != nullptr)
+        {
+            PalArenaChunk* pPrev = pChunk->m_pPrev;
+            free(pChunk);
+            pChunk = pPrev;
+        }
+
+        data = PalPipelineData();
+        return;
+    }
+
     for (size_t pplnN = 0; pplnN < data.m_numPipelines; pplnN++)
     {
         Pipeline* ppln = &data.m_pPipelines[pplnN];
         free(ppln->m_pName);
         free(ppln->m_pShaderList);
 
-        for (size_t stageN = 0; stageN < ppln->m_numStages; stageN++)
+        for (size_t stageN = 0; (ppln->m_pStageList != nullptr) && (stageN < ppln->m_numStages); stageN++)
         {
             HWStageInfo* pStage = &ppln->m_pStageList[stageN];
             free(pStage->m_pEntryPointSymbolName);
         }
 
+        free(ppln->m_pStageList);
         free(ppln->m_pRegisterDataList);
     }
 
-    memset(&data, 0, sizeof(PalPipelineData));
+    free(data.m_pPipelines);
+    data = PalPipelineData();
 }
 
-std::pair<amd_comgr_status_t, std::string> CodeObj::GetLastError()
+// Compare two optional null terminated strings
+static bool IsSameString(const char* pLhs, const char* pRhs)
 {
-    const char* pErrMsg = nullptr;
-    std::string msg = (ComgrEntryPoints::Instance()->amd_comgr_status_string_fn(m_status, &pErrMsg) == AMD_COMGR_STATUS_SUCCESS ? pErrMsg : "");
-    amd_comgr_status_t status = m_status;
-    m_status = AMD_COMGR_STATUS_SUCCESS;
-    m_errMsg = "";
-    return {status, msg};
+    if (pLhs == nullptr || pRhs == nullptr)
+    {
+        return pLhs == pRhs;
+    }
+
+    return strcmp(pLhs, pRhs) == 0;
 }
 
-bool CodeObj::ExtractPalMDShadersInfo(Pipeline& mdPipelineData, MDNode& ppln)
+bool CodeObj::ComparePalPipelineData(const PalPipelineData& lhs, const PalPipelineData& rhs)
 {
-    GetPalMDMapItemRequired(gs_PAL_MD_TAG_SHADERS, ppln, shaders);
-    size_t shadersNum = shaders.size();
-    mdPipelineData.m_numShaders = static_cast<uint32_t>(shadersNum);
-
-    mdPipelineData.m_pShaderList = (ShaderInfo*)malloc(shadersNum * sizeof(ShaderInfo));
-    if (nullptr == mdPipelineData.m_pShaderList)
+    if (lhs.m_version.m_major != rhs.m_version.m_major || lhs.m_version.m_minor != rhs.m_version.m_minor ||
+        lhs.m_numPipelines != rhs.m_numPipelines)
     {
         return false;
     }
 
-    memset(mdPipelineData.m_pShaderList, 0, shadersNum * sizeof(ShaderInfo));
-
-    int shaderN = 0;
-
-    for (const std::string& shaderType : shaders.GetKeys())
+    for (uint32_t pplnN = 0; pplnN < lhs.m_numPipelines; ++pplnN)
     {
-        ShaderInfo* pShaderInfoData = &mdPipelineData.m_pShaderList[shaderN++];
-
-        // Shader Info Type.
-        if (shaderType == gs_PAL_MD_TAG_SHADER_TYPE_VERTEX)
-        {
-            pShaderInfoData->m_shaderType = ShaderInfoType::VERTEX_SHADER;
-        }
-        else if (shaderType == gs_PAL_MD_TAG_SHADER_TYPE_HULL)
-        {
-            pShaderInfoData->m_shaderType = ShaderInfoType::HULL_SHADER;
-        }
-        else if (shaderType == gs_PAL_MD_TAG_SHADER_TYPE_DOMAIN)
-        {
-            pShaderInfoData->m_shaderType = ShaderInfoType::DOMAIN_SHADER;
-        }
-        else if (shaderType == gs_PAL_MD_TAG_SHADER_TYPE_GEOMETRY)
+        const Pipeline& lhsPpln = lhs.m_pPipelines[pplnN];
+        const Pipeline& rhsPpln = rhs.m_pPipelines[pplnN];
+
+        if (!IsSameString(lhsPpln.m_pName, rhsPpln.m_pName) ||
+            lhsPpln.m_type != rhsPpln.m_type ||
+            lhsPpln.m_hash != rhsPpln.m_hash ||
+            lhsPpln.m_numShaders != rhsPpln.m_numShaders ||
+            lhsPpln.m_numStages != rhsPpln.m_numStages ||
+            lhsPpln.m_numRegisterWrites != rhsPpln.m_numRegisterWrites ||
+            lhsPpln.m_userDataLimit != rhsPpln.m_userDataLimit ||
+            lhsPpln.m_spillThreshold != rhsPpln.m_spillThreshold ||
+            lhsPpln.m_usesViewportArrayIndex != rhsPpln.m_usesViewportArrayIndex ||
+            lhsPpln.m_esGsLocalDataShareSize != rhsPpln.m_esGsLocalDataShareSize ||
+            lhsPpln.m_scratchMemorySize != rhsPpln.m_scratchMemorySize ||
+            lhsPpln.m_wavefrontSize != rhsPpln.m_wavefrontSize ||
+            lhsPpln.m_api != rhsPpln.m_api ||
+            lhsPpln.m_apiCreateInfo != rhsPpln.m_apiCreateInfo)
         {
-            pShaderInfoData->m_shaderType = ShaderInfoType::GEOMETRY_SHADER;
+            return false;
         }
-        else if (shaderType == gs_PAL_MD_TAG_SHADER_TYPE_PIXEL)
+
+        for (uint32_t shaderN = 0; shaderN < lhsPpln.m_numShaders; ++shaderN)
         {
-            pShaderInfoData->m_shaderType = ShaderInfoType::PIXEL_SHADER;
+            const ShaderInfo& lhsShader = lhsPpln.m_pShaderList[shaderN];
+            const ShaderInfo& rhsShader = rhsPpln.m_pShaderList[shaderN];
+
+            if (lhsShader.m_shaderType != rhsShader.m_shaderType ||
+                memcmp(lhsShader.m_hash, rhsShader.m_hash, sizeof(lhsShader.m_hash)) != 0 ||
+                lhsShader.m_hardwareMapping != rhsShader.m_hardwareMapping)
+            {
+                return false;
+            }
         }
-        else if (shaderType == gs_PAL_MD_TAG_SHADER_TYPE_COMPUTE)
+
+        for (uint32_t stageN = 0; stageN < lhsPpln.m_numStages; ++stageN)
         {
-            pShaderInfoData->m_shaderType = ShaderInfoType::COMPUTE_SHADER;
+            const HWStageInfo& lhsStage = lhsPpln.m_pStageList[stageN];
+            const HWStageInfo& rhsStage = rhsPpln.m_pStageList[stageN];
+
+            if (lhsStage.m_stageType != rhsStage.m_stageType ||
+                lhsStage.m_scratchMemorySize != rhsStage.m_scratchMemorySize ||
+                lhsStage.m_localDataShareSize != rhsStage.m_localDataShareSize ||
+                lhsStage.m_performanceDataBufferSize != rhsStage.m_performanceDataBufferSize ||
+                lhsStage.m_numUsedVgprs != rhsStage.m_numUsedVgprs ||
+                lhsStage.m_numUsedSgprs != rhsStage.m_numUsedSgprs ||
+                lhsStage.m_numAvailableVgprs != rhsStage.m_numAvailableVgprs ||
+                lhsStage.m_numAvailableSgprs != rhsStage.m_numAvailableSgprs ||
+                lhsStage.m_wavesPerGroup != rhsStage.m_wavesPerGroup ||
+                lhsStage.m_usesUavs != rhsStage.m_usesUavs ||
+                lhsStage.m_usesRovs != rhsStage.m_usesRovs ||
+                lhsStage.m_writesUavs != rhsStage.m_writesUavs ||
+                lhsStage.m_writesDepth != rhsStage.m_writesDepth ||
+                lhsStage.m_maxPrimsPerPsWave != rhsStage.m_maxPrimsPerPsWave ||
+                lhsStage.m_numInterpolants != rhsStage.m_numInterpolants ||
+                !IsSameString(lhsStage.m_pEntryPointSymbolName, rhsStage.m_pEntryPointSymbolName))
+            {
+                return false;
+            }
         }
-        else
+
+        for (uint32_t regN = 0; regN < lhsPpln.m_numRegisterWrites; ++regN)
         {
-            assert(false && "ERROR: Unknown Shader Info Type.");
-        }
+            const RegisterData& lhsReg = lhsPpln.m_pRegisterDataList[regN];
+            const RegisterData& rhsReg = rhsPpln.m_pRegisterDataList[regN];
 
-        MDNode shaderInfo = shaders[shaderType];
-        Check(shaderInfo.IsValid() && shaderInfo.GetKind() == MDNode::Kind::Map, false);
-        // Shader Info Hash. (Not supported yet)
-        //GetPalMDMapItemRequired(gs_PAL_MD_TAG_SHADER_HASH, shaderInfo, shaderHash);
-        //pShaderInfoData->m_hash = ...
-        // Hardware Mapping.
-        GetPalMDMapItemRequired(gs_PAL_MD_TAG_SHADER_HARDWARE_MAPPING, shaderInfo, shaderHwMapping);
-        pShaderInfoData->m_hardwareMapping = shaderHwMapping.value<uint32_t>();
+            if (lhsReg.m_address != rhsReg.m_address || lhsReg.m_data != rhsReg.m_data)
+            {
+                return false;
+            }
+        }
     }
 
     return true;
 }
 
-bool CodeObj::ExtractPalMDHardwareStages(Pipeline& mdPipelineData, MDNode& ppln)
+std::pair<amd_comgr_status_t, std::string> CodeObj::GetLastError()
 {
-    GetPalMDMapItemRequired(gs_PAL_MD_TAG_HARDWARE_STAGES, ppln, stages);
-    size_t stagesNum = stages.size();
-    mdPipelineData.m_numStages = static_cast<uint32_t>(stagesNum);
-    mdPipelineData.m_pStageList = (HWStageInfo*) malloc(stagesNum * sizeof(HWStageInfo));
+    const char* pErrMsg = nullptr;
+    std::string msg = (ComgrEntryPoints::Instance()->amd_comgr_status_string_fn(m_status, &pErrMsg) == AMD_COMGR_STATUS_SUCCESS ? pErrMsg : "");
+    amd_comgr_status_t status = m_status;
+    m_status = AMD_COMGR_STATUS_SUCCESS;
+    m_errMsg = "";
+    return {status, msg};
+}
 
-    if (mdPipelineData.m_pStageList == nullptr)
+// Position of the next entry filled by the shader and hardware stage visitors
+struct PalMDListVisitState
+{
+    Pipeline*           m_pPipeline;    // The pipeline being filled
+    PalDataAllocator*   m_pAllocator;   // Allocator of the pipeline strings
+    uint32_t            m_numVisited;   // Number of entries filled so far
+    uint32_t            m_numEntries;   // Number of entries allocated
+    HWStageInfo*        m_pStage;       // The hardware stage of the current stage map
+    PalMDListVisitState(Pipeline& pipeline, PalDataAllocator& allocator, uint32_t numEntries) : m_pPipeline(&pipeline), m_pAllocator(&allocator),
+        m_numVisited(0), m_numEntries(numEntries), m_pStage(nullptr) {}
+};
+
+// Report a missing required map of a pipeline
+static bool CheckPalMDRequiredNode(const MDNode& node, const char* pTag)
+{
+    if (!node.IsValid())
     {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, std::string("ERROR: Failed to get required MD value:") + pTag);
         return false;
     }
 
-    memset(mdPipelineData.m_pStageList, 0, stagesNum * sizeof(HWStageInfo));
+    return true;
+}
 
-    int stageN = 0;
+// MDNode::VisitMap callback storing one entry of the ".shaders" map
+static bool VisitPalMDShader(PalMDTag tag, const char* pKey, size_t keyLen, MDNode& val, void* pUserData)
+{
+    COMGRUTILS_UNUSED(pKey);
+    COMGRUTILS_UNUSED(keyLen);
+    PalMDListVisitState* pState = static_cast<PalMDListVisitState*>(pUserData);
 
-    for (const std::string& stageType : stages.GetKeys())
+    if (pState->m_numVisited >= pState->m_numEntries)
     {
-        HWStageInfo* stageInfoData = &mdPipelineData.m_pStageList[stageN++];
+        return true;
+    }
 
-        // Stage Type.
-        if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_LS)
-        {
-            stageInfoData->m_stageType = HwStageType::LS;
-        }
-        else if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_HS)
-        {
-            stageInfoData->m_stageType = HwStageType::HS;
-        }
-        else if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_ES)
-        {
-            stageInfoData->m_stageType = HwStageType::ES;
-        }
-        else if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_GS)
-        {
-            stageInfoData->m_stageType = HwStageType::GS;
-        }
-        else if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_PS)
-        {
-            stageInfoData->m_stageType = HwStageType::PS;
-        }
-        else if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_VS)
-        {
-            stageInfoData->m_stageType = HwStageType::VS;
-        }
-        else if (stageType == gs_PAL_MD_TAG_HARDWARE_STAGE_CS)
-        {
-            stageInfoData->m_stageType = HwStageType::CS;
-        }
-        else
-        {
-            assert(false && "ERROR: Unknown HW Stage Type");
-        }
+    ShaderInfo* pShaderInfoData = &pState->m_pPipeline->m_pShaderList[pState->m_numVisited++];
+
+    // Shader Info Type.
+    if (!GetShaderInfoType(tag, pShaderInfoData->m_shaderType))
+    {
+        assert(false && "ERROR: Unknown Shader Info Type.");
+    }
 
-        MDNode stageInfo = stages[stageType];
-        Check(stageInfo.IsValid() && stageInfo.GetKind() == MDNode::Kind::Map, false);
+    // Shader Info Hash. (Not supported yet)
+    //pShaderInfoData->m_hash = ...
+    // Hardware Mapping, the only field read from the shader map.
+    MDNode shaderHwMapping = val[gs_PAL_MD_TAG_SHADER_HARDWARE_MAPPING];
 
-        // Entry Symbol Name.
-        GetPalMDMapItemRequired(gs_PAL_MD_TAG_ENTRY_POINT_SYMBOL_NAME, stageInfo, entryName);
-        const std::string& name = entryName.value<std::string>();
+    if (!CheckPalMDRequiredNode(shaderHwMapping, gs_PAL_MD_TAG_SHADER_HARDWARE_MAPPING))
+    {
+        return false;
+    }
 
-        stageInfoData->m_pEntryPointSymbolName = (char*)malloc(name.size() + 1);
-        memset(stageInfoData->m_pEntryPointSymbolName, '\0', name.size() + 1);
+    pShaderInfoData->m_hardwareMapping = shaderHwMapping.value<uint32_t>();
+    return true;
+}
 
-        strncpy_safe(stageInfoData->m_pEntryPointSymbolName, name.c_str(), name.size() + 1, name.length() + 1);
+// MDNode::VisitMap callback storing one field of a hardware stage map
+static bool VisitPalMDHardwareStageField(PalMDTag tag, const char* pKey, size_t keyLen, MDNode& val, void* pUserData)
+{
+    COMGRUTILS_UNUSED(pKey);
+    COMGRUTILS_UNUSED(keyLen);
+    PalMDListVisitState* pState = static_cast<PalMDListVisitState*>(pUserData);
+    HWStageInfo& stage = *pState->m_pStage;
+
+    // If the gs_PAL_MD_TAG_NUM_AVAILABLE_VGPRS or gs_PAL_MD_TAG_NUM_AVAILABLE_SGPRS
+    // tags are not there, then we should be using the device limits.
+    //
+    // The metadata tags only added if the limits were explicitly overwritten.
+    switch (tag)
+    {
+        case PalMDTag::ENTRY_POINT_SYMBOL_NAME:
+            stage.m_pEntryPointSymbolName = AllocPalMDString(val, *pState->m_pAllocator);
+            return stage.m_pEntryPointSymbolName != nullptr;
+
+        case PalMDTag::SCRATCH_MEMORY_SIZE:     stage.m_scratchMemorySize = val.value<uint32_t>();          break;
+        case PalMDTag::LOCAL_DATA_SHARE_SIZE:   stage.m_localDataShareSize = val.value<uint32_t>();         break;
+        case PalMDTag::PERF_DATA_BUFFER_SIZE:   stage.m_performanceDataBufferSize = val.value<uint32_t>();  break;
+        case PalMDTag::NUM_USED_VGPRS:          stage.m_numUsedVgprs = val.value<uint32_t>();               break;
+        case PalMDTag::NUM_USED_SGPRS:          stage.m_numUsedSgprs = val.value<uint32_t>();               break;
+        case PalMDTag::NUM_AVAILABLE_VGPRS:     stage.m_numAvailableVgprs = val.value<uint32_t>();          break;
+        case PalMDTag::NUM_AVAILABLE_SGPRS:     stage.m_numAvailableSgprs = val.value<uint32_t>();          break;
+        case PalMDTag::WAVES_PER_GROUP:         stage.m_wavesPerGroup = val.value<uint32_t>();              break;
+        case PalMDTag::USES_UAVS:               stage.m_usesUavs = val.value<uint32_t>();                   break;
+        case PalMDTag::USES_ROVS:               stage.m_usesRovs = val.value<uint32_t>();                   break;
+        case PalMDTag::WRITES_UAVS:             stage.m_writesUavs = val.value<uint32_t>();                 break;
+        case PalMDTag::WRITES_DEPTH:            stage.m_writesDepth = val.value<uint32_t>();                break;
+        case PalMDTag::MAX_PRIMS_PER_PS_WAVE:   stage.m_maxPrimsPerPsWave = val.value<uint32_t>();          break;
+        case PalMDTag::NUM_INTERPOLANTS:        stage.m_numInterpolants = val.value<uint32_t>();            break;
+        default:                                break;
+    }
 
-        // Scratch Memory Size.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_SCRATCH_MEMORY_SIZE, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_SCRATCH_MEMORY_SIZE, stageInfo, scratchMemSize);
-            stageInfoData->m_scratchMemorySize = scratchMemSize.value<uint32_t>();
-        }
+    return true;
+}
 
-        // Local Data Share Size.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_LOCAL_DATA_SHARE_SIZE, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_LOCAL_DATA_SHARE_SIZE, stageInfo, localshareSize);
-            stageInfoData->m_localDataShareSize = localshareSize.value<uint32_t>();
-        }
+// MDNode::VisitMap callback storing one entry of the ".hardware_stages" map
+static bool VisitPalMDHardwareStage(PalMDTag tag, const char* pKey, size_t keyLen, MDNode& val, void* pUserData)
+{
+    COMGRUTILS_UNUSED(pKey);
+    COMGRUTILS_UNUSED(keyLen);
+    PalMDListVisitState* pState = static_cast<PalMDListVisitState*>(pUserData);
 
-        // Perf Data Buffer Size.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_PERF_DATA_BUFFER_SIZE, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_PERF_DATA_BUFFER_SIZE, stageInfo, perfBufSize);
-            stageInfoData->m_performanceDataBufferSize = perfBufSize.value<uint32_t>();
-        }
+    if (pState->m_numVisited >= pState->m_numEntries)
+    {
+        return true;
+    }
 
-        // Used VGPRs/SGPRs
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_NUM_USED_VGPRS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_NUM_USED_VGPRS, stageInfo, usedVGPRs);
-            stageInfoData->m_numUsedVgprs = usedVGPRs.value<uint32_t>();
-        }
+    HWStageInfo* pStageInfoData = &pState->m_pPipeline->m_pStageList[pState->m_numVisited++];
 
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_NUM_USED_SGPRS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_NUM_USED_SGPRS, stageInfo, usedSGPRs);
-            stageInfoData->m_numUsedSgprs = usedSGPRs.value<uint32_t>();
-        }
+    // Stage Type.
+    if (!GetHwStageType(tag, pStageInfoData->m_stageType))
+    {
+        assert(false && "ERROR: Unknown HW Stage Type");
+    }
 
-        // If the gs_PAL_MD_TAG_NUM_AVAILABLE_VGPRS or gs_PAL_MD_TAG_NUM_AVAILABLE_SGPRS
-        // tags are not there, then we should be using the device limits.
-        //
-        // The metadata tags only added if the limits were explicitly overwritten.
+    // All the stage fields are read in one pass over the stage map.
+    pState->m_pStage = pStageInfoData;
 
-        // Available VGPRs/SGPRs
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_NUM_AVAILABLE_VGPRS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_NUM_AVAILABLE_VGPRS, stageInfo, availableVGPRs);
-            stageInfoData->m_numAvailableVgprs = availableVGPRs.value<uint32_t>();
-        }
+    if (!val.VisitMap(VisitPalMDHardwareStageField, pState))
+    {
+        return false;
+    }
 
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_NUM_AVAILABLE_SGPRS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_NUM_AVAILABLE_SGPRS, stageInfo, availableSGPRs);
-            stageInfoData->m_numAvailableSgprs = availableSGPRs.value<uint32_t>();
-        }
+    // Entry Symbol Name.
+    if (pStageInfoData->m_pEntryPointSymbolName == nullptr)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, std::string("ERROR: Failed to get required MD value:") + gs_PAL_MD_TAG_ENTRY_POINT_SYMBOL_NAME);
+        return false;
+    }
 
-        // Waves Per Group
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_WAVES_PER_GROUP, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_WAVES_PER_GROUP, stageInfo, wavesPerGroup);
-            stageInfoData->m_wavesPerGroup = wavesPerGroup.value<uint32_t>();
-        }
+    return true;
+}
 
-        // Uses Uavs.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_USES_UAVS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_USES_UAVS, stageInfo, usesUavs);
-            stageInfoData->m_usesUavs = usesUavs.value<uint32_t>();
-        }
+bool CodeObj::ExtractPalMDShadersInfo(Pipeline& mdPipelineData, const MDNode& shaders, PalDataAllocator& allocator)
+{
+    if (!CheckPalMDRequiredNode(shaders, gs_PAL_MD_TAG_SHADERS))
+    {
+        return false;
+    }
 
-        // Uses Rovs.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_USES_ROVS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_USES_ROVS, stageInfo, usesRovs);
-            stageInfoData->m_usesRovs = usesRovs.value<uint32_t>();
-        }
+    size_t shadersNum = shaders.size();
+    mdPipelineData.m_numShaders = static_cast<uint32_t>(shadersNum);
 
-        // Writes Uavs.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_WRITES_UAVS, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_WRITES_UAVS, stageInfo, writesUavs);
-            stageInfoData->m_writesUavs = writesUavs.value<uint32_t>();
-        }
+    mdPipelineData.m_pShaderList = (ShaderInfo*)allocator.Alloc(shadersNum * sizeof(ShaderInfo));
+    if (nullptr == mdPipelineData.m_pShaderList)
+    {
+        return false;
+    }
 
-        // Writes Depth.
-        if (CheckPalMDMapItem(gs_PAL_MD_TAG_WRITES_DEPTH, stageInfo))
-        {
-            GetPalMDMapItemRequired(gs_PAL_MD_TAG_WRITES_DEPTH, stageInfo, writesDepth);
-            stageInfoData->m_writesDepth = writesDepth.value<uint32_t>();
-        }
+    PalMDListVisitState state(mdPipelineData, allocator, mdPipelineData.m_numShaders);
+    return shaders.VisitMap(VisitPalMDShader, &state);
+}
 
-        // MaxPrimsPerPsWave (optional).
-        stageInfoData->m_maxPrimsPerPsWave = (stageInfo.Find(gs_PAL_MD_TAG_MAX_PRIMS_PER_PS_WAVE) ?
-                                              stageInfo[gs_PAL_MD_TAG_MAX_PRIMS_PER_PS_WAVE].value<uint32_t>() : 0);
+bool CodeObj::ExtractPalMDHardwareStages(Pipeline& mdPipelineData, const MDNode& stages, PalDataAllocator& allocator)
+{
+    if (!CheckPalMDRequiredNode(stages, gs_PAL_MD_TAG_HARDWARE_STAGES))
+    {
+        return false;
+    }
 
-        // NumInterpolants (optional).
-        stageInfoData->m_numInterpolants = (stageInfo.Find(gs_PAL_MD_TAG_NUM_INTERPOLANTS) ?
-                                            stageInfo[gs_PAL_MD_TAG_NUM_INTERPOLANTS].value<uint32_t>() : 0);
+    size_t stagesNum = stages.size();
+    mdPipelineData.m_numStages = static_cast<uint32_t>(stagesNum);
+    mdPipelineData.m_pStageList = (HWStageInfo*)allocator.Alloc(stagesNum * sizeof(HWStageInfo));
 
+    if (mdPipelineData.m_pStageList == nullptr)
+    {
+        return false;
     }
 
-    return true;
+    PalMDListVisitState state(mdPipelineData, allocator, mdPipelineData.m_numStages);
+    return stages.VisitMap(VisitPalMDHardwareStage, &state);
 }
 
-bool CodeObj::ExtractPalMDRegisterInfo(Pipeline& mdPipelineData, MDNode& ppln)
+bool CodeObj::ExtractPalMDRegisterInfo(Pipeline& mdPipelineData, const MDNode& regs, PalDataAllocator& allocator)
 {
-    bool retCode = true;
     // Registers.
-    GetPalMDMapItemRequired(gs_PAL_MD_TAG_REGISTERS, ppln, regs);
-    mdPipelineData.m_numRegisterWrites = static_cast<uint32_t>(regs.size());
-    if (regs.size() > 0)
+    if (!CheckPalMDRequiredNode(regs, gs_PAL_MD_TAG_REGISTERS))
+    {
+        return false;
+    }
+
+    size_t regsNum = regs.size();
+    mdPipelineData.m_numRegisterWrites = static_cast<uint32_t>(regsNum);
+
+    if (regsNum > 0)
     {
-        mdPipelineData.m_pRegisterDataList = (RegisterData*)malloc(regs.size() * sizeof(RegisterData));
+        mdPipelineData.m_pRegisterDataList = (RegisterData*)allocator.Alloc(regsNum * sizeof(RegisterData));
+
         if (nullptr != mdPipelineData.m_pRegisterDataList)
         {
+            // Decode all the register addresses and values in one pass over the map.
+            std::vector<MDUnsignedEntry> entries;
+            entries.reserve(regsNum);
+            bool retCode = regs.DecodeUnsignedMap(entries);
+            assert(retCode);
 
-            memset(mdPipelineData.m_pRegisterDataList, 0, regs.size() * sizeof(RegisterData));
+            size_t numEntries = std::min(entries.size(), regsNum);
 
-            for (const std::string& addrKey : regs.GetKeys())
+            for (size_t regN = 0; regN < numEntries; ++regN)
             {
-                RegisterData* regData = &mdPipelineData.m_pRegisterDataList[0];
-                GetPalMDMapItemRequired(addrKey, regs, temp);
-                std::stringstream stream(addrKey);
-                stream >> regData->m_address;
-                assert(!stream.fail());
-
-                if (stream.fail())
-                {
-                    retCode = false;
-                }
-
-                regData->m_data = temp.value<uint32_t>();
+                RegisterData* regData = &mdPipelineData.m_pRegisterDataList[regN];
+                regData->m_address = static_cast<uint32_t>(entries[regN].m_key);
+                regData->m_data = static_cast<uint32_t>(entries[regN].m_value);
             }
+
+            return retCode;
         }
     } //if regs.size() > 0
 
-    return retCode;
+    return true;
 }
 
 void CodeObj::SetError(amd_comgr_status_t err, const std::string& errMsg)
@@ -1037,20 +2846,22 @@ void CodeObj::SetError(amd_comgr_status_t err, const std::string& errMsg)
     }
 }
 
-MDNode::MDNode(amd_comgr_metadata_node_t node) : m_handle(node)
+MDNode::MDNode(amd_comgr_metadata_node_t node) : m_handle(node), m_stringView()
 {
 }
 
-MDNode::MDNode(int handle)
+MDNode::MDNode(int handle) : m_stringView()
 {
-    m_handle.handle = handle;
+    amd_comgr_metadata_node_t node;
+    node.handle = handle;
+    m_handle.Reset(node);
 }
 
 MDNode::Kind MDNode::GetKind() const
 {
     CheckValid(Kind::None);
     amd_comgr_metadata_kind_t kind = AMD_COMGR_METADATA_KIND_NULL;
-    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_kind_fn(m_handle, &kind);
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_kind_fn(m_handle.Get(), &kind);
     CheckStatus(status, Kind::None);
 
     // TODO: Current comgr implementation returns integer values as strings.
@@ -1081,7 +2892,7 @@ MDNode MDNode::operator[](int idx) const
     {
         if (GetKind() == Kind::List)
         {
-            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_index_list_metadata_fn(m_handle, idx, &child);
+            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_index_list_metadata_fn(m_handle.Get(), idx, &child);
             CheckStatus(status, child);
         }
     }
@@ -1097,7 +2908,7 @@ MDNode MDNode::operator[](size_t idx) const
     {
         if (GetKind() == Kind::List)
         {
-            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_index_list_metadata_fn(m_handle, idx, &child);
+            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_index_list_metadata_fn(m_handle.Get(), idx, &child);
             CheckStatus(status, child);
         }
     }
@@ -1112,7 +2923,7 @@ MDNode MDNode::operator[](const std::string& key) const
     {
         if (GetKind() == Kind::Map)
         {
-            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_metadata_lookup_fn(m_handle, key.c_str(), &child);
+            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_metadata_lookup_fn(m_handle.Get(), key.c_str(), &child);
             CheckStatus(status, child);
         }
     }
@@ -1128,7 +2939,7 @@ MDNode MDNode::operator[](const char* key) const
     {
         if (GetKind() == Kind::Map)
         {
-            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_metadata_lookup_fn(m_handle, key, &child);
+            amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_metadata_lookup_fn(m_handle.Get(), key, &child);
             CheckStatus(status, child);
         }
     }
@@ -1142,8 +2953,8 @@ bool MDNode::Find(const std::string& key) const
 
     if (GetKind() == Kind::Map)
     {
-        amd_comgr_metadata_node_t child;
-        amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_metadata_lookup_fn(m_handle, key.c_str(), &child);
+        ComgrMetadataNode child;
+        amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_metadata_lookup_fn(m_handle.Get(), key.c_str(), child.Receive());
         return (status == AMD_COMGR_STATUS_SUCCESS);
     }
     else
@@ -1155,26 +2966,148 @@ bool MDNode::Find(const std::string& key) const
 template <typename TYPE>
 TYPE MDNode::value() const
 {
-    // The default specialization for arithmetic types.
+    // The default specialization for integral types.
+    static_assert(std::is_integral<TYPE>::value, "MDNode::value supports integral types and std::string");
     CheckValid(0);
     TYPE val = (TYPE)0;
+    MDNumberStatus status = MDNumberStatus::Invalid;
 
     // TODO: Current comgr implementation returns integer values as strings.
     // That will change soon, so this code must be updated too.
-    if (GetKind() == Kind::String)
+    if (std::is_signed<TYPE>::value)
     {
-        std::stringstream stream(value<std::string>());
-        stream >> val;
+        int64_t number = 0;
+        status = GetSigned(number);
 
-        if (stream.fail())
+        if (status == MDNumberStatus::Success)
         {
-            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to convert to int32");
+            if (number < static_cast<int64_t>(std::numeric_limits<TYPE>::min()) || number > static_cast<int64_t>(std::numeric_limits<TYPE>::max()))
+            {
+                status = MDNumberStatus::Overflow;
+            }
+            else
+            {
+                val = static_cast<TYPE>(number);
+            }
+        }
+    }
+    else
+    {
+        uint64_t number = 0;
+        status = GetUnsigned(number);
+
+        if (status == MDNumberStatus::Success)
+        {
+            if (number > static_cast<uint64_t>(std::numeric_limits<TYPE>::max()))
+            {
+                status = MDNumberStatus::Overflow;
+            }
+            else
+            {
+                val = static_cast<TYPE>(number);
+            }
         }
     }
 
+    if (status == MDNumberStatus::Overflow)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: MD value is out of range");
+    }
+    else if (status == MDNumberStatus::Invalid && GetKind() == Kind::String)
+    {
+        // Only strings that are not numbers are errors, other node kinds read as 0.
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to convert MD value to a number");
+    }
+
     return val;
 }
 
+// Read the string of a metadata node that holds a number into a fixed buffer, without allocating
+static MDNumberStatus ReadMDNumberString(amd_comgr_metadata_node_t node, char (&buf)[s_MD_NUMBER_BUFFER_SIZE], size_t& length)
+{
+    size_t size = 0;
+
+    // Fails for nodes that are not strings.
+    if (ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(node, &size, nullptr) != AMD_COMGR_STATUS_SUCCESS)
+    {
+        return MDNumberStatus::Invalid;
+    }
+
+    // The size includes the null terminator. A longer string has more digits than any 64 bit number.
+    if (size > s_MD_NUMBER_BUFFER_SIZE)
+    {
+        return MDNumberStatus::Overflow;
+    }
+
+    if (size == 0 || ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(node, &size, buf) != AMD_COMGR_STATUS_SUCCESS)
+    {
+        return MDNumberStatus::Invalid;
+    }
+
+    buf[size - 1] = '\0';
+    length = strlen(buf);
+    return MDNumberStatus::Success;
+}
+
+MDNumberStatus MDNode::GetUnsigned(uint64_t& val) const
+{
+    CheckValid(MDNumberStatus::Invalid);
+    char buf[s_MD_NUMBER_BUFFER_SIZE];
+    size_t length = 0;
+    MDNumberStatus status = ReadMDNumberString(m_handle.Get(), buf, length);
+    return (status == MDNumberStatus::Success ? ParseMDUnsigned(buf, length, val) : status);
+}
+
+MDNumberStatus MDNode::GetSigned(int64_t& val) const
+{
+    CheckValid(MDNumberStatus::Invalid);
+    char buf[s_MD_NUMBER_BUFFER_SIZE];
+    size_t length = 0;
+    MDNumberStatus status = ReadMDNumberString(m_handle.Get(), buf, length);
+    return (status == MDNumberStatus::Success ? ParseMDSigned(buf, length, val) : status);
+}
+
+// State of a MDNode::DecodeUnsignedMap pass
+struct UnsignedMapDecodeState
+{
+    std::vector<MDUnsignedEntry>*   m_pEntries;     // The decoded entries
+    bool                            m_allDecoded;   // False if an entry could not be decoded
+};
+
+// MDNode::VisitMap callback decoding one entry of a map of numbers
+static bool VisitMDUnsignedEntry(PalMDTag tag, const char* pKey, size_t keyLen, MDNode& val, void* pUserData)
+{
+    COMGRUTILS_UNUSED(tag);
+    UnsignedMapDecodeState* pState = static_cast<UnsignedMapDecodeState*>(pUserData);
+    MDUnsignedEntry entry = {0, 0};
+
+    if (ParseMDUnsigned(pKey, keyLen, entry.m_key) != MDNumberStatus::Success ||
+        val.GetUnsigned(entry.m_value) != MDNumberStatus::Success)
+    {
+        pState->m_allDecoded = false;
+    }
+
+    pState->m_pEntries->push_back(entry);
+    return true;
+}
+
+bool MDNode::DecodeUnsignedMap(std::vector<MDUnsignedEntry>& entries) const
+{
+    UnsignedMapDecodeState state = {&entries, true};
+
+    if (!VisitMap(VisitMDUnsignedEntry, &state))
+    {
+        return false;
+    }
+
+    if (!state.m_allDecoded)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to convert MD map entry to a number");
+    }
+
+    return state.m_allDecoded;
+}
+
 size_t MDNode::size() const
 {
     CheckValid(0);
@@ -1184,11 +3117,11 @@ size_t MDNode::size() const
     switch (GetKind())
     {
         case Kind::List:
-            status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_list_size_fn(m_handle, &size);
+            status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_list_size_fn(m_handle.Get(), &size);
             break;
 
         case Kind::Map:
-            status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_map_size_fn(m_handle, &size);
+            status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_map_size_fn(m_handle.Get(), &size);
             break;
 
         default:
@@ -1202,16 +3135,63 @@ size_t MDNode::size() const
 std::vector<std::string> MDNode::GetKeys() const
 {
     CheckValid({});
-    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_iterate_map_metadata_fn(m_handle, MapIterCallback, nullptr);
+    std::vector<std::string> keys;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_iterate_map_metadata_fn(m_handle.Get(), MapIterCallback, &keys);
     CheckStatus(status, {});
-    std::vector<std::string> keys = gMapKeys;
-    gMapKeys.clear();
     return keys;
 }
 
+bool MDNode::VisitMap(MapVisitor pVisitor, void* pUserData) const
+{
+    CheckValid(false);
+    MapVisitState state(pVisitor, pUserData);
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_iterate_map_metadata_fn(m_handle.Get(), MapVisitCallback, &state);
+
+    // Keep the error set by the callback, it is more specific than the iteration status.
+    if (state.m_visitorFailed)
+    {
+        return false;
+    }
+
+    CheckStatus(status, false);
+    return true;
+}
+
 bool MDNode::IsValid() const
 {
-    return (m_handle.handle != 0);
+    return m_handle.IsValid();
+}
+
+bool MDNode::GetStringView(MDStringView& view) const
+{
+    CheckValid(false);
+
+    if (m_stringView.m_pData == nullptr)
+    {
+        size_t size = 0;
+        amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(m_handle.Get(), &size, nullptr);
+        CheckStatus(status, false);
+
+        // The size includes the null terminator.
+        std::unique_ptr<char[]> pString(new (std::nothrow) char[size + 1]);
+
+        if (pString == nullptr)
+        {
+            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Failed to allocate MD string");
+            return false;
+        }
+
+        status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(m_handle.Get(), &size, pString.get());
+        CheckStatus(status, false);
+        pString[size] = '\0';
+
+        m_pString = std::move(pString);
+        m_stringView.m_pData = m_pString.get();
+        m_stringView.m_size = strlen(m_pString.get());
+    }
+
+    view = m_stringView;
+    return true;
 }
 
 void Dump()
@@ -1224,25 +3204,310 @@ std::string MDNode::value<std::string>() const
 {
     CheckValid("");
 
+    // Reuse the string of an earlier GetStringView.
+    if (m_stringView.m_pData != nullptr)
+    {
+        return std::string(m_stringView.m_pData, m_stringView.m_size);
+    }
+
     if (GetKind() == Kind::String)
     {
         size_t bufSize;
-        char   buf[256];
-        amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(m_handle, &bufSize, NULL);
+        amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(m_handle.Get(), &bufSize, NULL);
+        CheckStatus(status, "");
+
+        // The size includes the null terminator.
+        std::vector<char> buf(bufSize + 1, '\0');
+        status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(m_handle.Get(), &bufSize, buf.data());
         CheckStatus(status, "");
+        return buf.data();
+    }
+    else
+    {
+        return "";
+    }
+}
+
+MDNumberStatus ParseMDUnsigned(const char* pStr, size_t length, uint64_t& value)
+{
+    // Booleans are returned as strings as well.
+    if (length == 4 && memcmp(pStr, "true", 4) == 0)
+    {
+        value = 1;
+        return MDNumberStatus::Success;
+    }
+
+    if (length == 5 && memcmp(pStr, "false", 5) == 0)
+    {
+        value = 0;
+        return MDNumberStatus::Success;
+    }
+
+    uint64_t base = 10;
+
+    if (length > 2 && pStr[0] == '0' && (pStr[1] == 'x' || pStr[1] == 'X'))
+    {
+        base = 16;
+        pStr += 2;
+        length -= 2;
+    }
+
+    if (length == 0)
+    {
+        return MDNumberStatus::Invalid;
+    }
+
+    uint64_t result = 0;
 
-        if (bufSize >= 256)
+    for (size_t i = 0; i < length; ++i)
+    {
+        char c = pStr[i];
+        uint64_t digit = 0;
+
+        if (c >= '0' && c <= '9')
+        {
+            digit = static_cast<uint64_t>(c - '0');
+        }
+        else if (base == 16 && c >= 'a' && c <= 'f')
+        {
+            digit = static_cast<uint64_t>(c - 'a' + 10);
+        }
+        else if (base == 16 && c >= 'A' && c <= 'F')
+        {
+            digit = static_cast<uint64_t>(c - 'A' + 10);
+        }
+        else
         {
-            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Size of string value exceeded.");
+            return MDNumberStatus::Invalid;
         }
 
-        status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(m_handle, &bufSize, buf);
-        CheckStatus(status, "");
-        return buf;
+        if (result > (std::numeric_limits<uint64_t>::max() - digit) / base)
+        {
+            return MDNumberStatus::Overflow;
+        }
+
+        result = result * base + digit;
+    }
+
+    value = result;
+    return MDNumberStatus::Success;
+}
+
+MDNumberStatus ParseMDSigned(const char* pStr, size_t length, int64_t& value)
+{
+    bool isNegative = (length > 1 && pStr[0] == '-' && pStr[1] >= '0' && pStr[1] <= '9');
+    uint64_t magnitude = 0;
+    MDNumberStatus status = (isNegative ? ParseMDUnsigned(pStr + 1, length - 1, magnitude) : ParseMDUnsigned(pStr, length, magnitude));
+
+    if (status != MDNumberStatus::Success)
+    {
+        return status;
+    }
+
+    const uint64_t maxMagnitude = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+
+    if (magnitude > maxMagnitude + (isNegative ? 1 : 0))
+    {
+        return MDNumberStatus::Overflow;
+    }
+
+    if (!isNegative)
+    {
+        value = static_cast<int64_t>(magnitude);
+    }
+    else if (magnitude > maxMagnitude)
+    {
+        value = std::numeric_limits<int64_t>::min();
     }
     else
     {
-        return "";
+        value = -static_cast<int64_t>(magnitude);
+    }
+
+    return MDNumberStatus::Success;
+}
+
+void CodeObjBatch::AddFile(const std::string& fileName)
+{
+    Item item;
+    item.m_fileName = fileName;
+    item.m_pBuf = nullptr;
+    item.m_sizeInBytes = 0;
+    m_items.push_back(std::move(item));
+}
+
+void CodeObjBatch::AddBuffer(std::vector<char>&& buf)
+{
+    Item item;
+    item.m_buf = std::move(buf);
+    item.m_pBuf = nullptr;
+    item.m_sizeInBytes = 0;
+    m_items.push_back(std::move(item));
+}
+
+void CodeObjBatch::AddBufferView(const char* pBuf, size_t sizeInBytes)
+{
+    Item item;
+    item.m_pBuf = pBuf;
+    item.m_sizeInBytes = sizeInBytes;
+    m_items.push_back(std::move(item));
+}
+
+void CodeObjBatch::ProcessItem(Item& item, uint32_t flags, CodeObjBatchResult& result)
+{
+    // Start from a clean error state on this worker thread.
+    CodeObj::GetLastError();
+
+    auto recordError = [&result]()
+    {
+        std::pair<amd_comgr_status_t, std::string> lastError = CodeObj::GetLastError();
+
+        if (result.m_status == AMD_COMGR_STATUS_SUCCESS)
+        {
+            result.m_status = (lastError.first != AMD_COMGR_STATUS_SUCCESS ? lastError.first : AMD_COMGR_STATUS_ERROR);
+            result.m_errMsg = lastError.second;
+        }
+    };
+
+    if (!item.m_fileName.empty())
+    {
+        result.m_pCodeObj = CodeObj::OpenMapped(item.m_fileName);
+    }
+    else if (item.m_pBuf != nullptr)
+    {
+        result.m_pCodeObj = CodeObj::OpenBufferView(item.m_pBuf, item.m_sizeInBytes);
+    }
+    else if (!item.m_buf.empty())
+    {
+        result.m_pCodeObj = CodeObj::OpenBuffer(std::move(item.m_buf));
+    }
+
+    if (result.m_pCodeObj == nullptr)
+    {
+        recordError();
+        return;
+    }
+
+    if ((flags & COMGR_UTILS_BATCH_EXTRACT_PAL_PIPELINE_DATA) != 0)
+    {
+        result.m_palPipelineDataValid = result.m_pCodeObj->ExtractPalPipelineData(result.m_palPipelineData);
+
+        if (!result.m_palPipelineDataValid)
+        {
+            recordError();
+        }
+    }
+
+    if ((flags & COMGR_UTILS_BATCH_EXTRACT_SYMBOL_DATA) != 0)
+    {
+        result.m_symbolDataValid = result.m_pCodeObj->ExtractSymbolData(result.m_symbolData);
+
+        if (!result.m_symbolDataValid)
+        {
+            recordError();
+        }
+    }
+}
+
+bool CodeObjBatch::Run(uint32_t flags, std::vector<CodeObjBatchResult>& results)
+{
+    results.clear();
+    results.resize(m_items.size());
+
+    WorkerPool pool(m_numWorkers);
+    pool.ParallelFor(m_items.size(), [&](size_t index)
+    {
+        ProcessItem(m_items[index], flags, results[index]);
+    });
+
+    m_items.clear();
+
+    bool retCode = true;
+
+    for (const CodeObjBatchResult& result : results)
+    {
+        if (result.m_status != AMD_COMGR_STATUS_SUCCESS)
+        {
+            retCode = false;
+        }
+    }
+
+    return retCode;
+}
+
+void CodeObjBatch::ClearResults(std::vector<CodeObjBatchResult>& results)
+{
+    for (CodeObjBatchResult& result : results)
+    {
+        CodeObj::ClearPalPipelineData(result.m_palPipelineData);
+        CodeObj::ClearSymbolData(result.m_symbolData);
+    }
+
+    results.clear();
+}
+
+void CompileBatch::AddFile(const std::string& fileName)
+{
+    Item item;
+    item.m_fileName = fileName;
+    m_items.push_back(std::move(item));
+}
+
+void CompileBatch::AddSource(std::vector<char>&& source)
+{
+    Item item;
+    item.m_source = std::move(source);
+    m_items.push_back(std::move(item));
+}
+
+void CompileBatch::CompileItem(Item& item, const amd_comgr_language_t& languageInfo, const std::string& isaName, CompileBatchResult& result)
+{
+    // Start from a clean error state on this worker thread.
+    CodeObj::GetLastError();
+
+    std::unique_ptr<CodeObj> pCodeObj;
+
+    if (!item.m_fileName.empty())
+    {
+        pCodeObj = CodeObj::OpenFile(item.m_fileName, AMD_COMGR_DATA_KIND_SOURCE);
+    }
+    else
+    {
+        pCodeObj = CodeObj::OpenBuffer(std::move(item.m_source), AMD_COMGR_DATA_KIND_SOURCE);
+    }
+
+    if (pCodeObj == nullptr || !pCodeObj->ConvertSourceToCodeObject(result.m_codeObject, languageInfo, isaName))
+    {
+        std::pair<amd_comgr_status_t, std::string> lastError = CodeObj::GetLastError();
+        result.m_status = (lastError.first != AMD_COMGR_STATUS_SUCCESS ? lastError.first : AMD_COMGR_STATUS_ERROR);
+        result.m_errMsg = lastError.second;
+        result.m_codeObject.clear();
     }
 }
+
+bool CompileBatch::Run(const amd_comgr_language_t& languageInfo, const std::string& isaName, std::vector<CompileBatchResult>& results)
+{
+    results.clear();
+    results.resize(m_items.size());
+
+    WorkerPool pool(m_numWorkers);
+    pool.ParallelFor(m_items.size(), [&](size_t index)
+    {
+        CompileItem(m_items[index], languageInfo, isaName, results[index]);
+    });
+
+    m_items.clear();
+
+    bool retCode = true;
+
+    for (const CompileBatchResult& result : results)
+    {
+        if (result.m_status != AMD_COMGR_STATUS_SUCCESS)
+        {
+            retCode = false;
+        }
+    }
+
+    return retCode;
+}
 }
@@ -7,8 +7,13 @@
 #ifndef COMGR_UTILS_H_
 #define COMGR_UTILS_H_
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #ifdef COMGR_DYNAMIC_LINKING
@@ -26,6 +31,52 @@ namespace AMDT
 {
 class MDNode;
 class CodeObj;
+class MetadataSnapshot;
+class PalDataAllocator;
+struct DisassemblyRange;
+class DiskCache;
+class ProcessPool;
+
+/// Read-only memory mapping of a file.
+class MappedFile
+{
+public:
+    /// Map the whole file into memory.
+    /// \param fileName the file name.
+    /// \return the unique_ptr pointing to the mapping, nullptr if the file could not be mapped.
+    static std::unique_ptr<MappedFile> Open(const std::string& fileName);
+
+    /// Destructor, unmaps the file.
+    ~MappedFile();
+
+    /// Get the mapped bytes.
+    /// \return pointer to the first byte of the mapping.
+    const char* GetData() const
+    {
+        return m_pData;
+    }
+
+    /// Get the size of the mapping.
+    /// \return the size in bytes.
+    size_t GetSize() const
+    {
+        return m_size;
+    }
+
+private:
+    /// Private constructor, use Open().
+    MappedFile() = default;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* m_pData = nullptr;   ///< The mapped bytes.
+    size_t      m_size = 0;          ///< The size of the mapping in bytes.
+#ifdef _WIN32
+    void*       m_hFile = nullptr;   ///< The file handle.
+    void*       m_hMapping = nullptr;///< The file mapping handle.
+#endif
+};
 
 // Singleton struct to hold the entry points of the comgr library
 struct ComgrEntryPoints
@@ -74,28 +125,39 @@ struct ComgrEntryPoints
     decltype(amd_comgr_iterate_symbols)*                        amd_comgr_iterate_symbols_fn;                        ///< comgr library entry point
     decltype(amd_comgr_symbol_lookup)*                          amd_comgr_symbol_lookup_fn;                          ///< comgr library entry point
     decltype(amd_comgr_symbol_get_info)*                        amd_comgr_symbol_get_info_fn;                        ///< comgr library entry point
+    decltype(amd_comgr_create_disassembly_info)*                amd_comgr_create_disassembly_info_fn;                ///< comgr library entry point, optional (nullptr if missing)
+    decltype(amd_comgr_destroy_disassembly_info)*               amd_comgr_destroy_disassembly_info_fn;               ///< comgr library entry point, optional (nullptr if missing)
+    decltype(amd_comgr_disassemble_instruction)*                amd_comgr_disassemble_instruction_fn;                ///< comgr library entry point, optional (nullptr if missing)
 
     /// Gets the static singleton instance
+    /// The instance is created exactly once, even when first requested from several threads.
     /// \return the singleton instance
     static ComgrEntryPoints* Instance()
     {
-        if (nullptr == m_pInstance)
+        ComgrEntryPoints* pInstance = m_pInstance.load(std::memory_order_acquire);
+
+        if (nullptr == pInstance)
         {
-            m_pInstance = new ComgrEntryPoints;
+            std::lock_guard<std::mutex> lock(m_instanceMutex);
+            pInstance = m_pInstance.load(std::memory_order_relaxed);
+
+            if (nullptr == pInstance)
+            {
+                pInstance = new ComgrEntryPoints;
+                m_pInstance.store(pInstance, std::memory_order_release);
+            }
         }
 
-        return m_pInstance;
+        return pInstance;
     }
 
     /// Deletes the static singleton instance
+    /// Must not be called while other threads are still using the entry points.
     static void DeleteInstance()
     {
-        if (nullptr != m_pInstance)
-        {
-            ComgrEntryPoints* pCopyOfInstance = m_pInstance;
-            m_pInstance = nullptr;
-            delete pCopyOfInstance;
-        }
+        std::lock_guard<std::mutex> lock(m_instanceMutex);
+        ComgrEntryPoints* pCopyOfInstance = m_pInstance.exchange(nullptr);
+        delete pCopyOfInstance;
     }
 
     /// Indicates if the comgr library entry points are valid
@@ -146,8 +208,11 @@ private:
         m_module = dlopen("libamd_comgr.so", RTLD_LAZY);
     #endif
         #define INIT_COMGR_ENTRY_POINT(func) reinterpret_cast<decltype(func)*>(InitEntryPoint(#func)); m_entryPointsValid &= nullptr != func##_fn
+        // Entry points that older comgr libraries lack; the features using them check for nullptr
+        #define INIT_OPTIONAL_COMGR_ENTRY_POINT(func) reinterpret_cast<decltype(func)*>(InitEntryPoint(#func))
 #else
         #define INIT_COMGR_ENTRY_POINT(func) func
+        #define INIT_OPTIONAL_COMGR_ENTRY_POINT(func) func
 #endif
         amd_comgr_status_string_fn = INIT_COMGR_ENTRY_POINT(amd_comgr_status_string);
         amd_comgr_get_version_fn = INIT_COMGR_ENTRY_POINT(amd_comgr_get_version);
@@ -193,7 +258,11 @@ private:
         amd_comgr_iterate_symbols_fn = INIT_COMGR_ENTRY_POINT(amd_comgr_iterate_symbols);
         amd_comgr_symbol_lookup_fn = INIT_COMGR_ENTRY_POINT(amd_comgr_symbol_lookup);
         amd_comgr_symbol_get_info_fn = INIT_COMGR_ENTRY_POINT(amd_comgr_symbol_get_info);
+        amd_comgr_create_disassembly_info_fn = INIT_OPTIONAL_COMGR_ENTRY_POINT(amd_comgr_create_disassembly_info);
+        amd_comgr_destroy_disassembly_info_fn = INIT_OPTIONAL_COMGR_ENTRY_POINT(amd_comgr_destroy_disassembly_info);
+        amd_comgr_disassemble_instruction_fn = INIT_OPTIONAL_COMGR_ENTRY_POINT(amd_comgr_disassemble_instruction);
         #undef INIT_COMGR_ENTRY_POINT
+        #undef INIT_OPTIONAL_COMGR_ENTRY_POINT
     }
 
     /// Destructor
@@ -209,13 +278,113 @@ private:
 #endif
         }
 #endif
-        DeleteInstance();
     }
 
 private:
-    static ComgrEntryPoints* m_pInstance; ///< static singleton instance
+    static std::atomic<ComgrEntryPoints*> m_pInstance;      ///< static singleton instance
+    static std::mutex                     m_instanceMutex;  ///< guards creation and deletion of the singleton instance
+};
+
+/// Owns a comgr handle and releases it through a ComgrEntryPoints entry point when it goes out of
+/// scope, including on the early returns of CheckStatus. Move-only; a handle of 0 is empty.
+/// \tparam HANDLE the comgr handle type.
+/// \tparam pRelease the entry point releasing the handle.
+template<typename HANDLE, amd_comgr_status_t (*ComgrEntryPoints::*pRelease)(HANDLE)>
+class ComgrHandle
+{
+public:
+    /// Constructor, creates an empty handle.
+    ComgrHandle() : m_handle() {}
+
+    /// Constructor, takes ownership of a handle.
+    /// \param handle the handle.
+    explicit ComgrHandle(HANDLE handle) : m_handle(handle) {}
+
+    /// Move constructor.
+    /// \param other the handle to take ownership from; it is left empty.
+    ComgrHandle(ComgrHandle&& other) : m_handle(other.Release()) {}
+
+    /// Move assignment.
+    /// \param other the handle to take ownership from; it is left empty.
+    /// \return this handle.
+    ComgrHandle& operator=(ComgrHandle&& other)
+    {
+        if (this != &other)
+        {
+            Reset(other.Release());
+        }
+
+        return *this;
+    }
+
+    /// Destructor, releases the handle.
+    ~ComgrHandle()
+    {
+        Reset();
+    }
+
+    /// Get the handle, keeping ownership.
+    /// \return the handle.
+    HANDLE Get() const
+    {
+        return m_handle;
+    }
+
+    /// Release the current handle and get the address to receive a new one from a comgr create function.
+    /// \return the address of the handle.
+    HANDLE* Receive()
+    {
+        Reset();
+        return &m_handle;
+    }
+
+    /// Give up ownership of the handle without releasing it.
+    /// \return the handle.
+    HANDLE Release()
+    {
+        HANDLE handle = m_handle;
+        m_handle = HANDLE();
+        return handle;
+    }
+
+    /// Release the current handle and take ownership of another one.
+    /// \param handle the new handle, empty by default.
+    void Reset(HANDLE handle = HANDLE())
+    {
+        if (m_handle.handle != 0)
+        {
+            (ComgrEntryPoints::Instance()->*pRelease)(m_handle);
+        }
+
+        m_handle = handle;
+    }
+
+    /// Check if a handle is owned.
+    /// \return true if the handle is not empty, false otherwise.
+    bool IsValid() const
+    {
+        return m_handle.handle != 0;
+    }
+
+private:
+    ComgrHandle(const ComgrHandle&) = delete;
+    ComgrHandle& operator=(const ComgrHandle&) = delete;
+
+    HANDLE m_handle;    ///< The owned handle.
 };
 
+/// Owned comgr data.
+typedef ComgrHandle<amd_comgr_data_t, &ComgrEntryPoints::amd_comgr_release_data_fn> ComgrData;
+
+/// Owned comgr data set.
+typedef ComgrHandle<amd_comgr_data_set_t, &ComgrEntryPoints::amd_comgr_destroy_data_set_fn> ComgrDataSet;
+
+/// Owned comgr action info.
+typedef ComgrHandle<amd_comgr_action_info_t, &ComgrEntryPoints::amd_comgr_destroy_action_info_fn> ComgrActionInfo;
+
+/// Owned comgr metadata node.
+typedef ComgrHandle<amd_comgr_metadata_node_t, &ComgrEntryPoints::amd_comgr_destroy_metadata_fn> ComgrMetadataNode;
+
 /// PAL pipeline version struct
 struct PalPipelineVersion
 {
@@ -318,8 +487,9 @@ struct PalPipelineData
     PalPipelineVersion  m_version;         ///< PAL version info
     uint32_t            m_numPipelines;    ///< Number of pipelines
     Pipeline*           m_pPipelines;      ///< the pipelines itself
+    void*               m_pArena;          ///< Arena holding all of the data above (COMGR_UTILS_PAL_LAYOUT_ARENA), nullptr otherwise
     /// Default constructor
-    PalPipelineData():m_version(), m_numPipelines(0), m_pPipelines(nullptr){}
+    PalPipelineData():m_version(), m_numPipelines(0), m_pPipelines(nullptr), m_pArena(nullptr){}
 };
 
 enum CodeObjSymbolType
@@ -368,58 +538,244 @@ struct CodeObjSymbol
 /// Code object symbols
 struct CodeObjSymbolInfo
 {
-    uint32_t        m_numSymbols;    ///< Number of symbols
-    CodeObjSymbol*  m_pSymbols;      ///< the symbols
+    uint32_t        m_numSymbols;       ///< Number of symbols
+    CodeObjSymbol*  m_pSymbols;         ///< the symbols
+    char*           m_pNamePool;        ///< All symbol names back to back, null terminated; nullptr if the names are in the code object
+    bool            m_namesInCodeObj;   ///< Symbol names point into the code object's string table and are valid only while the CodeObj is alive
 
     // Default constructor
-    CodeObjSymbolInfo(): m_numSymbols(0), m_pSymbols(nullptr){}
-};
-
-extern const char*  gs_PAL_MD_TAG_PIPELINE_VERSION;
-extern const char*  gs_PAL_MD_TAG_PIPELINE_VERSION_MAJOR;
-extern const char*  gs_PAL_MD_TAG_PIPELINE_VERSION_MINOR;
-extern const char*  gs_PAL_MD_TAG_PIPELINE_NAME;
-extern const char*  gs_PAL_MD_TAG_PIPELINE_TYPE;
-extern const char*  gs_PAL_MD_TAG_PIPELINE_HASH;
-extern const char*  gs_PAL_MD_TAG_PIPELINES;
-extern const char*  gs_PAL_MD_TAG_SHADERS;
-extern const char*  gs_PAL_MD_TAG_SHADER_TYPE_VERTEX;
-extern const char*  gs_PAL_MD_TAG_SHADER_TYPE_GEOMETRY;
-extern const char*  gs_PAL_MD_TAG_SHADER_TYPE_PIXEL;
-extern const char*  gs_PAL_MD_TAG_SHADER_TYPE_COMPUTE;
-extern const char*  gs_PAL_MD_TAG_SHADER_HASH;
-extern const char*  gs_PAL_MD_TAG_SHADER_HARDWARE_MAPPING;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGES;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_LS;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_HS;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_ES;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_GS;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_VS;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_PS;
-extern const char*  gs_PAL_MD_TAG_HARDWARE_STAGE_CS;
-extern const char*  gs_PAL_MD_TAG_ENTRY_POINT_SYMBOL_NAME;
-extern const char*  gs_PAL_MD_TAG_SCRATCH_MEMORY_SIZE;
-extern const char*  gs_PAL_MD_TAG_LOCAL_DATA_SHARE_SIZE;
-extern const char*  gs_PAL_MD_TAG_PERF_DATA_BUFFER_SIZE;
-extern const char*  gs_PAL_MD_TAG_NUM_USED_VGPRS;
-extern const char*  gs_PAL_MD_TAG_NUM_USED_SGPRS;
-extern const char*  gs_PAL_MD_TAG_NUM_AVAILABLE_VGPRS;
-extern const char*  gs_PAL_MD_TAG_NUM_AVAILABLE_SGPRS;
-extern const char*  gs_PAL_MD_TAG_WAVES_PER_GROUP;
-extern const char*  gs_PAL_MD_TAG_USES_UAVS;
-extern const char*  gs_PAL_MD_TAG_USES_ROVS;
-extern const char*  gs_PAL_MD_TAG_WRITES_UAVS;
-extern const char*  gs_PAL_MD_TAG_WRITES_DEPTH;
-extern const char*  gs_PAL_MD_TAG_MAX_PRIMS_PER_PS_WAVE;
-extern const char*  gs_PAL_MD_TAG_NUM_INTERPOLANTS;
-extern const char*  gs_PAL_MD_TAG_REGISTERS;
-extern const char*  gs_PAL_MD_TAG_USER_DATA_LIMIT;
-extern const char*  gs_PAL_MD_TAG_SPILL_SHRESHOLD;
-extern const char*  gs_PAL_MD_TAG_USES_VIEWPORT_ARRAY_INDEX;
-extern const char*  gs_PAL_MD_TAG_ES_GS_LOCAL_DATA_SHARE_SIZE;
-extern const char*  gs_PAL_MD_TAG_WAVEFRONT_SIZE;
-extern const char*  gs_PAL_MD_TAG_API;
-extern const char*  gs_PAL_MD_TAG_API_CREATE_INFO;
+    CodeObjSymbolInfo(): m_numSymbols(0), m_pSymbols(nullptr), m_pNamePool(nullptr), m_namesInCodeObj(false){}
+};
+
+/// Name-to-symbol hash index, also used to intern metadata keys.
+/// Names are interned: each distinct name is copied once into storage owned by the index,
+/// so the index does not depend on the lifetime of the symbol data it was built from.
+/// Lookups hash the name with FNV-1a and probe an open-addressing table.
+class SymbolNameIndex
+{
+public:
+    /// Returned when a name is not in the index.
+    static const uint32_t s_INVALID_SYMBOL_INDEX = 0xFFFFFFFF;
+
+    /// Constructor, creates an empty index.
+    SymbolNameIndex() : m_numNames(0), m_chunkUsed(0), m_chunkSize(0) {}
+
+    /// Build the index from the function symbols, replacing any previous content.
+    /// If several symbols share a name, the first one is kept.
+    /// \param data the symbol data returned by CodeObj::ExtractSymbolData.
+    void Build(const CodeObjSymbolInfo& data);
+
+    /// Remove all names from the index and release the interned names.
+    void Clear();
+
+    /// Add a name to the index. If the name is already present, its symbol index is kept.
+    /// \param pName the name, not necessarily null terminated.
+    /// \param nameLen the length of the name.
+    /// \param symbolIndex the value to associate with the name.
+    /// \return the interned, null terminated copy of the name, valid until the index is cleared or destroyed.
+    const char* Insert(const char* pName, size_t nameLen, uint32_t symbolIndex);
+
+    /// Find a name.
+    /// \param pName the name, not necessarily null terminated.
+    /// \param nameLen the length of the name.
+    /// \return the symbol index associated with the name, or s_INVALID_SYMBOL_INDEX.
+    uint32_t Find(const char* pName, size_t nameLen) const;
+
+    /// Find a name.
+    /// \param name the name.
+    /// \return the symbol index associated with the name, or s_INVALID_SYMBOL_INDEX.
+    uint32_t Find(const std::string& name) const
+    {
+        return Find(name.data(), name.size());
+    }
+
+    /// Get the number of distinct names in the index.
+    /// \return the number of names.
+    size_t GetNumNames() const
+    {
+        return m_numNames;
+    }
+
+private:
+    /// One hash table slot; empty slots have a null m_pName.
+    struct Slot
+    {
+        uint64_t    m_hash;         ///< The hash of the name.
+        const char* m_pName;        ///< The interned name.
+        size_t      m_nameLen;      ///< The length of the name.
+        uint32_t    m_symbolIndex;  ///< The value associated with the name.
+    };
+
+    /// Copy a name into the interned name storage.
+    /// \param pName the name.
+    /// \param nameLen the length of the name.
+    /// \return the null terminated copy.
+    const char* InternName(const char* pName, size_t nameLen);
+
+    /// Double the number of hash table slots and rehash the names.
+    void Grow();
+
+    std::vector<Slot>                       m_slots;        ///< Open-addressing hash table, the size is a power of 2.
+    size_t                                  m_numNames;     ///< The number of occupied slots.
+    std::vector<std::unique_ptr<char[]>>    m_nameChunks;   ///< Interned name storage; chunks never move once allocated.
+    size_t                                  m_chunkUsed;    ///< Bytes used in the last chunk.
+    size_t                                  m_chunkSize;    ///< Size of the last chunk in bytes.
+};
+
+/// Backend used to parse the contents of a code object.
+enum CodeObjParseBackend
+{
+    COMGR_UTILS_PARSE_BACKEND_AUTO = 0,     ///< Use the native ComgrUtils parser and fall back to comgr if it fails.
+    COMGR_UTILS_PARSE_BACKEND_NATIVE,       ///< Only use the native ComgrUtils parser.
+    COMGR_UTILS_PARSE_BACKEND_COMGR         ///< Only use the comgr library.
+};
+
+/// Memory layout of extracted PAL pipeline data
+enum PalPipelineDataLayout
+{
+    COMGR_UTILS_PAL_LAYOUT_SEPARATE = 0,    ///< Every array and string is a separate malloc allocation.
+    COMGR_UTILS_PAL_LAYOUT_ARENA            ///< Everything lives in one arena block that ClearPalPipelineData releases at once.
+};
+
+/// Registry of the PAL metadata tags, X(TAG, key string). Each entry defines PalMDTag::TAG
+/// and the gs_PAL_MD_TAG_TAG key string.
+#define COMGR_UTILS_PAL_MD_TAGS(X) \
+    X(PIPELINE_VERSION,            "amdpal.version") \
+    X(PIPELINE_NAME,               ".name") \
+    X(PIPELINE_TYPE,               ".type") \
+    X(PIPELINE_HASH,               ".pipeline_compiler_hash") \
+    X(PIPELINES,                   "amdpal.pipelines") \
+    X(SHADERS,                     ".shaders") \
+    X(SHADER_TYPE_VERTEX,          ".vertex") \
+    X(SHADER_TYPE_HULL,            ".hull") \
+    X(SHADER_TYPE_DOMAIN,          ".domain") \
+    X(SHADER_TYPE_GEOMETRY,        ".geometry") \
+    X(SHADER_TYPE_PIXEL,           ".pixel") \
+    X(SHADER_TYPE_COMPUTE,         ".compute") \
+    X(SHADER_HASH,                 ".api_shader_hash") \
+    X(SHADER_HARDWARE_MAPPING,     ".hardware_mapping") \
+    X(HARDWARE_STAGES,             ".hardware_stages") \
+    X(HARDWARE_STAGE_LS,           ".ls") \
+    X(HARDWARE_STAGE_HS,           ".hs") \
+    X(HARDWARE_STAGE_ES,           ".es") \
+    X(HARDWARE_STAGE_GS,           ".gs") \
+    X(HARDWARE_STAGE_VS,           ".vs") \
+    X(HARDWARE_STAGE_PS,           ".ps") \
+    X(HARDWARE_STAGE_CS,           ".cs") \
+    X(ENTRY_POINT_SYMBOL_NAME,     ".entry_point") \
+    X(SCRATCH_MEMORY_SIZE,         ".scratch_memory_size") \
+    X(LOCAL_DATA_SHARE_SIZE,       ".lds_size") \
+    X(PERF_DATA_BUFFER_SIZE,       "PerformanceDataBufferSize") \
+    X(NUM_USED_VGPRS,              ".vgpr_count") \
+    X(NUM_USED_SGPRS,              ".sgpr_count") \
+    X(NUM_AVAILABLE_VGPRS,         ".vgpr_limit") \
+    X(NUM_AVAILABLE_SGPRS,         ".sgpr_limit") \
+    X(WAVES_PER_GROUP,             ".waves_per_group") \
+    X(USES_UAVS,                   ".uses_uavs") \
+    X(USES_ROVS,                   ".uses_rovs") \
+    X(WRITES_UAVS,                 ".writes_uavs") \
+    X(WRITES_DEPTH,                ".writes_depth") \
+    X(MAX_PRIMS_PER_PS_WAVE,       ".max_prims_per_ps_wave") \
+    X(NUM_INTERPOLANTS,            ".num_interpolants") \
+    X(REGISTERS,                   ".registers") \
+    X(USER_DATA_LIMIT,             ".user_data_limit") \
+    X(SPILL_SHRESHOLD,             ".spill_threshold") \
+    X(USES_VIEWPORT_ARRAY_INDEX,   ".uses_viewport_array_index") \
+    X(ES_GS_LOCAL_DATA_SHARE_SIZE, ".es_gs_lds_size") \
+    X(WAVEFRONT_SIZE,              ".wavefront_size") \
+    X(API,                         ".api") \
+    X(API_CREATE_INFO,             ".api_create_info")
+
+/// PAL metadata tag ids.
+enum class PalMDTag : uint8_t
+{
+#define COMGR_UTILS_PAL_MD_TAG_ENUM(TAG, KEY) TAG,
+    COMGR_UTILS_PAL_MD_TAGS(COMGR_UTILS_PAL_MD_TAG_ENUM)
+#undef COMGR_UTILS_PAL_MD_TAG_ENUM
+    Count,      ///< The number of tags in the registry.
+    Unknown     ///< The key is not in the registry.
+};
+
+// The metadata key strings.
+#define COMGR_UTILS_PAL_MD_TAG_STRING(TAG, KEY) constexpr const char* gs_PAL_MD_TAG_##TAG = KEY;
+COMGR_UTILS_PAL_MD_TAGS(COMGR_UTILS_PAL_MD_TAG_STRING)
+#undef COMGR_UTILS_PAL_MD_TAG_STRING
+
+/// The metadata key strings, indexed by PalMDTag.
+constexpr const char* gs_PAL_MD_TAG_NAMES[] =
+{
+#define COMGR_UTILS_PAL_MD_TAG_NAME(TAG, KEY) KEY,
+    COMGR_UTILS_PAL_MD_TAGS(COMGR_UTILS_PAL_MD_TAG_NAME)
+#undef COMGR_UTILS_PAL_MD_TAG_NAME
+};
+
+/// The lengths of the metadata key strings, indexed by PalMDTag.
+constexpr size_t gs_PAL_MD_TAG_LENGTHS[] =
+{
+#define COMGR_UTILS_PAL_MD_TAG_LENGTH(TAG, KEY) sizeof(KEY) - 1,
+    COMGR_UTILS_PAL_MD_TAGS(COMGR_UTILS_PAL_MD_TAG_LENGTH)
+#undef COMGR_UTILS_PAL_MD_TAG_LENGTH
+};
+
+/// Resolve a metadata key to its tag with one hash and one string comparison.
+/// \param pKey the key, not necessarily null terminated.
+/// \param keyLen the length of the key.
+/// \return the tag, PalMDTag::Unknown if the key is not in the registry.
+PalMDTag LookupPalMDTag(const char* pKey, size_t keyLen);
+
+/// Resolve a metadata key to its tag.
+/// \param key the key.
+/// \return the tag, PalMDTag::Unknown if the key is not in the registry.
+inline PalMDTag LookupPalMDTag(const std::string& key)
+{
+    return LookupPalMDTag(key.data(), key.size());
+}
+
+/// Get the key string of a tag.
+/// \param tag the tag.
+/// \return the key string, "" for PalMDTag::Unknown.
+constexpr const char* GetPalMDTagName(PalMDTag tag)
+{
+    return tag < PalMDTag::Count ? gs_PAL_MD_TAG_NAMES[static_cast<size_t>(tag)] : "";
+}
+
+/// Result of decoding a number from a metadata string.
+enum class MDNumberStatus
+{
+    Success = 0,    ///< The whole string is a number that fits the requested type.
+    Invalid,        ///< The string is empty, not a number or the node is not a string.
+    Overflow        ///< The string is a number that does not fit the requested type.
+};
+
+/// Key and value of one entry of a metadata map of numbers, see MDNode::DecodeUnsignedMap.
+struct MDUnsignedEntry
+{
+    uint64_t m_key;     ///< The decoded key.
+    uint64_t m_value;   ///< The decoded value.
+};
+
+/// Non-owning view of a metadata string, the C++14 stand-in for std::string_view.
+struct MDStringView
+{
+    const char* m_pData;    ///< The string, null terminated.
+    size_t      m_size;     ///< The length of the string, without the null terminator.
+};
+
+/// Decode an unsigned number from a metadata string, without allocating.
+/// Decimal and "0x" prefixed hexadecimal numbers are accepted, as are "true" (1) and "false" (0).
+/// \param pStr the string, not necessarily null terminated.
+/// \param length the length of the string.
+/// \param value receives the number, unchanged unless successful.
+/// \return the decode status.
+MDNumberStatus ParseMDUnsigned(const char* pStr, size_t length, uint64_t& value);
+
+/// Decode a signed number from a metadata string, without allocating.
+/// Accepts the same strings as ParseMDUnsigned, optionally preceded by '-'.
+/// \param pStr the string, not necessarily null terminated.
+/// \param length the length of the string.
+/// \param value receives the number, unchanged unless successful.
+/// \return the decode status.
+MDNumberStatus ParseMDSigned(const char* pStr, size_t length, int64_t& value);
 
 #define CheckStatus(status, retVal) \
         if (status != AMD_COMGR_STATUS_SUCCESS) \
@@ -454,11 +810,17 @@ extern const char*  gs_PAL_MD_TAG_API_CREATE_INFO;
 /// Callback function for amd_comgr_iterate_map_metadata.
 /// \param key amd_comgr_metadata_node_t type key.
 /// \param val amd_comgr_metadata_node_t type value.
-/// \param data callback data pointer.
+/// \param data callback data pointer, a std::vector<std::string> that receives the keys.
 /// \return AMD COMGR status.
 extern "C" amd_comgr_status_s MapIterCallback(amd_comgr_metadata_node_t key, amd_comgr_metadata_node_t val, void* data);
 
 /// Code Object class.
+///
+/// Thread safety: the comgr entry points are initialized once on first use and the error
+/// returned by GetLastError() is kept per thread, so distinct CodeObj instances (and the
+/// MDNodes obtained from them) can be used concurrently from multiple threads. A single
+/// CodeObj instance must not be used from several threads at once without external locking.
+/// This relies on the comgr library itself being thread-safe.
 class CodeObj
 {
     friend class MDNode;
@@ -474,6 +836,19 @@ public:
     /// \return the unique_ptr pointing to the Codeobj object.
     static std::unique_ptr<CodeObj> OpenFile(const std::string& fileName, const amd_comgr_data_kind_t& dataKind);
 
+    /// Open Code Object from a memory mapped file.
+    /// The CodeObj keeps the read-only mapping alive instead of reading the file into a buffer.
+    /// \param fileName the file name.
+    /// \return the unique_ptr pointing to the Codeobj object.
+    static std::unique_ptr<CodeObj> OpenMapped(const std::string& fileName);
+
+    /// Open Code Object from a memory mapped file.
+    /// The CodeObj keeps the read-only mapping alive instead of reading the file into a buffer.
+    /// \param fileName the file name.
+    /// \param dataKind the data kind.
+    /// \return the unique_ptr pointing to the Codeobj object.
+    static std::unique_ptr<CodeObj> OpenMapped(const std::string& fileName, const amd_comgr_data_kind_t& dataKind);
+
     /// Open Code Object from a memory buffer.
     /// \param buf the memory buffer.
     /// \return the unique_ptr pointing to the Codeobj object.
@@ -485,44 +860,180 @@ public:
     /// \return the unique_ptr pointing to the Codeobj object.
     static std::unique_ptr<CodeObj> OpenBuffer(const std::vector<char>& buf, const amd_comgr_data_kind_t& dataKind);
 
+    /// Open Code Object from a memory buffer, taking ownership of the buffer.
+    /// \param buf the memory buffer, moved into the CodeObj.
+    /// \return the unique_ptr pointing to the Codeobj object.
+    static std::unique_ptr<CodeObj> OpenBuffer(std::vector<char>&& buf);
+
+    /// Open Code Object from a memory buffer, taking ownership of the buffer.
+    /// \param buf the memory buffer, moved into the CodeObj.
+    /// \param dataKind the data kind.
+    /// \return the unique_ptr pointing to the Codeobj object.
+    static std::unique_ptr<CodeObj> OpenBuffer(std::vector<char>&& buf, const amd_comgr_data_kind_t& dataKind);
+
     /// Open Code Object from a char buffer.
     /// \param pBuf the memory buffer.
     /// \return the unique_ptr pointing to the Codeobj object.
     static std::unique_ptr<CodeObj> OpenBufferRaw(const char* pBuf, size_t sizeInBytes);
 
+    /// Open Code Object from caller-owned memory without copying it.
+    /// The memory must stay valid and unchanged for the lifetime of the returned CodeObj.
+    /// \param pBuf the memory buffer.
+    /// \param sizeInBytes the size of the memory buffer in bytes.
+    /// \return the unique_ptr pointing to the Codeobj object.
+    static std::unique_ptr<CodeObj> OpenBufferView(const char* pBuf, size_t sizeInBytes);
+
+    /// Open Code Object from caller-owned memory without copying it.
+    /// The memory must stay valid and unchanged for the lifetime of the returned CodeObj.
+    /// \param pBuf the memory buffer.
+    /// \param sizeInBytes the size of the memory buffer in bytes.
+    /// \param dataKind the data kind.
+    /// \return the unique_ptr pointing to the Codeobj object.
+    static std::unique_ptr<CodeObj> OpenBufferView(const char* pBuf, size_t sizeInBytes, const amd_comgr_data_kind_t& dataKind);
+
     /// Extract Metadata (MD).
     /// \return the metadata node.
     MDNode GetMD();
 
+    /// Get a materialized copy of the metadata tree.
+    /// The snapshot is built with one walk over the comgr metadata on the first call and
+    /// kept by the CodeObj, so later queries do not call into comgr at all.
+    /// \return the snapshot owned by this CodeObj, nullptr if the metadata could not be read.
+    const MetadataSnapshot* GetMDSnapshot();
+
     /// Extract the PAL Pipeline metadata and fill the provided structure.
+    /// Uses the native MsgPack decoder and falls back to comgr if it fails.
     /// \param data the PalPipelineData type data.
     /// \return true if successful, false otherwise.
     bool ExtractPalPipelineData(PalPipelineData& data);
 
+    /// Extract the PAL Pipeline metadata and fill the provided structure.
+    /// \param data the PalPipelineData type data.
+    /// \param backend the backend used to parse the metadata.
+    /// \return true if successful, false otherwise.
+    bool ExtractPalPipelineData(PalPipelineData& data, CodeObjParseBackend backend);
+
+    /// Extract the PAL Pipeline metadata and fill the provided structure.
+    /// With the arena layout the pipelines, names, shader, stage and register lists are carved out of
+    /// one block sized from the metadata note, so ClearPalPipelineData is a single free in the common case.
+    /// \param data the PalPipelineData type data.
+    /// \param backend the backend used to parse the metadata.
+    /// \param layout the memory layout of the extracted data.
+    /// \return true if successful, false otherwise.
+    bool ExtractPalPipelineData(PalPipelineData& data, CodeObjParseBackend backend, PalPipelineDataLayout layout);
+
     /// Extract the symbol info and fill the provided structure.
+    /// Reads the ELF symbol table directly and falls back to comgr if it can not be parsed.
+    /// The function symbols are the STT_FUNC and STT_AMDGPU_HSA_KERNEL entries of the table; a code
+    /// object without any succeeds with no symbols.
+    /// The symbol names are owned by data and stay valid after the CodeObj is destroyed.
     /// \param data the Symbol structure
     /// \return true if successful, false otherwise.
     bool ExtractSymbolData(CodeObjSymbolInfo& data);
 
+    /// Extract the symbol info and fill the provided structure.
+    /// With COMGR_UTILS_PARSE_BACKEND_NATIVE the symbol names are not copied, they point into the
+    /// code object's string table (m_namesInCodeObj is set), so the symbol data must be cleared
+    /// before the CodeObj is destroyed. With the other backends the names are owned by data.
+    /// \param data the Symbol structure
+    /// \param backend the backend used to read the symbols.
+    /// \return true if successful, false otherwise.
+    bool ExtractSymbolData(CodeObjSymbolInfo& data, CodeObjParseBackend backend);
+
+    /// Find a function symbol by name.
+    /// The first call builds a hashed name index over the function symbols of the code object;
+    /// names missing from it are looked up through comgr and added to the index.
+    /// \param name the symbol name.
+    /// \param symbol receives the symbol; its name stays valid for the lifetime of the CodeObj.
+    /// \return true if a function symbol with that name exists, false otherwise.
+    bool FindSymbol(const std::string& name, CodeObjSymbol& symbol);
+
     /// Extract the assembly data to a data buffer.
     /// \param assemblyBuffer the memory buffer of assembly data.
     /// \param options the options for extracting assembly buffer.
     /// \return true if successful, false otherwise.
     bool ExtractAssemblyData(std::vector<char>& assemblyBuffer, std::string options);
 
+    /// Disassemble the code object into a function listing. The listing is its own format, not the
+    /// text of the comgr disassembly action of ExtractAssemblyData: the executable sections are
+    /// listed in address order, every function symbol as a "name:" line followed by one line per
+    /// instruction with its address and encoding, then an empty line. The bytes of a section that
+    /// no function symbol covers are listed under a "section+0xoffset:" line as .long data words,
+    /// without decoding, so no code byte is left out. With more than one worker the functions are
+    /// split into contiguous groups, each disassembled on a worker thread with its own comgr
+    /// disassembler, and the text is identical for any number of workers.
+    /// Requires a comgr library with amd_comgr_disassemble_instruction.
+    /// \param listingBuffer receives the listing.
+    /// \param isaName the ISA name, like the options of ExtractAssemblyData.
+    /// \param numWorkers the number of worker threads, 1 to list on the calling thread, 0 for one per hardware thread.
+    /// \return true if successful, false otherwise.
+    bool ExtractFunctionListing(std::vector<char>& listingBuffer, const std::string& isaName, uint32_t numWorkers);
+
+    /// Keep the results of ExtractAssemblyData and ExtractFunctionListing in a directory, shared by
+    /// all CodeObj instances and processes using it. Entries are keyed by a hash of the code object
+    /// bytes, the options or ISA name, which of the two produced the text, the comgr version and the
+    /// path, size and modification time of the comgr binary. The least recently used entries are
+    /// deleted when the directory exceeds the size cap. The cache is disabled by default.
+    /// \param directory the cache directory, created if missing; empty to disable the cache.
+    /// \param maxSizeInBytes the size cap of the cache entries, 0 for no cap.
+    static void SetDisassemblyDiskCache(const std::string& directory, uint64_t maxSizeInBytes);
+
     /// Extract the assembly size in bytes to a data buffer.
+    /// The disassembly is kept per options string until ExtractAssemblyRaw with the same options
+    /// copies it, so that call does not disassemble again. See ReleaseAssemblyCache.
     /// \param options the options for extracting assembly buffer.
     /// \param outSizeInByes pointer to a uint to get size in bytes
     /// \return true if successful, false otherwise.
     bool ExtractAssemblySizeInBytes(const char* options, uint32_t* outSizeInByes);
 
     /// Extract the assembly size in bytes to a data buffer.
+    /// Uses the disassembly kept by an earlier call with the same options, if any, and releases it
+    /// once it was copied; a copy that fails keeps it for the next attempt.
     /// \param options the options for extracting assembly buffer.
     /// \param sizeInbyes the size in bytes of the input buffer, to validate memory is enough
     /// \param outData The buffer that will be filled with ISA
     /// \return true if successful, false otherwise.
     bool ExtractAssemblyRaw(const char* options, const uint32_t sizeInbyes, char* outData);
 
+    /// Callback receiving function listing text, see ExtractFunctionListingStream.
+    /// \param pText the text, not null terminated; it holds whole lines only.
+    /// \param size the size of the text in bytes.
+    /// \param pUserData the user data passed to ExtractFunctionListingStream.
+    /// \return true to continue, false to stop the listing.
+    typedef bool (*ListingTextCallback)(const char* pText, size_t size, void* pUserData);
+
+    /// Produce the function listing of ExtractFunctionListing on the calling thread and hand the
+    /// text to a callback in chunks, so the whole listing is never held in memory. The chunks
+    /// joined in order are byte for byte the text of ExtractFunctionListing; like it, this is not
+    /// a streaming form of the comgr text of ExtractAssemblyData.
+    /// \param isaName the ISA name, like the options of ExtractAssemblyData.
+    /// \param chunkSize the maximum size of a chunk, only exceeded by a single line that is longer.
+    /// \param pCallback the callback receiving the chunks.
+    /// \param pUserData user data passed to the callback.
+    /// \return true if successful, false if the listing failed or the callback stopped it.
+    bool ExtractFunctionListingStream(const char* isaName, size_t chunkSize, ListingTextCallback pCallback, void* pUserData);
+
+    /// Disassemble a single function from its symbol range, instead of the whole code object.
+    /// The text is the part of the ExtractFunctionListing listing for the function. The comgr
+    /// disassembler of the last ISA is kept by the CodeObj, so later functions of the same ISA
+    /// only pay for their own instructions.
+    /// \param symbol the function symbol, from ExtractSymbolData or FindSymbol.
+    /// \param isaName the ISA name, like the options of ExtractAssemblyData.
+    /// \param assemblyBuffer receives the disassembly text.
+    /// \return true if successful, false if the symbol has no code bytes or the disassembly failed.
+    bool DisassembleFunction(const CodeObjSymbol& symbol, const std::string& isaName, std::vector<char>& assemblyBuffer);
+
+    /// Disassemble a single function, found by its name with FindSymbol.
+    /// \param name the function name.
+    /// \param isaName the ISA name, like the options of ExtractAssemblyData.
+    /// \param assemblyBuffer receives the disassembly text.
+    /// \return true if successful, false otherwise.
+    bool DisassembleFunction(const std::string& name, const std::string& isaName, std::vector<char>& assemblyBuffer);
+
+    /// Release the disassembly kept by ExtractAssemblySizeInBytes that ExtractAssemblyRaw did not
+    /// copy yet, and the disassembler kept by DisassembleFunction.
+    void ReleaseAssemblyCache();
+
     /// Convert the source data to a code object.
     /// \param codeObjectBuffer the memory buffer of code object.
     /// \param languageInfo the language info for source data.
@@ -530,20 +1041,57 @@ public:
     /// \return true if successful, false otherwise.
     bool ConvertSourceToCodeObject(std::vector<char>& codeObjectBuffer, const amd_comgr_language_t& languageInfo, const std::string& isaName);
 
-    /// Clear the PAL pipeline data.
+    /// Keep the results of ConvertSourceToCodeObject in a directory, shared by all CodeObj instances
+    /// and processes using it. Entries are keyed by a hash of the source bytes, the language, the ISA
+    /// name, the compile options, the comgr version and the path, size and modification time of the
+    /// comgr binary; a hit returns the executable without running any comgr action. The least
+    /// recently used entries are deleted when the directory exceeds the size cap. The cache is
+    /// disabled by default.
+    /// \param directory the cache directory, created if missing; empty to disable the cache.
+    /// \param maxSizeInBytes the size cap of the cache entries, 0 for no cap.
+    static void SetCompileDiskCache(const std::string& directory, uint64_t maxSizeInBytes);
+
+    /// Release the precompiled headers and device libraries kept by ConvertSourceToCodeObject.
+    /// They only depend on the language and the ISA, so the first compile of each pair creates
+    /// them and later compiles reuse them. They are kept until this is called; compiles still
+    /// running keep the ones they use until they finish.
+    static void ReleaseCompileDataSets();
+
+    /// Run the comgr actions of ExtractAssemblyData and of ConvertSourceToCodeObject in a pool of
+    /// forked worker processes instead of the calling process. The code object or source is passed to a worker through shared memory and the result
+    /// comes back the same way, so callers see no difference. Concurrent calls run on different
+    /// workers; a worker that crashes or does not answer in time fails only its own call and is replaced.
+    /// Call it before starting other threads: it forks a spawner process, which forks the workers
+    /// now and later replaces failed ones, so the calling process itself is not forked again. POSIX only.
+    /// \param numWorkers the number of worker processes, 0 for one per hardware thread.
+    /// \param timeoutInSeconds the time a worker has to finish a call before it is killed, 0 for no limit.
+    /// \return true if the workers were started, false otherwise; the actions then stay in process.
+    static bool EnableProcessPool(uint32_t numWorkers, uint32_t timeoutInSeconds = 300);
+
+    /// Stop the worker processes; comgr actions run in the calling process again.
+    static void DisableProcessPool();
+
+    /// Clear the PAL pipeline data, whichever layout it was extracted with.
     /// \param data the PalPipelineData type data.
     static void ClearPalPipelineData(PalPipelineData& data);
 
+    /// Compare two sets of PAL pipeline data field by field.
+    /// Used to check that the native and comgr backends produce the same output.
+    /// \param lhs the first PalPipelineData.
+    /// \param rhs the second PalPipelineData.
+    /// \return true if both hold the same data, false otherwise.
+    static bool ComparePalPipelineData(const PalPipelineData& lhs, const PalPipelineData& rhs);
+
     /// Clear the symbol data
     /// \param data the symbol data
     static void ClearSymbolData(CodeObjSymbolInfo& data);
 
-    /// Get the error caused by last unsuccessful operation.
+    /// Get the error caused by last unsuccessful operation on the calling thread.
     /// Restores the error value to "success".
     /// \return the pair of AMD COMGR status and error message string.
     static std::pair<amd_comgr_status_t, std::string> GetLastError();
 
-    /// Set error.
+    /// Set error for the calling thread.
     /// \param err the error status.
     /// \param errMsg the error message string.
     /// \return true if successful, false otherwise.
@@ -551,43 +1099,235 @@ public:
 
     /// Constructor.
     /// \param buf the memory buffer.
-    /// \param coData the amd_comgr_data_t type data.
-    /// \param coDataSet the amd_comgr_data_set_t data set.
-    CodeObj(const std::vector<char>& buf, amd_comgr_data_t coData, amd_comgr_data_set_t coDataSet) : m_buf(buf), m_data(coData), m_dataSet(coDataSet) {}
+    /// \param coData the amd_comgr_data_t type data, owned by the CodeObj.
+    /// \param coDataSet the amd_comgr_data_set_t data set, owned by the CodeObj.
+    CodeObj(const std::vector<char>& buf, ComgrData&& coData, ComgrDataSet&& coDataSet) :
+        m_buf(buf), m_pData(m_buf.data()), m_dataSize(m_buf.size()), m_data(std::move(coData)), m_dataSet(std::move(coDataSet)), m_symbolLookupBuilt(false), m_disassemblyInfo() {}
+
+    /// Constructor.
+    /// \param buf the memory buffer, moved into the CodeObj.
+    /// \param coData the amd_comgr_data_t type data, owned by the CodeObj.
+    /// \param coDataSet the amd_comgr_data_set_t data set, owned by the CodeObj.
+    CodeObj(std::vector<char>&& buf, ComgrData&& coData, ComgrDataSet&& coDataSet) :
+        m_buf(std::move(buf)), m_pData(m_buf.data()), m_dataSize(m_buf.size()), m_data(std::move(coData)), m_dataSet(std::move(coDataSet)), m_symbolLookupBuilt(false), m_disassemblyInfo() {}
+
+    /// Constructor for a CodeObj that references caller-owned memory.
+    /// \param pBuf the memory buffer, not owned by the CodeObj.
+    /// \param sizeInBytes the size of the memory buffer in bytes.
+    /// \param coData the amd_comgr_data_t type data, owned by the CodeObj.
+    /// \param coDataSet the amd_comgr_data_set_t data set, owned by the CodeObj.
+    CodeObj(const char* pBuf, size_t sizeInBytes, ComgrData&& coData, ComgrDataSet&& coDataSet) :
+        m_pData(pBuf), m_dataSize(sizeInBytes), m_data(std::move(coData)), m_dataSet(std::move(coDataSet)), m_symbolLookupBuilt(false), m_disassemblyInfo() {}
+
+    /// Constructor.
+    /// \param pMappedFile the file mapping holding the code object.
+    /// \param coData the amd_comgr_data_t type data, owned by the CodeObj.
+    /// \param coDataSet the amd_comgr_data_set_t data set, owned by the CodeObj.
+    CodeObj(std::unique_ptr<MappedFile> pMappedFile, ComgrData&& coData, ComgrDataSet&& coDataSet);
 
     // Destructor.
-    ~CodeObj()
-    {
-        ComgrEntryPoints::Instance()->amd_comgr_release_data_fn(m_data);
-    }
+    ~CodeObj();
 
 private:
+    /// Extract the PAL Pipeline metadata by decoding the MsgPack metadata note directly from the code object bytes.
+    /// \param data the PalPipelineData type data.
+    /// \param allocator the allocator for the arrays and strings of the data.
+    /// \return true if successful, false otherwise.
+    bool ExtractPalPipelineDataNative(PalPipelineData& data, PalDataAllocator& allocator);
+
+    /// Extract the PAL Pipeline metadata through the comgr metadata API.
+    /// \param data the PalPipelineData type data.
+    /// \param allocator the allocator for the arrays and strings of the data.
+    /// \return true if successful, false otherwise.
+    bool ExtractPalPipelineDataComgr(PalPipelineData& data, PalDataAllocator& allocator);
+
+    /// Read the function symbols directly from the ELF symbol table of the code object.
+    /// \param data the Symbol structure
+    /// \param copyNames true to copy the names into the name pool of data, false to point them into the code object.
+    /// \return true if the symbol table could be parsed, false otherwise.
+    bool ExtractSymbolDataNative(CodeObjSymbolInfo& data, bool copyNames);
+
+    /// Extract the symbol info like ExtractSymbolData, without copying the names of the native parser;
+    /// for internal users that clear the symbol data while the CodeObj is alive.
+    /// \param data the Symbol structure
+    /// \return true if successful, false otherwise.
+    bool ExtractSymbolDataUncopied(CodeObjSymbolInfo& data);
+
+    /// Read the function symbols through comgr symbol iteration.
+    /// \param data the Symbol structure
+    /// \return true if successful, false otherwise.
+    bool ExtractSymbolDataComgr(CodeObjSymbolInfo& data);
+
+    /// Helper function for creating the comgr data and data set for a code object.
+    /// \param pBuf the code object bytes.
+    /// \param sizeInBytes the size of the code object in bytes.
+    /// \param dataKind the data kind.
+    /// \param coData receives the created amd_comgr_data_t type data.
+    /// \param coDataSet receives the created amd_comgr_data_set_t data set.
+    /// \return true if successful, false otherwise.
+    static bool CreateComgrData(const char* pBuf, size_t sizeInBytes, const amd_comgr_data_kind_t& dataKind, ComgrData& coData, ComgrDataSet& coDataSet);
+
+    /// Helper function for reading a whole file into a buffer.
+    /// \param fileName the file name.
+    /// \param buf the buffer that receives the file contents.
+    /// \return true if successful, false otherwise.
+    static bool ReadFile(const std::string& fileName, std::vector<char>& buf);
+
+    /// Get the disassembly for the options, disassembling the code object on the first request.
+    /// \param options the options for extracting assembly buffer.
+    /// \return the cached disassembly, nullptr if the disassembly failed.
+    const std::vector<char>* GetCachedAssembly(const char* options);
+
+    /// Disassemble the whole code object with the comgr disassembly action.
+    /// \param assemblyBuffer receives the assembly text.
+    /// \param options the ISA name.
+    /// \return true if successful, false otherwise.
+    bool DisassembleCodeObject(std::vector<char>& assemblyBuffer, const std::string& options);
+
+    /// Disassemble the code object into a function listing, see ExtractFunctionListing.
+    /// \param listingBuffer receives the listing.
+    /// \param isaName the ISA name.
+    /// \param numWorkers the number of worker threads, 1 to list on the calling thread, 0 for one per hardware thread.
+    /// \return true if successful, false otherwise.
+    bool ListFunctions(std::vector<char>& listingBuffer, const std::string& isaName, uint32_t numWorkers);
+
+    /// Run the comgr action chain of ConvertSourceToCodeObject.
+    /// \param codeObjectBuffer receives the executable.
+    /// \param languageInfo the language of the source.
+    /// \param isaName the ISA name.
+    /// \return true if successful, false otherwise.
+    bool CompileSourceToExecutable(std::vector<char>& codeObjectBuffer, const amd_comgr_language_t& languageInfo, const std::string& isaName);
+
+    /// The precompiled headers and device libraries of one language and ISA.
+    struct CompileDataSets
+    {
+        ComgrDataSet m_precompiledHeaders;  ///< The data set holding the precompiled headers.
+        ComgrDataSet m_deviceLibraries;     ///< The data set holding the device library bitcode.
+    };
+
+    /// Get the precompiled headers and device libraries of a language and ISA, creating them on first use.
+    /// \param languageInfo the language.
+    /// \param isaName the ISA name.
+    /// \param pDataSets receives a reference to the data sets, which keeps them alive even if
+    ///        ReleaseCompileDataSets is called before it is dropped.
+    /// \return true if successful, false otherwise.
+    static bool GetCompileDataSets(amd_comgr_language_t languageInfo, const std::string& isaName, std::shared_ptr<const CompileDataSets>& pDataSets);
+
+    /// Run the precompiled header and device library actions without any input.
+    /// \param languageInfo the language.
+    /// \param isaName the ISA name.
+    /// \param dataSets receives the new data sets.
+    /// \return true if successful, false otherwise.
+    static bool CreateCompileDataSets(amd_comgr_language_t languageInfo, const std::string& isaName, CompileDataSets& dataSets);
+
+    /// Add every data object of a kind from one data set to another.
+    /// \param from the data set to copy from.
+    /// \param kind the kind of data objects.
+    /// \param to the data set to add to.
+    /// \return true if successful, false otherwise.
+    static bool AddDataSetData(amd_comgr_data_set_t from, amd_comgr_data_kind_t kind, amd_comgr_data_set_t to);
+
+    /// Replace one of the disk caches.
+    /// \param pDiskCache the disk cache to replace.
+    /// \param directory the cache directory, empty to disable the cache.
+    /// \param maxSizeInBytes the size cap of the cache entries, 0 for no cap.
+    static void SetDiskCache(std::shared_ptr<DiskCache>& pDiskCache, const std::string& directory, uint64_t maxSizeInBytes);
+
+    /// Get one of the disk caches, safe against a concurrent SetDiskCache.
+    /// \param pDiskCache the disk cache.
+    /// \return the disk cache, null if disabled.
+    static std::shared_ptr<DiskCache> GetDiskCache(const std::shared_ptr<DiskCache>& pDiskCache);
+
+    /// Get the process pool, unless the calling process is one of its workers.
+    /// \return the process pool, null if disabled.
+    static std::shared_ptr<ProcessPool> GetProcessPool();
+
+    /// Get the identity of the comgr library, as part of the disk cache keys: its version, the
+    /// path, size and modification time of the loaded binary, and the ComgrUtils cache format version.
+    /// \return the identity text.
+    static std::string GetComgrVersionTag();
+
+    /// Get the ranges of a function listing: the executable sections in address order, each split
+    /// into its function ranges in address order and ranges of the bytes between them.
+    /// \param symbols receives the function symbols the ranges refer to; must outlive the ranges.
+    /// \param ranges receives the function and gap ranges.
+    /// \return true if successful, false otherwise.
+    bool GetDisassemblyRanges(CodeObjSymbolInfo& symbols, std::vector<DisassemblyRange>& ranges);
+
+    /// Get the code bytes of a function symbol.
+    /// \param symbol the function symbol.
+    /// \param range receives the range.
+    /// \return true if the symbol has code bytes in an executable section, false otherwise.
+    bool GetDisassemblyRange(const CodeObjSymbol& symbol, DisassemblyRange& range) const;
+
+    /// Disassemble listing ranges on worker threads, each worker group with its own disassembler.
+    /// \param isaName the ISA name.
+    /// \param ranges the ranges, from GetDisassemblyRanges.
+    /// \param numWorkers the number of workers, 0 for one per hardware thread.
+    /// \param assemblyBuffer receives the text of all ranges, in order.
+    /// \return true if successful, false otherwise.
+    static bool DisassembleRangesParallel(const char* isaName, const std::vector<DisassemblyRange>& ranges, uint32_t numWorkers, std::vector<char>& assemblyBuffer);
+
+    /// Get the comgr instruction disassembler for an ISA, keeping it for later calls.
+    /// \param isaName the ISA name.
+    /// \param info receives the disassembler, owned by the CodeObj.
+    /// \return true if successful, false otherwise.
+    bool GetDisassemblyInfo(const char* isaName, amd_comgr_disassembly_info_t& info);
+
+    /// Destroy the disassembler kept by GetDisassemblyInfo.
+    void ReleaseDisassemblyInfo();
+
     /// Helper function for extracting PAL metadata Shaders Info.
     /// \param mdPipelineData the pipeline data.
-    /// \param ppln the metadata node.
+    /// \param shaders the ".shaders" map node of the pipeline.
+    /// \param allocator the allocator for the arrays and strings of the data.
     /// \return true if successful, false otherwise.
-    static bool ExtractPalMDShadersInfo(Pipeline& mdPipelineData, MDNode& ppln);
+    static bool ExtractPalMDShadersInfo(Pipeline& mdPipelineData, const MDNode& shaders, PalDataAllocator& allocator);
 
     /// Helper function for extracting PAL metadata Hardware Stages.
     /// \param mdPipelineData the pipeline data.
-    /// \param ppln the metadata node.
+    /// \param stages the ".hardware_stages" map node of the pipeline.
+    /// \param allocator the allocator for the arrays and strings of the data.
     /// \return true if successful, false otherwise.
-    static bool ExtractPalMDHardwareStages(Pipeline& mdPipelineData, MDNode& ppln);
+    static bool ExtractPalMDHardwareStages(Pipeline& mdPipelineData, const MDNode& stages, PalDataAllocator& allocator);
 
     /// Helper function for extracting PAL metadata for register info
     /// \param mdPipelineData the pipeline data.
-    /// \param ppln the metadata node.
+    /// \param regs the ".registers" map node of the pipeline.
+    /// \param allocator the allocator for the arrays and strings of the data.
     /// \return true if successful, false otherwise.
-    static bool ExtractPalMDRegisterInfo(Pipeline& mdPipelineData, MDNode& ppln);
-
-    std::vector<char>                   m_buf;      ///< Data buffer.
-    amd_comgr_data_t                    m_data;     ///< The amd_comgr_data_t type data.
-    amd_comgr_data_set_t                m_dataSet;  ///< The amd_comgr_data_set_t type data set.
-    static amd_comgr_status_t           m_status;   ///< The AMD COMGR status.
-    static std::string                  m_errMsg;   ///< The error message string.
+    static bool ExtractPalMDRegisterInfo(Pipeline& mdPipelineData, const MDNode& regs, PalDataAllocator& allocator);
+
+    std::vector<char>                   m_buf;          ///< Data buffer (empty if the code object is memory mapped or a view).
+    std::unique_ptr<MappedFile>         m_pMappedFile;  ///< Read-only file mapping holding the code object (OpenMapped only).
+    const char*                         m_pData;        ///< The code object bytes, in m_buf, in m_pMappedFile or in caller-owned memory.
+    size_t                              m_dataSize;     ///< The size of the code object in bytes.
+    ComgrData                           m_data;         ///< The amd_comgr_data_t type data.
+    ComgrDataSet                        m_dataSet;      ///< The amd_comgr_data_set_t type data set.
+    std::unique_ptr<MetadataSnapshot>   m_pMDSnapshot;          ///< Metadata snapshot built by GetMDSnapshot.
+    bool                                m_symbolLookupBuilt;    ///< True once m_symbolNameIndex has been built.
+    std::vector<CodeObjSymbol>          m_lookupSymbols;        ///< Function symbols found by FindSymbol; names point into m_symbolNameIndex.
+    SymbolNameIndex                     m_symbolNameIndex;      ///< Name index over m_lookupSymbols.
+    std::unordered_map<std::string, std::vector<char>> m_assemblyCache; ///< Disassembly text by options until ExtractAssemblyRaw copies it, see GetCachedAssembly.
+    amd_comgr_disassembly_info_t        m_disassemblyInfo;      ///< Instruction disassembler kept by GetDisassemblyInfo, handle 0 if none.
+    std::string                         m_disassemblyIsa;       ///< The ISA of m_disassemblyInfo.
+    static thread_local amd_comgr_status_t m_status;    ///< The AMD COMGR status of the calling thread.
+    static thread_local std::string        m_errMsg;    ///< The error message string of the calling thread.
+
+    static std::mutex                      m_diskCacheMutex;            ///< Guards the disk cache pointers.
+    static std::shared_ptr<DiskCache>      m_pDisassemblyDiskCache;     ///< The disassembly disk cache, null if disabled.
+    static std::shared_ptr<DiskCache>      m_pCompileDiskCache;         ///< The compile disk cache, null if disabled.
+
+    static std::mutex                                                                  m_compileDataSetMutex;  ///< Guards m_pCompileDataSets.
+    static std::unordered_map<std::string, std::shared_ptr<const CompileDataSets>>*    m_pCompileDataSets;     ///< Precompiled headers and device libraries by language and ISA, never deleted.
+
+    static std::mutex                      m_processPoolMutex;          ///< Guards m_pProcessPool.
+    static std::shared_ptr<ProcessPool>    m_pProcessPool;              ///< The worker processes, null if disabled.
+
+    friend class ProcessPool;
 };
 
-/// Metadata Node.
+/// Metadata Node. Owns its comgr node and destroys it when it goes out of scope, so it can be moved but not copied.
 class MDNode
 {
 public:
@@ -602,15 +1342,24 @@ public:
         Map             ///< Metadata node kind is map.
     };
 
-    /// Constructor.
+    /// Constructor, takes ownership of the node.
     /// \param node amd_comgr_metadata_node_t type metadata node.
     MDNode(amd_comgr_metadata_node_t node);
 
-    /// Constructor.
-    /// \param handle the node handle.
+    /// Constructor, takes ownership of the node.
+    /// \param handle the node handle, 0 for an invalid node.
     MDNode(int handle);
 
-    /// Destructor.
+    /// Move constructor.
+    /// \param other the node to take ownership from; it is left invalid.
+    MDNode(MDNode&& other) = default;
+
+    /// Move assignment.
+    /// \param other the node to take ownership from; it is left invalid.
+    /// \return this node.
+    MDNode& operator=(MDNode&& other) = default;
+
+    /// Destructor, destroys the node.
     ~MDNode() = default;
 
     /// Get the kind of this MD node.
@@ -642,11 +1391,35 @@ public:
     /// \return true if successful, false otherwise.
     bool Find(const std::string& key) const;
 
-    /// Get the value.
-    /// \return the value.
+    /// Get the value. Integral values are decoded with ParseMDUnsigned/ParseMDSigned; a string that is
+    /// not a number or does not fit TYPE sets the error returned by CodeObj::GetLastError().
+    /// \return the value, 0 if it could not be decoded.
     template<typename TYPE>
     TYPE value() const;
 
+    /// Get the string value without copying it (only valid for String MD nodes).
+    /// The string is read once into storage owned by this MDNode and released with it; later reads
+    /// through the same MDNode return the cached view. Values of any length are supported.
+    /// \param view receives the string, valid as long as this MDNode (or the MDNode it is moved to).
+    /// \return true if successful, false if this is not a String node.
+    bool GetStringView(MDStringView& view) const;
+
+    /// Decode the string value of this node as an unsigned number, without allocating.
+    /// \param val receives the number, unchanged unless successful.
+    /// \return the decode status, MDNumberStatus::Invalid if this is not a String node.
+    MDNumberStatus GetUnsigned(uint64_t& val) const;
+
+    /// Decode the string value of this node as a signed number, without allocating.
+    /// \param val receives the number, unchanged unless successful.
+    /// \return the decode status, MDNumberStatus::Invalid if this is not a String node.
+    MDNumberStatus GetSigned(int64_t& val) const;
+
+    /// Decode a map whose keys and values are all unsigned numbers, like the PAL register map, in
+    /// one pass over the map (only valid for Map MD nodes). Nothing is allocated per entry.
+    /// \param entries receives the entries in map order, entries that can not be decoded are stored as 0.
+    /// \return true if every entry was decoded, false otherwise.
+    bool DecodeUnsignedMap(std::vector<MDUnsignedEntry>& entries) const;
+
     /// Get the number of sub-nodes of this MD node (only valid for List and Map nodes).
     /// \return the size.
     size_t size() const;
@@ -655,6 +1428,22 @@ public:
     /// \return the keys vector.
     std::vector<std::string> GetKeys() const;
 
+    /// Callback invoked by VisitMap for each key/value pair of a map.
+    /// \param tag the PAL metadata tag of the key, PalMDTag::Unknown if the key is not a known tag.
+    /// \param pKey the key string, only valid during the call.
+    /// \param keyLen the length of the key string.
+    /// \param val the value node, destroyed after the call unless the callback moves it out.
+    /// \param pUserData the user data passed to VisitMap.
+    /// \return true to continue the iteration, false to stop it and fail VisitMap.
+    typedef bool (*MapVisitor)(PalMDTag tag, const char* pKey, size_t keyLen, MDNode& val, void* pUserData);
+
+    /// Visit every key/value pair of this node in a single iteration (only valid for Map MD nodes).
+    /// Unlike looking up keys one by one, this costs one library call per entry and no lookups.
+    /// \param pVisitor the callback invoked for each entry.
+    /// \param pUserData user data passed to the callback.
+    /// \return true if successful, false if the node is not a map or the callback failed.
+    bool VisitMap(MapVisitor pVisitor, void* pUserData) const;
+
     /// Indicates whether the handle is valid.
     /// \return true if successful, false otherwise.
     bool IsValid() const;
@@ -663,7 +1452,394 @@ public:
     void Dump();
 
 private:
-    amd_comgr_metadata_node_t m_handle;    ///< The metadata node handle.
+    friend class MetadataSnapshot;
+
+    ComgrMetadataNode               m_handle;       ///< The metadata node handle.
+    mutable std::unique_ptr<char[]> m_pString;      ///< The string read by GetStringView, nullptr until then.
+    mutable MDStringView            m_stringView;   ///< View of m_pString, m_pData is nullptr until GetStringView.
+};
+
+/// Read-only view of one node of a MetadataSnapshot, with the same accessors as MDNode.
+/// Every accessor is a plain memory access; the view is valid as long as its snapshot.
+class MetadataSnapshotNode
+{
+public:
+    /// Constructor, creates an invalid node.
+    MetadataSnapshotNode() : m_pSnapshot(nullptr), m_index(0) {}
+
+    /// Constructor.
+    /// \param pSnapshot the snapshot.
+    /// \param index the index of the node in the snapshot.
+    MetadataSnapshotNode(const MetadataSnapshot* pSnapshot, uint32_t index) : m_pSnapshot(pSnapshot), m_index(index) {}
+
+    /// Get the kind of this node.
+    /// \return metadata node kind.
+    MDNode::Kind GetKind() const;
+
+    /// Get the sub-node by its index (only valid for List nodes).
+    /// \param idx the sub-node index.
+    /// \return the sub-node, invalid if there is none.
+    MetadataSnapshotNode operator[] (size_t idx) const;
+
+    /// Get the sub-node by its index (only valid for List nodes).
+    /// \param idx the sub-node index.
+    /// \return the sub-node, invalid if there is none.
+    MetadataSnapshotNode operator[] (int idx) const
+    {
+        return (idx < 0 ? MetadataSnapshotNode() : (*this)[static_cast<size_t>(idx)]);
+    }
+
+    /// Get the sub-node by its string key (only valid for Map nodes).
+    /// \param key the key string of the sub-node.
+    /// \return the sub-node, invalid if there is none.
+    MetadataSnapshotNode operator[] (const std::string& key) const;
+
+    /// Get the sub-node by its char* key (only valid for Map nodes).
+    /// \param key the key of the sub-node.
+    /// \return the sub-node, invalid if there is none.
+    MetadataSnapshotNode operator[] (const char* key) const;
+
+    /// Checks if sub-node with provided key exists in this node (only valid for Map nodes).
+    /// \param key the key of the sub-node.
+    /// \return true if the key exists, false otherwise.
+    bool Find(const std::string& key) const;
+
+    /// Get the value of a String node converted to an arithmetic type.
+    /// \return the value, 0 if the node is not a String or can not be converted.
+    template<typename TYPE>
+    TYPE value() const
+    {
+        return std::is_floating_point<TYPE>::value ? static_cast<TYPE>(GetDouble()) :
+               std::is_signed<TYPE>::value ? static_cast<TYPE>(GetInt64()) : static_cast<TYPE>(GetUInt64());
+    }
+
+    /// Get the string of a String node without copying it.
+    /// \return the null terminated string, "" if the node is not a String.
+    const char* GetString() const;
+
+    /// Get the key of this node in its parent map.
+    /// \return the null terminated key, "" if the parent is not a Map.
+    const char* GetKey() const;
+
+    /// Get the number of sub-nodes of this node (only valid for List and Map nodes).
+    /// \return the size.
+    size_t size() const;
+
+    /// Get the list of string keys (only valid for Map nodes).
+    /// \return the keys vector.
+    std::vector<std::string> GetKeys() const;
+
+    /// Indicates whether the node is valid.
+    /// \return true if the node is valid, false otherwise.
+    bool IsValid() const
+    {
+        return m_pSnapshot != nullptr;
+    }
+
+private:
+    /// Convert the string value to an unsigned integer; "true" and "false" read as 1 and 0.
+    uint64_t GetUInt64() const;
+
+    /// Convert the string value to a signed integer; "true" and "false" read as 1 and 0.
+    int64_t GetInt64() const;
+
+    /// Convert the string value to a floating point number.
+    double GetDouble() const;
+
+    const MetadataSnapshot* m_pSnapshot;   ///< The snapshot, nullptr for an invalid node.
+    uint32_t                m_index;       ///< The index of the node in the snapshot.
+};
+
+/// Specialization of "value" function for std::string.
+/// \return the value string.
+template<>
+inline std::string MetadataSnapshotNode::value<std::string>() const
+{
+    return GetString();
+}
+
+/// Materialized, flat copy of a comgr metadata tree.
+/// The nodes live in one contiguous array in which the children of a List or Map node are
+/// consecutive, strings live in one character pool and map keys are interned, so each distinct
+/// key is stored once and a lookup compares key ids instead of strings.
+class MetadataSnapshot
+{
+public:
+    /// Constructor, creates an empty snapshot.
+    MetadataSnapshot() {}
+
+    /// Walk the comgr metadata tree once and store it, replacing any previous content.
+    /// \param root the root of the metadata tree.
+    /// \return true if successful, false otherwise.
+    bool Build(const MDNode& root);
+
+    /// Get the root node.
+    /// \return the root node, invalid if the snapshot is empty.
+    MetadataSnapshotNode GetRoot() const
+    {
+        return m_nodes.empty() ? MetadataSnapshotNode() : MetadataSnapshotNode(this, 0);
+    }
+
+    /// Get the number of nodes in the snapshot.
+    /// \return the number of nodes.
+    size_t GetNumNodes() const
+    {
+        return m_nodes.size();
+    }
+
+private:
+    friend class MetadataSnapshotNode;
+
+    /// Returned for nodes that are not map values and for unknown keys.
+    static const uint32_t s_NO_KEY = 0xFFFFFFFF;
+
+    /// One metadata node.
+    struct Node
+    {
+        MDNode::Kind    m_kind;     ///< The node kind.
+        uint32_t        m_keyId;    ///< Interned key id of a map value, s_NO_KEY otherwise.
+        uint32_t        m_first;    ///< Index of the first child (List and Map) or offset of the string in m_strings.
+        uint32_t        m_count;    ///< Number of children (List and Map) or length of the string.
+    };
+
+    /// Store the comgr node into an already reserved slot and append its descendants.
+    /// \param handle the comgr node.
+    /// \param index the index of the slot.
+    /// \return true if successful, false otherwise.
+    bool StoreNode(amd_comgr_metadata_node_t handle, uint32_t index);
+
+    /// Copy a string into the string pool.
+    /// \param handle the comgr String node.
+    /// \param offset receives the offset of the string.
+    /// \param length receives the length of the string.
+    /// \return true if successful, false otherwise.
+    bool StoreString(amd_comgr_metadata_node_t handle, uint32_t& offset, uint32_t& length);
+
+    /// Get the interned id of a key.
+    /// \param pKey the key.
+    /// \param keyLen the length of the key.
+    /// \return the key id, s_NO_KEY if no map in the snapshot has this key.
+    uint32_t FindKeyId(const char* pKey, size_t keyLen) const
+    {
+        uint32_t keyId = m_keyIndex.Find(pKey, keyLen);
+        return keyId == SymbolNameIndex::s_INVALID_SYMBOL_INDEX ? s_NO_KEY : keyId;
+    }
+
+    std::vector<Node>           m_nodes;        ///< The nodes; index 0 is the root.
+    std::vector<char>           m_strings;      ///< Null terminated string values, back to back.
+    SymbolNameIndex             m_keyIndex;     ///< Interned map keys, mapping each key to its id.
+    std::vector<const char*>    m_keys;         ///< Interned key strings by key id.
+};
+
+/// Items to extract in CodeObjBatch::Run.
+enum CodeObjBatchFlags
+{
+    COMGR_UTILS_BATCH_EXTRACT_PAL_PIPELINE_DATA = 0x1,  ///< Run ExtractPalPipelineData on each code object.
+    COMGR_UTILS_BATCH_EXTRACT_SYMBOL_DATA       = 0x2   ///< Run ExtractSymbolData on each code object.
+};
+
+/// Result of one code object processed by CodeObjBatch.
+struct CodeObjBatchResult
+{
+    std::unique_ptr<CodeObj>    m_pCodeObj;             ///< The opened code object, nullptr if it could not be opened.
+    bool                        m_palPipelineDataValid; ///< Indicates if m_palPipelineData was extracted.
+    PalPipelineData             m_palPipelineData;      ///< The PAL pipeline data.
+    bool                        m_symbolDataValid;      ///< Indicates if m_symbolData was extracted.
+    CodeObjSymbolInfo           m_symbolData;           ///< The symbol data.
+    amd_comgr_status_t          m_status;               ///< The status of the first failed operation, success if none failed.
+    std::string                 m_errMsg;               ///< The error message of the first failed operation.
+
+    /// Default constructor
+    CodeObjBatchResult(): m_palPipelineDataValid(false), m_symbolDataValid(false), m_status(AMD_COMGR_STATUS_SUCCESS) {}
+};
+
+/// Opens many code objects and extracts their data concurrently on a pool of worker threads.
+class CodeObjBatch
+{
+public:
+    /// Constructor, uses one worker per hardware thread.
+    CodeObjBatch() : m_numWorkers(0) {}
+
+    /// Constructor.
+    /// \param numWorkers the number of workers, 0 to use one worker per hardware thread.
+    explicit CodeObjBatch(uint32_t numWorkers) : m_numWorkers(numWorkers) {}
+
+    /// Add a code object file; it is opened with CodeObj::OpenMapped.
+    /// \param fileName the file name.
+    void AddFile(const std::string& fileName);
+
+    /// Add a code object buffer, taking ownership of the buffer.
+    /// \param buf the memory buffer, moved into the batch.
+    void AddBuffer(std::vector<char>&& buf);
+
+    /// Add caller-owned code object memory without copying it.
+    /// The memory must stay valid for the lifetime of the resulting CodeObj.
+    /// \param pBuf the memory buffer.
+    /// \param sizeInBytes the size of the memory buffer in bytes.
+    void AddBufferView(const char* pBuf, size_t sizeInBytes);
+
+    /// Get the number of code objects added to the batch.
+    /// \return the number of items.
+    size_t GetNumItems() const
+    {
+        return m_items.size();
+    }
+
+    /// Open all code objects and run the requested extractions concurrently.
+    /// The results are returned in the order the items were added; the batch is emptied.
+    /// \param flags combination of CodeObjBatchFlags.
+    /// \param results the per-item results.
+    /// \return true if every item succeeded, false otherwise.
+    bool Run(uint32_t flags, std::vector<CodeObjBatchResult>& results);
+
+    /// Clear the PAL pipeline and symbol data held by the results.
+    /// \param results the results returned by Run.
+    static void ClearResults(std::vector<CodeObjBatchResult>& results);
+
+private:
+    /// A code object to process.
+    struct Item
+    {
+        std::string         m_fileName;     ///< The file name, empty for buffer items.
+        std::vector<char>   m_buf;          ///< The owned buffer.
+        const char*         m_pBuf;         ///< The caller-owned memory, nullptr for file and owned buffer items.
+        size_t              m_sizeInBytes;  ///< The size of the caller-owned memory.
+    };
+
+    /// Open and process one item on the calling worker thread.
+    /// \param item the item.
+    /// \param flags combination of CodeObjBatchFlags.
+    /// \param result the result of the item.
+    static void ProcessItem(Item& item, uint32_t flags, CodeObjBatchResult& result);
+
+    uint32_t            m_numWorkers;   ///< The number of workers, 0 for one per hardware thread.
+    std::vector<Item>   m_items;        ///< The code objects to process.
+};
+
+/// Result of one source compiled by CompileBatch.
+struct CompileBatchResult
+{
+    std::vector<char>   m_codeObject;   ///< The executable code object, empty if the compile failed.
+    amd_comgr_status_t  m_status;       ///< The status of the compile.
+    std::string         m_errMsg;       ///< The error message of a failed compile.
+
+    /// Default constructor
+    CompileBatchResult(): m_status(AMD_COMGR_STATUS_SUCCESS) {}
+};
+
+/// Compiles many sources for one language and ISA concurrently on a pool of worker threads.
+/// Every source runs the CodeObj::ConvertSourceToCodeObject chain with its own action info and
+/// data sets; the compile disk cache and the shared precompiled headers and device libraries
+/// are used like in a single compile.
+class CompileBatch
+{
+public:
+    /// Constructor, uses one worker per hardware thread.
+    CompileBatch() : m_numWorkers(0) {}
+
+    /// Constructor.
+    /// \param numWorkers the maximum number of concurrent compiles, 0 for one per hardware thread.
+    explicit CompileBatch(uint32_t numWorkers) : m_numWorkers(numWorkers) {}
+
+    /// Add a source file; it is read with CodeObj::OpenFile.
+    /// \param fileName the file name.
+    void AddFile(const std::string& fileName);
+
+    /// Add a source buffer, taking ownership of the buffer.
+    /// \param source the source text, moved into the batch.
+    void AddSource(std::vector<char>&& source);
+
+    /// Get the number of sources added to the batch.
+    /// \return the number of items.
+    size_t GetNumItems() const
+    {
+        return m_items.size();
+    }
+
+    /// Compile all sources concurrently.
+    /// The results are returned in the order the items were added; the batch is emptied.
+    /// \param languageInfo the language of all sources.
+    /// \param isaName the ISA name.
+    /// \param results the per-item results.
+    /// \return true if every item compiled, false otherwise.
+    bool Run(const amd_comgr_language_t& languageInfo, const std::string& isaName, std::vector<CompileBatchResult>& results);
+
+private:
+    /// A source to compile.
+    struct Item
+    {
+        std::string         m_fileName;     ///< The file name, empty for buffer items.
+        std::vector<char>   m_source;       ///< The owned source buffer.
+    };
+
+    /// Compile one item on the calling worker thread.
+    /// \param item the item.
+    /// \param languageInfo the language.
+    /// \param isaName the ISA name.
+    /// \param result the result of the item.
+    static void CompileItem(Item& item, const amd_comgr_language_t& languageInfo, const std::string& isaName, CompileBatchResult& result);
+
+    uint32_t            m_numWorkers;   ///< The maximum number of concurrent compiles, 0 for one per hardware thread.
+    std::vector<Item>   m_items;        ///< The sources to compile.
+};
+
+/// Address-to-symbol index over the function symbols of a CodeObjSymbolInfo.
+/// The symbol start addresses are kept in Eytzinger (breadth-first) order so the
+/// top levels of every search share the same cache lines.
+/// Symbols with a size of 0 are not indexed; if symbols overlap, an address resolves
+/// to the symbol with the greatest start address that is not above it.
+class SymbolIndex
+{
+public:
+    /// Returned when an address is not inside any indexed symbol.
+    static const uint32_t s_INVALID_SYMBOL_INDEX = 0xFFFFFFFF;
+
+    /// Constructor, creates an empty index.
+    SymbolIndex() {}
+
+    /// Build the index from the function symbols, replacing any previous content.
+    /// The index stores symbol indices, not pointers, so data may be cleared afterwards.
+    /// \param data the symbol data returned by CodeObj::ExtractSymbolData.
+    void Build(const CodeObjSymbolInfo& data);
+
+    /// Remove all symbols from the index.
+    void Clear();
+
+    /// Get the number of indexed address ranges.
+    /// \return the number of ranges.
+    size_t GetNumRanges() const
+    {
+        return m_symbolIndices.size();
+    }
+
+    /// Find the symbol containing an address.
+    /// \param address the address.
+    /// \return the index into CodeObjSymbolInfo::m_pSymbols, or s_INVALID_SYMBOL_INDEX.
+    uint32_t FindByAddress(uint64_t address) const;
+
+    /// Find the symbols containing a batch of addresses.
+    /// Several searches are interleaved so their memory accesses overlap.
+    /// \param pAddresses the addresses.
+    /// \param numAddresses the number of addresses.
+    /// \param pSymbolIndices receives one symbol index (or s_INVALID_SYMBOL_INDEX) per address.
+    void FindByAddress(const uint64_t* pAddresses, size_t numAddresses, uint32_t* pSymbolIndices) const;
+
+    /// Find the symbols containing a batch of addresses.
+    /// \param addresses the addresses.
+    /// \param symbolIndices receives one symbol index (or s_INVALID_SYMBOL_INDEX) per address.
+    void FindByAddress(const std::vector<uint64_t>& addresses, std::vector<uint32_t>& symbolIndices) const;
+
+private:
+    /// Map the result of an Eytzinger search to the symbol containing the address.
+    /// \param eytzingerPos the position of the first start address above the address, 0 if none.
+    /// \param address the address.
+    /// \return the symbol index, or s_INVALID_SYMBOL_INDEX.
+    uint32_t Resolve(size_t eytzingerPos, uint64_t address) const;
+
+    std::vector<uint64_t>   m_eytzingerStarts;  ///< Start addresses in Eytzinger order, 1-based.
+    std::vector<uint32_t>   m_eytzingerRanks;   ///< Sorted position of each entry of m_eytzingerStarts.
+    std::vector<uint64_t>   m_ends;             ///< End addresses in sorted order.
+    std::vector<uint32_t>   m_symbolIndices;    ///< Symbol indices in sorted order.
 };
 
 /// Specialization of "value" function for std::string.
@@ -0,0 +1,605 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Function listings: disassembly of code object functions from their symbol ranges.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "ComgrUtilsDiskCache.h"
+#include "ComgrUtilsElf.h"
+#include "ComgrUtilsWorkerPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace AMDT
+{
+// Function groups per worker of a parallel disassembly, so work stealing can balance uneven functions
+static const uint32_t s_DISASSEMBLY_GROUPS_PER_WORKER = 4;
+
+// Code bytes of one function, or bytes between functions that no symbol covers
+struct DisassemblyRange
+{
+    const char* m_pName;            // The function name, nullptr for bytes between functions
+    const char* m_pSectionName;     // The name of the section holding the bytes
+    uint64_t    m_sectionAddress;   // The address of the section
+    uint64_t    m_address;          // The address of the first byte
+    uint64_t    m_size;             // The size in bytes
+    const char* m_pBytes;           // The bytes, in the code object
+};
+
+// An executable section of a function listing
+struct ListingSection
+{
+    Elf64SectionHeader              m_header;       // The section header
+    const char*                     m_pName;        // The section name
+    const char*                     m_pBytes;       // The section contents
+    std::vector<DisassemblyRange>   m_functions;    // The ranges of the functions in the section
+};
+
+// Receives the disassembly of a function one line at a time; returns false to stop
+typedef bool (*DisassemblyLineSink)(const char* pLine, size_t length, void* pUserData);
+
+// State of the comgr callbacks while one instruction is disassembled
+struct InstructionState
+{
+    const DisassemblyRange* m_pRange;       // The function being disassembled
+    std::string             m_instruction;  // The instruction text printed by comgr
+};
+
+// Collects listing lines into chunks of bounded size for ExtractFunctionListingStream
+struct ListingChunkWriter
+{
+    std::vector<char>               m_chunk;        // The lines of the current chunk
+    size_t                          m_chunkSize;    // The maximum size of a chunk
+    CodeObj::ListingTextCallback    m_pCallback;    // The callback receiving the chunks
+    void*                           m_pUserData;    // User data of the callback
+};
+
+extern "C" uint64_t ReadInstructionBytes(uint64_t from, char* pTo, uint64_t size, void* pUserData)
+{
+    const DisassemblyRange* pRange = static_cast<InstructionState*>(pUserData)->m_pRange;
+
+    // Instructions never read past the end of their function.
+    if (from < pRange->m_address || from - pRange->m_address >= pRange->m_size)
+    {
+        return 0;
+    }
+
+    uint64_t offset = from - pRange->m_address;
+    uint64_t numBytes = std::min(size, pRange->m_size - offset);
+    memcpy(pTo, pRange->m_pBytes + offset, static_cast<size_t>(numBytes));
+    return numBytes;
+}
+
+extern "C" void PrintInstruction(const char* pInstruction, void* pUserData)
+{
+    static_cast<InstructionState*>(pUserData)->m_instruction.append(pInstruction);
+}
+
+extern "C" void PrintAddressAnnotation(uint64_t address, void* pUserData)
+{
+    // Branch targets are already part of the instruction text.
+    (void)address;
+    (void)pUserData;
+}
+
+// Find the bytes of a code range in the executable sections of an ELF file
+static const char* FindCodeBytes(const ElfReader& reader, uint64_t address, uint64_t size)
+{
+    Elf64SectionHeader section;
+
+    for (uint32_t i = 0; i < reader.GetNumSections(); ++i)
+    {
+        if (reader.GetSection(i, section) && (section.m_flags & ELF_SHF_EXECINSTR) != 0 && section.m_type != ELF_SHT_NOBITS &&
+            address >= section.m_addr && address - section.m_addr <= section.m_size && size <= section.m_size - (address - section.m_addr))
+        {
+            const char* pData = reader.GetSectionData(section);
+            return (pData != nullptr ? pData + (address - section.m_addr) : nullptr);
+        }
+    }
+
+    return nullptr;
+}
+
+// Create a comgr instruction disassembler for an ISA
+static bool CreateDisassemblyInfo(const char* isaName, amd_comgr_disassembly_info_t& info)
+{
+    ComgrEntryPoints* pEntryPoints = ComgrEntryPoints::Instance();
+
+    if (pEntryPoints->amd_comgr_create_disassembly_info_fn == nullptr || pEntryPoints->amd_comgr_destroy_disassembly_info_fn == nullptr ||
+        pEntryPoints->amd_comgr_disassemble_instruction_fn == nullptr)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: The comgr library does not support instruction disassembly");
+        return false;
+    }
+
+    amd_comgr_status_t status = pEntryPoints->amd_comgr_create_disassembly_info_fn(isaName, ReadInstructionBytes, PrintInstruction,
+                                                                                   PrintAddressAnnotation, &info);
+    CheckStatus(status, false);
+    return true;
+}
+
+// Format up to 4 bytes as a .long data word
+static void FormatDataWord(const char* pBytes, uint64_t size, std::string& instruction)
+{
+    uint32_t word = 0;
+    memcpy(&word, pBytes, static_cast<size_t>(std::min<uint64_t>(4, size)));
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), ".long 0x%08X", word);
+    instruction = buf;
+}
+
+// Format one instruction line: the text, then the address and the encoding as 32 bit words
+static void FormatInstructionLine(const std::string& instruction, uint64_t address, const char* pBytes, uint64_t size, std::string& line)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), " // %012llX:", static_cast<unsigned long long>(address));
+    line.assign("\t").append(instruction).append(buf);
+
+    for (uint64_t offset = 0; offset < size; offset += 4)
+    {
+        uint32_t word = 0;
+        memcpy(&word, pBytes + offset, static_cast<size_t>(std::min<uint64_t>(4, size - offset)));
+        snprintf(buf, sizeof(buf), " %08X", word);
+        line.append(buf);
+    }
+
+    line.push_back('\n');
+}
+
+// Disassemble one function instruction by instruction, or list the bytes between functions as data
+// words, passing every line to the sink
+static bool DisassembleRange(amd_comgr_disassembly_info_t info, const DisassemblyRange& range, DisassemblyLineSink pSink, void* pSinkData)
+{
+    std::string line;
+
+    if (range.m_pName != nullptr)
+    {
+        line.assign(range.m_pName).append(":\n");
+    }
+    else
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "+0x%llX:\n", static_cast<unsigned long long>(range.m_address - range.m_sectionAddress));
+        line.assign(range.m_pSectionName).append(buf);
+    }
+
+    if (!pSink(line.data(), line.size(), pSinkData))
+    {
+        return false;
+    }
+
+    InstructionState state;
+    state.m_pRange = &range;
+    uint64_t offset = 0;
+
+    while (offset < range.m_size)
+    {
+        state.m_instruction.clear();
+        uint64_t size = 0;
+        amd_comgr_status_t status = AMD_COMGR_STATUS_ERROR;
+
+        // The bytes between functions are padding or data, decoding them would only list noise.
+        if (range.m_pName != nullptr)
+        {
+            status = ComgrEntryPoints::Instance()->amd_comgr_disassemble_instruction_fn(info, range.m_address + offset, &state, &size);
+        }
+
+        if (status != AMD_COMGR_STATUS_SUCCESS || size == 0 || size > range.m_size - offset)
+        {
+            // Bytes that do not decode are written as a data word and skipped.
+            size = std::min<uint64_t>(4, range.m_size - offset);
+            FormatDataWord(range.m_pBytes + offset, size, state.m_instruction);
+        }
+
+        FormatInstructionLine(state.m_instruction, range.m_address + offset, range.m_pBytes + offset, size, line);
+
+        if (!pSink(line.data(), line.size(), pSinkData))
+        {
+            return false;
+        }
+
+        offset += size;
+    }
+
+    return pSink("\n", 1, pSinkData);
+}
+
+// DisassemblyLineSink appending a line to a std::vector<char>
+static bool AppendLine(const char* pLine, size_t length, void* pUserData)
+{
+    std::vector<char>* pBuffer = static_cast<std::vector<char>*>(pUserData);
+    pBuffer->insert(pBuffer->end(), pLine, pLine + length);
+    return true;
+}
+
+// Disassembly of a contiguous group of functions on one worker of DisassembleRangesParallel
+struct DisassemblyGroup
+{
+    size_t                                      m_firstRange;   // Index of the first range of the group
+    size_t                                      m_numRanges;    // The number of ranges
+    std::vector<char>                           m_text;         // The disassembly text of the group
+    std::pair<amd_comgr_status_t, std::string>  m_error;        // The error of the worker, if any
+};
+
+// Hand the collected lines of a chunk writer to its callback
+static bool FlushChunk(ListingChunkWriter& writer)
+{
+    bool retCode = true;
+
+    if (!writer.m_chunk.empty())
+    {
+        retCode = writer.m_pCallback(writer.m_chunk.data(), writer.m_chunk.size(), writer.m_pUserData);
+        writer.m_chunk.clear();
+    }
+
+    return retCode;
+}
+
+// DisassemblyLineSink adding a line to the chunk of a ListingChunkWriter
+static bool WriteChunkedLine(const char* pLine, size_t length, void* pUserData)
+{
+    ListingChunkWriter* pWriter = static_cast<ListingChunkWriter*>(pUserData);
+
+    if (!pWriter->m_chunk.empty() && pWriter->m_chunk.size() + length > pWriter->m_chunkSize && !FlushChunk(*pWriter))
+    {
+        return false;
+    }
+
+    // A line longer than a chunk is delivered on its own.
+    if (length > pWriter->m_chunkSize)
+    {
+        return pWriter->m_pCallback(pLine, length, pWriter->m_pUserData);
+    }
+
+    pWriter->m_chunk.insert(pWriter->m_chunk.end(), pLine, pLine + length);
+    return true;
+}
+
+bool CodeObj::GetDisassemblyRange(const CodeObjSymbol& symbol, DisassemblyRange& range) const
+{
+    ElfReader reader;
+
+    if (symbol.m_type != COMGR_UTILS_SYMBOL_TYPE_FUNC || symbol.m_symbolFunction.m_symbolSize == 0 || !reader.Init(m_pData, m_dataSize))
+    {
+        return false;
+    }
+
+    range.m_pName = (symbol.m_symbolFunction.m_pName != nullptr ? symbol.m_symbolFunction.m_pName : "");
+    range.m_pSectionName = "";
+    range.m_sectionAddress = 0;
+    range.m_address = symbol.m_symbolFunction.m_symbolValue;
+    range.m_size = symbol.m_symbolFunction.m_symbolSize;
+    range.m_pBytes = FindCodeBytes(reader, range.m_address, range.m_size);
+    return range.m_pBytes != nullptr;
+}
+
+// Add the range of the bytes of a listing section between two addresses that no function covers
+static void AddGapRange(const ListingSection& section, uint64_t from, uint64_t to, std::vector<DisassemblyRange>& ranges)
+{
+    DisassemblyRange range;
+    range.m_pName = nullptr;
+    range.m_pSectionName = section.m_pName;
+    range.m_sectionAddress = section.m_header.m_addr;
+    range.m_address = from;
+    range.m_size = to - from;
+    range.m_pBytes = section.m_pBytes + (from - section.m_header.m_addr);
+    ranges.push_back(range);
+}
+
+bool CodeObj::GetDisassemblyRanges(CodeObjSymbolInfo& symbols, std::vector<DisassemblyRange>& ranges)
+{
+    ElfReader reader;
+
+    if (!reader.Init(m_pData, m_dataSize))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR, "ERROR: The code object is not an ELF file");
+        return false;
+    }
+
+    if (!ExtractSymbolDataUncopied(symbols))
+    {
+        return false;
+    }
+
+    std::vector<ListingSection> sections;
+    ListingSection section;
+
+    for (uint32_t i = 0; i < reader.GetNumSections(); ++i)
+    {
+        if (reader.GetSection(i, section.m_header) && (section.m_header.m_flags & ELF_SHF_EXECINSTR) != 0 &&
+            section.m_header.m_type != ELF_SHT_NOBITS && section.m_header.m_size > 0)
+        {
+            section.m_pName = reader.GetSectionName(section.m_header);
+            section.m_pBytes = reader.GetSectionData(section.m_header);
+
+            if (section.m_pBytes != nullptr)
+            {
+                sections.push_back(section);
+            }
+        }
+    }
+
+    std::stable_sort(sections.begin(), sections.end(), [](const ListingSection& lhs, const ListingSection& rhs)
+    {
+        return lhs.m_header.m_addr < rhs.m_header.m_addr;
+    });
+
+    // Every function is listed in the first section holding all of its bytes. Symbols without code
+    // bytes, like declarations, have nothing to disassemble.
+    for (uint32_t i = 0; i < symbols.m_numSymbols; ++i)
+    {
+        const CodeObjSymbolFunction& function = symbols.m_pSymbols[i].m_symbolFunction;
+
+        for (size_t j = 0; j < sections.size() && function.m_symbolSize > 0; ++j)
+        {
+            const Elf64SectionHeader& header = sections[j].m_header;
+
+            if (function.m_symbolValue >= header.m_addr && function.m_symbolValue - header.m_addr <= header.m_size &&
+                function.m_symbolSize <= header.m_size - (function.m_symbolValue - header.m_addr))
+            {
+                DisassemblyRange range;
+                range.m_pName = (function.m_pName != nullptr ? function.m_pName : "");
+                range.m_pSectionName = sections[j].m_pName;
+                range.m_sectionAddress = header.m_addr;
+                range.m_address = function.m_symbolValue;
+                range.m_size = function.m_symbolSize;
+                range.m_pBytes = sections[j].m_pBytes + (function.m_symbolValue - header.m_addr);
+                sections[j].m_functions.push_back(range);
+                break;
+            }
+        }
+    }
+
+    for (ListingSection& listingSection : sections)
+    {
+        std::stable_sort(listingSection.m_functions.begin(), listingSection.m_functions.end(), [](const DisassemblyRange& lhs, const DisassemblyRange& rhs)
+        {
+            return lhs.m_address < rhs.m_address;
+        });
+
+        // The end of the bytes listed so far; overlapping functions are listed in full, gaps only once.
+        uint64_t listedEnd = listingSection.m_header.m_addr;
+
+        for (const DisassemblyRange& range : listingSection.m_functions)
+        {
+            if (range.m_address > listedEnd)
+            {
+                AddGapRange(listingSection, listedEnd, range.m_address, ranges);
+            }
+
+            ranges.push_back(range);
+            listedEnd = std::max(listedEnd, range.m_address + range.m_size);
+        }
+
+        uint64_t sectionEnd = listingSection.m_header.m_addr + listingSection.m_header.m_size;
+
+        if (listedEnd < sectionEnd)
+        {
+            AddGapRange(listingSection, listedEnd, sectionEnd, ranges);
+        }
+    }
+
+    return true;
+}
+
+bool CodeObj::ExtractFunctionListingStream(const char* isaName, size_t chunkSize, ListingTextCallback pCallback, void* pUserData)
+{
+    if (isaName == nullptr || pCallback == nullptr || chunkSize == 0)
+    {
+        SetError(AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT, "ERROR: Invalid function listing stream arguments");
+        return false;
+    }
+
+    CodeObjSymbolInfo symbols;
+    std::vector<DisassemblyRange> ranges;
+    amd_comgr_disassembly_info_t info;
+    bool retCode = GetDisassemblyRanges(symbols, ranges) && GetDisassemblyInfo(isaName, info);
+
+    if (retCode)
+    {
+        ListingChunkWriter writer;
+        writer.m_chunk.reserve(chunkSize);
+        writer.m_chunkSize = chunkSize;
+        writer.m_pCallback = pCallback;
+        writer.m_pUserData = pUserData;
+
+        for (const DisassemblyRange& range : ranges)
+        {
+            retCode = DisassembleRange(info, range, WriteChunkedLine, &writer);
+
+            if (!retCode)
+            {
+                break;
+            }
+        }
+
+        retCode = retCode && FlushChunk(writer);
+
+        if (!retCode)
+        {
+            SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Function listing stopped by the callback");
+        }
+    }
+
+    ClearSymbolData(symbols);
+    return retCode;
+}
+
+bool CodeObj::GetDisassemblyInfo(const char* isaName, amd_comgr_disassembly_info_t& info)
+{
+    if (m_disassemblyInfo.handle == 0 || m_disassemblyIsa != isaName)
+    {
+        ReleaseDisassemblyInfo();
+
+        if (!CreateDisassemblyInfo(isaName, m_disassemblyInfo))
+        {
+            m_disassemblyInfo.handle = 0;
+            return false;
+        }
+
+        m_disassemblyIsa = isaName;
+    }
+
+    info = m_disassemblyInfo;
+    return true;
+}
+
+void CodeObj::ReleaseDisassemblyInfo()
+{
+    if (m_disassemblyInfo.handle != 0)
+    {
+        ComgrEntryPoints::Instance()->amd_comgr_destroy_disassembly_info_fn(m_disassemblyInfo);
+        m_disassemblyInfo.handle = 0;
+        m_disassemblyIsa.clear();
+    }
+}
+
+bool CodeObj::DisassembleFunction(const CodeObjSymbol& symbol, const std::string& isaName, std::vector<char>& assemblyBuffer)
+{
+    DisassemblyRange range;
+
+    if (!GetDisassemblyRange(symbol, range))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT, "ERROR: The symbol is not a function with code in the code object");
+        return false;
+    }
+
+    amd_comgr_disassembly_info_t info;
+
+    if (!GetDisassemblyInfo(isaName.c_str(), info))
+    {
+        return false;
+    }
+
+    assemblyBuffer.clear();
+    return DisassembleRange(info, range, AppendLine, &assemblyBuffer);
+}
+
+bool CodeObj::DisassembleFunction(const std::string& name, const std::string& isaName, std::vector<char>& assemblyBuffer)
+{
+    CodeObjSymbol symbol;
+
+    if (!FindSymbol(name, symbol))
+    {
+        SetError(AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT, "ERROR: Function symbol not found: " + name);
+        return false;
+    }
+
+    return DisassembleFunction(symbol, isaName, assemblyBuffer);
+}
+
+bool CodeObj::DisassembleRangesParallel(const char* isaName, const std::vector<DisassemblyRange>& ranges, uint32_t numWorkers, std::vector<char>& assemblyBuffer)
+{
+    WorkerPool pool(numWorkers);
+    size_t numGroups = std::min<size_t>(ranges.size(), static_cast<size_t>(pool.GetNumWorkers()) * s_DISASSEMBLY_GROUPS_PER_WORKER);
+    std::vector<DisassemblyGroup> groups(numGroups);
+
+    for (size_t i = 0; i < numGroups; ++i)
+    {
+        groups[i].m_firstRange = ranges.size() * i / numGroups;
+        groups[i].m_numRanges = ranges.size() * (i + 1) / numGroups - groups[i].m_firstRange;
+    }
+
+    // A comgr disassembler is not shared between threads, every group creates its own.
+    pool.ParallelFor(numGroups, [&](size_t index)
+    {
+        DisassemblyGroup& group = groups[index];
+        CodeObj::GetLastError();
+        amd_comgr_disassembly_info_t info;
+
+        if (!CreateDisassemblyInfo(isaName, info))
+        {
+            group.m_error = CodeObj::GetLastError();
+            return;
+        }
+
+        for (size_t i = group.m_firstRange; i < group.m_firstRange + group.m_numRanges; ++i)
+        {
+            DisassembleRange(info, ranges[i], AppendLine, &group.m_text);
+        }
+
+        ComgrEntryPoints::Instance()->amd_comgr_destroy_disassembly_info_fn(info);
+    });
+
+    size_t totalSize = 0;
+
+    for (const DisassemblyGroup& group : groups)
+    {
+        if (group.m_error.first != AMD_COMGR_STATUS_SUCCESS)
+        {
+            SetError(group.m_error.first, group.m_error.second);
+            return false;
+        }
+
+        totalSize += group.m_text.size();
+    }
+
+    assemblyBuffer.reserve(totalSize);
+
+    for (const DisassemblyGroup& group : groups)
+    {
+        assemblyBuffer.insert(assemblyBuffer.end(), group.m_text.begin(), group.m_text.end());
+    }
+
+    return true;
+}
+
+bool CodeObj::ExtractFunctionListing(std::vector<char>& listingBuffer, const std::string& isaName, uint32_t numWorkers)
+{
+    std::shared_ptr<DiskCache> pDiskCache = GetDiskCache(m_pDisassemblyDiskCache);
+    std::string key;
+
+    if (pDiskCache != nullptr)
+    {
+        // The listing does not depend on the number of workers, all share the entries.
+        std::string tag("function listing|");
+        tag.append(GetComgrVersionTag()).append("|").append(isaName);
+        key = DiskCache::MakeKey(m_pData, m_dataSize, tag);
+
+        if (pDiskCache->Load(key, listingBuffer))
+        {
+            return true;
+        }
+    }
+
+    bool retCode = ListFunctions(listingBuffer, isaName, numWorkers);
+
+    // The cache only speeds up later calls, a failed write is not an error.
+    if (retCode && pDiskCache != nullptr)
+    {
+        pDiskCache->Store(key, listingBuffer.data(), listingBuffer.size());
+    }
+
+    return retCode;
+}
+
+bool CodeObj::ListFunctions(std::vector<char>& listingBuffer, const std::string& isaName, uint32_t numWorkers)
+{
+    CodeObjSymbolInfo symbols;
+    std::vector<DisassemblyRange> ranges;
+    bool retCode = GetDisassemblyRanges(symbols, ranges);
+    listingBuffer.clear();
+
+    if (retCode && numWorkers != 1)
+    {
+        retCode = DisassembleRangesParallel(isaName.c_str(), ranges, numWorkers, listingBuffer);
+    }
+    else if (retCode)
+    {
+        amd_comgr_disassembly_info_t info;
+        retCode = GetDisassemblyInfo(isaName.c_str(), info);
+
+        for (size_t i = 0; retCode && i < ranges.size(); ++i)
+        {
+            DisassembleRange(info, ranges[i], AppendLine, &listingBuffer);
+        }
+    }
+
+    ClearSymbolData(symbols);
+    return retCode;
+}
+}
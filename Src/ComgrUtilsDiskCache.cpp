@@ -0,0 +1,406 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal content-addressed file cache used by the ComgrUtils disk caches.
+//============================================================================================
+#include "ComgrUtilsDiskCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dirent.h>
+    #include <signal.h>
+    #include <sys/stat.h>
+    #include <time.h>
+    #include <unistd.h>
+    #include <utime.h>
+#endif
+
+namespace AMDT
+{
+// Marks the start of a cache entry file, followed by the 64 bit payload size
+static const char   s_ENTRY_MAGIC[8]    = { 'C', 'U', 'D', 'C', 'A', 'C', 'H', '1' };
+static const size_t s_ENTRY_HEADER_SIZE = sizeof(s_ENTRY_MAGIC) + sizeof(uint64_t);
+
+// File name suffix of cache entries
+static const char*  s_ENTRY_SUFFIX      = ".cache";
+
+// Marks a temporary file of Store, followed by the writer's process id and a counter
+static const char*  s_TEMP_MARKER       = ".tmp.";
+
+// A temporary file this old is left over from a writer that crashed, even if its process id is in use again
+static const uint64_t s_STALE_TEMP_AGE_SECONDS = 60 * 60;
+
+// Multiplier and seeds of the key hash
+static const uint64_t s_HASH_MULTIPLIER = 0xc6a4a7935bd1e995ull;
+static const uint64_t s_HASH_SEED_LOW   = 0x9e3779b97f4a7c15ull;
+static const uint64_t s_HASH_SEED_HIGH  = 0x2545f4914f6cdd1dull;
+
+// Size and last use of one cache entry file or temporary file
+struct DiskCacheEntry
+{
+    std::string m_path;         // The file name
+    uint64_t    m_size;         // The file size in bytes
+    uint64_t    m_lastUse;      // The modification time, in nanoseconds or Windows file time ticks
+    bool        m_isTemp;       // True for a temporary file of Store
+};
+
+// Units of DiskCacheEntry::m_lastUse per second
+#ifdef _WIN32
+static const uint64_t s_TIME_UNITS_PER_SECOND = 10000000ull;
+#else
+static const uint64_t s_TIME_UNITS_PER_SECOND = 1000000000ull;
+#endif
+
+// MurmurHash64A over 8 byte words, continuing from a previous hash value
+static uint64_t HashBytes(const char* pData, size_t size, uint64_t hash)
+{
+    hash ^= size * s_HASH_MULTIPLIER;
+    size_t numWords = size / sizeof(uint64_t);
+
+    for (size_t i = 0; i < numWords; ++i)
+    {
+        uint64_t word;
+        memcpy(&word, pData + i * sizeof(uint64_t), sizeof(word));
+        word *= s_HASH_MULTIPLIER;
+        word ^= word >> 47;
+        word *= s_HASH_MULTIPLIER;
+        hash ^= word;
+        hash *= s_HASH_MULTIPLIER;
+    }
+
+    size_t tailSize = size % sizeof(uint64_t);
+
+    if (tailSize != 0)
+    {
+        uint64_t tail = 0;
+        memcpy(&tail, pData + numWords * sizeof(uint64_t), tailSize);
+        hash ^= tail;
+        hash *= s_HASH_MULTIPLIER;
+    }
+
+    hash ^= hash >> 47;
+    hash *= s_HASH_MULTIPLIER;
+    hash ^= hash >> 47;
+    return hash;
+}
+
+// Classify a file of a cache directory
+// Returns true for entry files and temporary files, setting isTemp for the latter
+static bool IsCacheFile(const char* pName, bool& isTemp)
+{
+    size_t nameLen = strlen(pName);
+    size_t suffixLen = strlen(s_ENTRY_SUFFIX);
+    isTemp = strstr(pName, s_TEMP_MARKER) != nullptr;
+    return isTemp || (nameLen > suffixLen && strcmp(pName + nameLen - suffixLen, s_ENTRY_SUFFIX) == 0);
+}
+
+// List the entry files and temporary files of a cache directory
+static void ListEntries(const std::string& directory, std::vector<DiskCacheEntry>& entries)
+{
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA((directory + "\\*").c_str(), &findData);
+
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    do
+    {
+        DiskCacheEntry entry;
+
+        if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 && IsCacheFile(findData.cFileName, entry.m_isTemp))
+        {
+            entry.m_path = directory + "\\" + findData.cFileName;
+            entry.m_size = (static_cast<uint64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow;
+            entry.m_lastUse = (static_cast<uint64_t>(findData.ftLastWriteTime.dwHighDateTime) << 32) | findData.ftLastWriteTime.dwLowDateTime;
+            entries.push_back(std::move(entry));
+        }
+    } while (FindNextFileA(hFind, &findData));
+
+    FindClose(hFind);
+#else
+    DIR* pDir = opendir(directory.c_str());
+
+    if (pDir == nullptr)
+    {
+        return;
+    }
+
+    while (struct dirent* pEntry = readdir(pDir))
+    {
+        DiskCacheEntry entry;
+
+        if (!IsCacheFile(pEntry->d_name, entry.m_isTemp))
+        {
+            continue;
+        }
+
+        entry.m_path = directory + "/" + pEntry->d_name;
+        struct stat fileStat;
+
+        if (stat(entry.m_path.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode))
+        {
+            entry.m_size = static_cast<uint64_t>(fileStat.st_size);
+#ifdef __APPLE__
+            entry.m_lastUse = static_cast<uint64_t>(fileStat.st_mtimespec.tv_sec) * 1000000000ull + fileStat.st_mtimespec.tv_nsec;
+#else
+            entry.m_lastUse = static_cast<uint64_t>(fileStat.st_mtim.tv_sec) * 1000000000ull + fileStat.st_mtim.tv_nsec;
+#endif
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    closedir(pDir);
+#endif
+}
+
+// Get the current time in the units of DiskCacheEntry::m_lastUse
+static uint64_t GetCurrentFileTime()
+{
+#ifdef _WIN32
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    return (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + now.tv_nsec;
+#endif
+}
+
+// Check if a temporary file was left over by a writer that crashed or was killed:
+// its writer process is gone, or it is older than any write takes
+static bool IsStaleTempFile(const DiskCacheEntry& entry, uint64_t now)
+{
+    if (now > entry.m_lastUse && now - entry.m_lastUse > s_STALE_TEMP_AGE_SECONDS * s_TIME_UNITS_PER_SECOND)
+    {
+        return true;
+    }
+
+    // The directory name may contain the marker as well, the file name is at the end.
+    const char* pProcessId = entry.m_path.c_str() + entry.m_path.rfind(s_TEMP_MARKER) + strlen(s_TEMP_MARKER);
+    char* pEnd = nullptr;
+    unsigned long processId = strtoul(pProcessId, &pEnd, 10);
+
+    if (pEnd == pProcessId || *pEnd != '.')
+    {
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE hProcess = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(processId));
+
+    if (hProcess == nullptr)
+    {
+        return GetLastError() == ERROR_INVALID_PARAMETER;
+    }
+
+    bool exited = WaitForSingleObject(hProcess, 0) == WAIT_OBJECT_0;
+    CloseHandle(hProcess);
+    return exited;
+#else
+    return kill(static_cast<pid_t>(processId), 0) != 0 && errno == ESRCH;
+#endif
+}
+
+// Set the modification time of a file to now, marking a cache entry as recently used
+static void TouchFile(const std::string& path)
+{
+#ifdef _WIN32
+    HANDLE hFile = CreateFileA(path.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        SetFileTime(hFile, nullptr, nullptr, &now);
+        CloseHandle(hFile);
+    }
+#else
+    utime(path.c_str(), nullptr);
+#endif
+}
+
+// Replace a file by another one in a single step
+static bool MoveEntryFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+DiskCache::DiskCache(const std::string& directory, uint64_t maxSizeInBytes) : m_directory(directory), m_maxSizeInBytes(maxSizeInBytes)
+{
+#ifdef _WIN32
+    CreateDirectoryA(m_directory.c_str(), nullptr);
+#else
+    mkdir(m_directory.c_str(), 0755);
+#endif
+}
+
+std::string DiskCache::MakeKey(const char* pData, size_t size, const std::string& tag)
+{
+    uint64_t hashes[2] = { HashBytes(pData, size, s_HASH_SEED_LOW), HashBytes(pData, size, s_HASH_SEED_HIGH) };
+    std::string key;
+
+    for (uint64_t hash : hashes)
+    {
+        char buf[17];
+        hash = HashBytes(tag.data(), tag.size(), hash);
+        snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+        key.append(buf);
+    }
+
+    return key;
+}
+
+std::string DiskCache::GetEntryPath(const std::string& key) const
+{
+    return m_directory + "/" + key + s_ENTRY_SUFFIX;
+}
+
+bool DiskCache::Load(const std::string& key, std::vector<char>& data) const
+{
+    std::string path = GetEntryPath(key);
+    FILE* pFile = fopen(path.c_str(), "rb");
+
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    // The payload size must match the file size, so a damaged entry is never trusted.
+    char header[s_ENTRY_HEADER_SIZE];
+    uint64_t size = 0;
+    long fileSize = (fseek(pFile, 0, SEEK_END) == 0 ? ftell(pFile) : -1);
+    bool retCode = fileSize >= static_cast<long>(s_ENTRY_HEADER_SIZE) && fseek(pFile, 0, SEEK_SET) == 0 &&
+                   fread(header, 1, sizeof(header), pFile) == sizeof(header) && memcmp(header, s_ENTRY_MAGIC, sizeof(s_ENTRY_MAGIC)) == 0;
+
+    if (retCode)
+    {
+        memcpy(&size, header + sizeof(s_ENTRY_MAGIC), sizeof(size));
+        retCode = size == static_cast<uint64_t>(fileSize) - s_ENTRY_HEADER_SIZE;
+    }
+
+    if (retCode)
+    {
+        data.resize(static_cast<size_t>(size));
+        retCode = fread(data.data(), 1, data.size(), pFile) == data.size();
+    }
+
+    fclose(pFile);
+
+    if (retCode)
+    {
+        TouchFile(path);
+    }
+    else
+    {
+        data.clear();
+    }
+
+    return retCode;
+}
+
+bool DiskCache::Store(const std::string& key, const char* pData, size_t size)
+{
+    static std::atomic<uint32_t> s_tempCounter(0);
+
+#ifdef _WIN32
+    unsigned long processId = GetCurrentProcessId();
+#else
+    unsigned long processId = static_cast<unsigned long>(getpid());
+#endif
+
+    // The temporary name is unique per process and call, so concurrent writers never share a file.
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".tmp.%lu.%u", processId, s_tempCounter.fetch_add(1));
+    std::string path = GetEntryPath(key);
+    std::string tempPath = m_directory + "/" + key + suffix;
+
+    FILE* pFile = fopen(tempPath.c_str(), "wb");
+
+    if (pFile == nullptr)
+    {
+        return false;
+    }
+
+    uint64_t payloadSize = size;
+    bool retCode = fwrite(s_ENTRY_MAGIC, 1, sizeof(s_ENTRY_MAGIC), pFile) == sizeof(s_ENTRY_MAGIC) &&
+                   fwrite(&payloadSize, 1, sizeof(payloadSize), pFile) == sizeof(payloadSize) &&
+                   (size == 0 || fwrite(pData, 1, size, pFile) == size);
+    retCode = (fclose(pFile) == 0) && retCode;
+    retCode = retCode && MoveEntryFile(tempPath, path);
+
+    if (!retCode)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+
+    Evict(path);
+    return true;
+}
+
+void DiskCache::Evict(const std::string& keepPath)
+{
+    if (m_maxSizeInBytes == 0)
+    {
+        return;
+    }
+
+    std::vector<DiskCacheEntry> entries;
+    ListEntries(m_directory, entries);
+    uint64_t totalSize = 0;
+    uint64_t now = GetCurrentFileTime();
+
+    // Temporary files count toward the cap too. Those of writers that are gone are removed;
+    // those of running writers are kept and shrink the room left for entries.
+    for (size_t i = 0; i < entries.size();)
+    {
+        if (entries[i].m_isTemp && IsStaleTempFile(entries[i], now))
+        {
+            remove(entries[i].m_path.c_str());
+            entries.erase(entries.begin() + i);
+            continue;
+        }
+
+        totalSize += entries[i].m_size;
+        ++i;
+    }
+
+    if (totalSize <= m_maxSizeInBytes)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const DiskCacheEntry& lhs, const DiskCacheEntry& rhs)
+    {
+        return lhs.m_lastUse < rhs.m_lastUse;
+    });
+
+    // Another process may remove the same entries at the same time, a failed removal is not an error.
+    for (size_t i = 0; i < entries.size() && totalSize > m_maxSizeInBytes; ++i)
+    {
+        if (!entries[i].m_isTemp && entries[i].m_path != keepPath)
+        {
+            remove(entries[i].m_path.c_str());
+            totalSize -= entries[i].m_size;
+        }
+    }
+}
+}
@@ -0,0 +1,73 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal content-addressed file cache used by the ComgrUtils disk caches.
+//============================================================================================
+#ifndef COMGR_UTILS_DISK_CACHE_H_
+#define COMGR_UTILS_DISK_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace AMDT
+{
+/// Keeps blobs as files in a directory, one file per key.
+/// Files are written to a temporary name and renamed into place, so readers never see a partial
+/// entry, and several processes can share a directory. A hit refreshes the modification time of
+/// the file; when the files exceed the size cap, the least recently used ones are deleted.
+/// Temporary files count toward the cap, and those left by writers that crashed are deleted.
+class DiskCache
+{
+public:
+    /// Constructor.
+    /// \param directory the cache directory; it is created if it does not exist.
+    /// \param maxSizeInBytes the size cap of all entries, 0 for no cap.
+    DiskCache(const std::string& directory, uint64_t maxSizeInBytes);
+
+    /// Get the cache directory.
+    /// \return the directory.
+    const std::string& GetDirectory() const
+    {
+        return m_directory;
+    }
+
+    /// Hash data and a tag into a cache key.
+    /// \param pData the data, like the bytes of a code object.
+    /// \param size the size of the data in bytes.
+    /// \param tag everything else the cached result depends on, like options and library versions.
+    /// \return the key, 32 hexadecimal digits.
+    static std::string MakeKey(const char* pData, size_t size, const std::string& tag);
+
+    /// Read an entry.
+    /// \param key the key, from MakeKey.
+    /// \param data receives the entry.
+    /// \return true if the entry exists and is complete, false otherwise.
+    bool Load(const std::string& key, std::vector<char>& data) const;
+
+    /// Write an entry, replacing an existing entry of the same key, then evict entries over the size cap.
+    /// \param key the key, from MakeKey.
+    /// \param pData the data.
+    /// \param size the size of the data in bytes.
+    /// \return true if the entry was written, false otherwise.
+    bool Store(const std::string& key, const char* pData, size_t size);
+
+private:
+    /// Get the file name of an entry.
+    /// \param key the key.
+    /// \return the file name.
+    std::string GetEntryPath(const std::string& key) const;
+
+    /// Delete stale temporary files, then the least recently used entries until the entries and
+    /// the temporary files of running writers fit the size cap.
+    /// \param keepPath the file name of the entry just written, which is never deleted.
+    void Evict(const std::string& keepPath);
+
+    std::string m_directory;        ///< The cache directory.
+    uint64_t    m_maxSizeInBytes;   ///< The size cap of all entries, 0 for no cap.
+};
+}
+
+#endif
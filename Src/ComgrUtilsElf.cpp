@@ -0,0 +1,215 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal read-only ELF64 reader used to parse code objects without comgr.
+//============================================================================================
+#include "ComgrUtilsElf.h"
+
+#include <cstring>
+
+namespace AMDT
+{
+static_assert(sizeof(Elf64Header) == 64, "Unexpected ELF64 header size");
+static_assert(sizeof(Elf64SectionHeader) == 64, "Unexpected ELF64 section header size");
+static_assert(sizeof(Elf64ProgramHeader) == 56, "Unexpected ELF64 program header size");
+static_assert(sizeof(Elf64Symbol) == 24, "Unexpected ELF64 symbol size");
+
+static const uint8_t  s_ELF_CLASS_64        = 2;        // EI_CLASS value for 64-bit files
+static const uint8_t  s_ELF_DATA_LSB        = 1;        // EI_DATA value for little-endian files
+static const uint16_t s_ELF_SHN_XINDEX      = 0xffff;   // Section name table index is stored in section 0
+
+// Round a note field size up to the 4 byte note alignment
+static size_t AlignNote(size_t size)
+{
+    return (size + 3) & ~static_cast<size_t>(3);
+}
+
+bool ElfReader::Init(const char* pData, size_t size)
+{
+    m_pData = nullptr;
+    m_size = 0;
+    m_numSections = 0;
+    m_sectionNameIndex = 0;
+
+    if (pData == nullptr || size < sizeof(Elf64Header))
+    {
+        return false;
+    }
+
+    // The headers are read in host byte order, so only little-endian files are supported.
+    memcpy(&m_header, pData, sizeof(Elf64Header));
+
+    if (m_header.m_ident[0] != 0x7f || m_header.m_ident[1] != 'E' || m_header.m_ident[2] != 'L' || m_header.m_ident[3] != 'F' ||
+        m_header.m_ident[4] != s_ELF_CLASS_64 || m_header.m_ident[5] != s_ELF_DATA_LSB)
+    {
+        return false;
+    }
+
+    m_pData = pData;
+    m_size = size;
+
+    if (m_header.m_shoff != 0)
+    {
+        if (m_header.m_shentsize != sizeof(Elf64SectionHeader) || !IsInFile(m_header.m_shoff, sizeof(Elf64SectionHeader)))
+        {
+            m_pData = nullptr;
+            m_size = 0;
+            return false;
+        }
+
+        Elf64SectionHeader firstSection;
+        memcpy(&firstSection, m_pData + m_header.m_shoff, sizeof(Elf64SectionHeader));
+
+        // Files with many sections store the real counts in the first section header.
+        uint64_t numSections = (m_header.m_shnum != 0 ? m_header.m_shnum : firstSection.m_size);
+        m_sectionNameIndex = (m_header.m_shstrndx != s_ELF_SHN_XINDEX ? m_header.m_shstrndx : firstSection.m_link);
+
+        if (numSections > UINT32_MAX || !IsInFile(m_header.m_shoff, numSections * sizeof(Elf64SectionHeader)))
+        {
+            m_pData = nullptr;
+            m_size = 0;
+            return false;
+        }
+
+        m_numSections = static_cast<uint32_t>(numSections);
+    }
+
+    return true;
+}
+
+bool ElfReader::GetSection(uint32_t index, Elf64SectionHeader& section) const
+{
+    if (index >= m_numSections)
+    {
+        return false;
+    }
+
+    memcpy(&section, m_pData + m_header.m_shoff + static_cast<uint64_t>(index) * sizeof(Elf64SectionHeader), sizeof(Elf64SectionHeader));
+    return true;
+}
+
+const char* ElfReader::GetSectionData(const Elf64SectionHeader& section) const
+{
+    return (IsInFile(section.m_offset, section.m_size) ? m_pData + section.m_offset : nullptr);
+}
+
+const char* ElfReader::GetSectionName(const Elf64SectionHeader& section) const
+{
+    Elf64SectionHeader nameTable;
+
+    if (!GetSection(m_sectionNameIndex, nameTable))
+    {
+        return "";
+    }
+
+    const char* pName = GetString(nameTable, section.m_name, nullptr);
+    return (pName != nullptr ? pName : "");
+}
+
+const char* ElfReader::GetString(const Elf64SectionHeader& stringTable, uint32_t offset, size_t* pLength) const
+{
+    const char* pTable = GetSectionData(stringTable);
+
+    if (pTable == nullptr || offset >= stringTable.m_size)
+    {
+        return nullptr;
+    }
+
+    const char* pString = pTable + offset;
+    const void* pTerminator = memchr(pString, '\0', static_cast<size_t>(stringTable.m_size - offset));
+
+    if (pTerminator == nullptr)
+    {
+        return nullptr;
+    }
+
+    if (pLength != nullptr)
+    {
+        *pLength = static_cast<const char*>(pTerminator) - pString;
+    }
+
+    return pString;
+}
+
+bool ElfReader::FindNoteInBlock(const char* pNotes, size_t size, const char* pName, uint32_t type, const uint8_t*& pDesc, size_t& descSize)
+{
+    static const size_t s_NOTE_HEADER_SIZE = 3 * sizeof(uint32_t);
+    size_t nameLen = strlen(pName) + 1;
+    size_t offset = 0;
+
+    while (size - offset >= s_NOTE_HEADER_SIZE)
+    {
+        uint32_t noteHeader[3];
+        memcpy(noteHeader, pNotes + offset, s_NOTE_HEADER_SIZE);
+        offset += s_NOTE_HEADER_SIZE;
+
+        size_t noteNameSize = AlignNote(noteHeader[0]);
+        size_t noteDescSize = AlignNote(noteHeader[1]);
+
+        if (noteNameSize > size - offset || noteDescSize > size - offset - noteNameSize)
+        {
+            return false;
+        }
+
+        if (noteHeader[2] == type && noteHeader[0] == nameLen && memcmp(pNotes + offset, pName, nameLen) == 0)
+        {
+            pDesc = reinterpret_cast<const uint8_t*>(pNotes + offset + noteNameSize);
+            descSize = noteHeader[1];
+            return true;
+        }
+
+        offset += noteNameSize + noteDescSize;
+    }
+
+    return false;
+}
+
+bool ElfReader::FindNote(const char* pName, uint32_t type, const uint8_t*& pDesc, size_t& descSize) const
+{
+    if (m_pData == nullptr)
+    {
+        return false;
+    }
+
+    if (m_numSections > 0)
+    {
+        for (uint32_t i = 0; i < m_numSections; ++i)
+        {
+            Elf64SectionHeader section;
+            GetSection(i, section);
+
+            if (section.m_type == ELF_SHT_NOTE)
+            {
+                const char* pNotes = GetSectionData(section);
+
+                if (pNotes != nullptr && FindNoteInBlock(pNotes, static_cast<size_t>(section.m_size), pName, type, pDesc, descSize))
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    if (m_header.m_phentsize != sizeof(Elf64ProgramHeader) || !IsInFile(m_header.m_phoff, static_cast<uint64_t>(m_header.m_phnum) * sizeof(Elf64ProgramHeader)))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < m_header.m_phnum; ++i)
+    {
+        Elf64ProgramHeader segment;
+        memcpy(&segment, m_pData + m_header.m_phoff + static_cast<uint64_t>(i) * sizeof(Elf64ProgramHeader), sizeof(Elf64ProgramHeader));
+
+        if (segment.m_type == ELF_PT_NOTE && IsInFile(segment.m_offset, segment.m_filesz) &&
+            FindNoteInBlock(m_pData + segment.m_offset, static_cast<size_t>(segment.m_filesz), pName, type, pDesc, descSize))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+}
@@ -0,0 +1,183 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal read-only ELF64 reader used to parse code objects without comgr.
+//============================================================================================
+#ifndef COMGR_UTILS_ELF_H_
+#define COMGR_UTILS_ELF_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AMDT
+{
+/// ELF64 file header.
+struct Elf64Header
+{
+    uint8_t     m_ident[16];    ///< Identification bytes.
+    uint16_t    m_type;         ///< Object file type.
+    uint16_t    m_machine;      ///< Target architecture.
+    uint32_t    m_version;      ///< Object file version.
+    uint64_t    m_entry;        ///< Entry point address.
+    uint64_t    m_phoff;        ///< Program header table offset.
+    uint64_t    m_shoff;        ///< Section header table offset.
+    uint32_t    m_flags;        ///< Processor specific flags.
+    uint16_t    m_ehsize;       ///< ELF header size.
+    uint16_t    m_phentsize;    ///< Program header entry size.
+    uint16_t    m_phnum;        ///< Number of program header entries.
+    uint16_t    m_shentsize;    ///< Section header entry size.
+    uint16_t    m_shnum;        ///< Number of section header entries.
+    uint16_t    m_shstrndx;     ///< Section name string table index.
+};
+
+/// ELF64 section header.
+struct Elf64SectionHeader
+{
+    uint32_t    m_name;         ///< Section name (offset into the section name string table).
+    uint32_t    m_type;         ///< Section type.
+    uint64_t    m_flags;        ///< Section flags.
+    uint64_t    m_addr;         ///< Section virtual address.
+    uint64_t    m_offset;       ///< Section file offset.
+    uint64_t    m_size;         ///< Section size in bytes.
+    uint32_t    m_link;         ///< Link to another section.
+    uint32_t    m_info;         ///< Additional section information.
+    uint64_t    m_addralign;    ///< Section alignment.
+    uint64_t    m_entsize;      ///< Entry size if the section holds a table.
+};
+
+/// ELF64 program header.
+struct Elf64ProgramHeader
+{
+    uint32_t    m_type;         ///< Segment type.
+    uint32_t    m_flags;        ///< Segment flags.
+    uint64_t    m_offset;       ///< Segment file offset.
+    uint64_t    m_vaddr;        ///< Segment virtual address.
+    uint64_t    m_paddr;        ///< Segment physical address.
+    uint64_t    m_filesz;       ///< Segment size in the file.
+    uint64_t    m_memsz;        ///< Segment size in memory.
+    uint64_t    m_align;        ///< Segment alignment.
+};
+
+/// ELF64 symbol table entry.
+struct Elf64Symbol
+{
+    uint32_t    m_name;         ///< Symbol name (offset into the linked string table).
+    uint8_t     m_info;         ///< Symbol type and binding.
+    uint8_t     m_other;        ///< Symbol visibility.
+    uint16_t    m_shndx;        ///< Section index.
+    uint64_t    m_value;        ///< Symbol value.
+    uint64_t    m_size;         ///< Symbol size.
+};
+
+static const uint32_t ELF_SHT_SYMTAB            = 2;    ///< Symbol table section type.
+static const uint32_t ELF_SHT_STRTAB            = 3;    ///< String table section type.
+static const uint32_t ELF_SHT_NOTE              = 7;    ///< Note section type.
+static const uint32_t ELF_SHT_NOBITS            = 8;    ///< Section type of sections without file contents.
+static const uint64_t ELF_SHF_EXECINSTR         = 0x4;  ///< Flag of sections holding executable code.
+static const uint32_t ELF_PT_NOTE               = 4;    ///< Note segment type.
+static const uint8_t  ELF_STT_FUNC              = 2;    ///< Function symbol type.
+static const uint8_t  ELF_STT_AMDGPU_HSA_KERNEL = 10;   ///< Symbol type of the kernels of code object v2.
+
+/// Read-only view of an ELF64 little-endian file held in memory.
+/// All accessors are bounds checked against the size of the file; the reader does not own the bytes.
+class ElfReader
+{
+public:
+    /// Default constructor.
+    ElfReader() : m_pData(nullptr), m_size(0), m_numSections(0), m_sectionNameIndex(0), m_header() {}
+
+    /// Validate the ELF header and the section header table.
+    /// \param pData the file bytes.
+    /// \param size the size of the file in bytes.
+    /// \return true if the bytes hold a supported ELF64 little-endian file, false otherwise.
+    bool Init(const char* pData, size_t size);
+
+    /// Get the ELF file header.
+    /// \return the header.
+    const Elf64Header& GetHeader() const
+    {
+        return m_header;
+    }
+
+    /// Get the number of sections.
+    /// \return the number of sections.
+    uint32_t GetNumSections() const
+    {
+        return m_numSections;
+    }
+
+    /// Get a section header.
+    /// \param index the section index.
+    /// \param section receives the section header.
+    /// \return true if successful, false otherwise.
+    bool GetSection(uint32_t index, Elf64SectionHeader& section) const;
+
+    /// Get the contents of a section.
+    /// \param section the section header.
+    /// \return pointer to the section contents, nullptr if the section lies outside the file.
+    const char* GetSectionData(const Elf64SectionHeader& section) const;
+
+    /// Get the name of a section.
+    /// \param section the section header.
+    /// \return the null terminated section name, "" if it can not be read.
+    const char* GetSectionName(const Elf64SectionHeader& section) const;
+
+    /// Get a null terminated string from a string table section.
+    /// \param stringTable the string table section header.
+    /// \param offset the offset of the string in the table.
+    /// \param pLength receives the length of the string, may be nullptr.
+    /// \return the string, nullptr if it is out of bounds or not terminated.
+    const char* GetString(const Elf64SectionHeader& stringTable, uint32_t offset, size_t* pLength) const;
+
+    /// Find the descriptor of a note in the note sections (or note segments if there are no sections).
+    /// \param pName the note owner name.
+    /// \param type the note type.
+    /// \param pDesc receives the note descriptor.
+    /// \param descSize receives the size of the note descriptor in bytes.
+    /// \return true if the note was found, false otherwise.
+    bool FindNote(const char* pName, uint32_t type, const uint8_t*& pDesc, size_t& descSize) const;
+
+    /// Get the bytes of the file.
+    /// \return pointer to the first byte.
+    const char* GetData() const
+    {
+        return m_pData;
+    }
+
+    /// Get the size of the file.
+    /// \return the size in bytes.
+    size_t GetSize() const
+    {
+        return m_size;
+    }
+
+private:
+    /// Check if a byte range lies within the file.
+    /// \param offset the offset of the range.
+    /// \param size the size of the range.
+    /// \return true if the range is within the file, false otherwise.
+    bool IsInFile(uint64_t offset, uint64_t size) const
+    {
+        return offset <= m_size && size <= m_size - offset;
+    }
+
+    /// Search a block of notes for a note.
+    /// \param pNotes the note block.
+    /// \param size the size of the note block in bytes.
+    /// \param pName the note owner name.
+    /// \param type the note type.
+    /// \param pDesc receives the note descriptor.
+    /// \param descSize receives the size of the note descriptor in bytes.
+    /// \return true if the note was found, false otherwise.
+    static bool FindNoteInBlock(const char* pNotes, size_t size, const char* pName, uint32_t type, const uint8_t*& pDesc, size_t& descSize);
+
+    const char*     m_pData;            ///< The file bytes.
+    size_t          m_size;             ///< The size of the file in bytes.
+    uint32_t        m_numSections;      ///< The number of sections.
+    uint32_t        m_sectionNameIndex; ///< The index of the section name string table.
+    Elf64Header     m_header;           ///< The file header.
+};
+}
+
+#endif
@@ -0,0 +1,311 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Materialized flat copy of a comgr metadata tree.
+//============================================================================================
+#include "ComgrUtils.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace AMDT
+{
+const uint32_t MetadataSnapshot::s_NO_KEY;
+
+// Key and value nodes of one map entry, collected during map iteration
+struct MapEntryHandles
+{
+    ComgrMetadataNode m_key;    // The key node
+    ComgrMetadataNode m_value;  // The value node
+};
+
+extern "C" amd_comgr_status_t
+SnapshotMapIterCallback(amd_comgr_metadata_node_t key, amd_comgr_metadata_node_t val, void* data)
+{
+    // The callback owns both nodes, they are destroyed with the entries.
+    MapEntryHandles entry;
+    entry.m_key.Reset(key);
+    entry.m_value.Reset(val);
+    std::vector<MapEntryHandles>* pEntries = static_cast<std::vector<MapEntryHandles>*>(data);
+
+    if (pEntries == nullptr)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    pEntries->push_back(std::move(entry));
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+bool MetadataSnapshot::Build(const MDNode& root)
+{
+    m_nodes.clear();
+    m_strings.clear();
+    m_keyIndex.Clear();
+    m_keys.clear();
+
+    if (!root.IsValid())
+    {
+        return false;
+    }
+
+    Node rootNode = {MDNode::Kind::None, s_NO_KEY, 0, 0};
+    m_nodes.push_back(rootNode);
+
+    if (!StoreNode(root.m_handle.Get(), 0))
+    {
+        m_nodes.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool MetadataSnapshot::StoreString(amd_comgr_metadata_node_t handle, uint32_t& offset, uint32_t& length)
+{
+    size_t size = 0;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(handle, &size, nullptr);
+    CheckStatus(status, false);
+
+    // The size includes the null terminator
+    offset = static_cast<uint32_t>(m_strings.size());
+    m_strings.resize(m_strings.size() + size + 1, '\0');
+    status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_string_fn(handle, &size, &m_strings[offset]);
+    CheckStatus(status, false);
+
+    length = static_cast<uint32_t>(strlen(&m_strings[offset]));
+    m_strings.resize(offset + length + 1);
+    return true;
+}
+
+bool MetadataSnapshot::StoreNode(amd_comgr_metadata_node_t handle, uint32_t index)
+{
+    amd_comgr_metadata_kind_t kind = AMD_COMGR_METADATA_KIND_NULL;
+    amd_comgr_status_t status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_kind_fn(handle, &kind);
+    CheckStatus(status, false);
+
+    bool retCode = true;
+
+    switch (kind)
+    {
+        case AMD_COMGR_METADATA_KIND_STRING:
+        {
+            uint32_t offset = 0;
+            uint32_t length = 0;
+            retCode = StoreString(handle, offset, length);
+            m_nodes[index].m_kind = MDNode::Kind::String;
+            m_nodes[index].m_first = offset;
+            m_nodes[index].m_count = length;
+            break;
+        }
+
+        case AMD_COMGR_METADATA_KIND_LIST:
+        {
+            size_t listSize = 0;
+            status = ComgrEntryPoints::Instance()->amd_comgr_get_metadata_list_size_fn(handle, &listSize);
+            CheckStatus(status, false);
+
+            // Reserve consecutive slots for the children before storing any grandchildren
+            uint32_t first = static_cast<uint32_t>(m_nodes.size());
+            Node child = {MDNode::Kind::None, s_NO_KEY, 0, 0};
+            m_nodes.resize(m_nodes.size() + listSize, child);
+            m_nodes[index].m_kind = MDNode::Kind::List;
+            m_nodes[index].m_first = first;
+            m_nodes[index].m_count = static_cast<uint32_t>(listSize);
+
+            for (size_t i = 0; retCode && i < listSize; ++i)
+            {
+                ComgrMetadataNode childHandle;
+                status = ComgrEntryPoints::Instance()->amd_comgr_index_list_metadata_fn(handle, i, childHandle.Receive());
+                CheckStatus(status, false);
+
+                retCode = StoreNode(childHandle.Get(), first + static_cast<uint32_t>(i));
+            }
+
+            break;
+        }
+
+        case AMD_COMGR_METADATA_KIND_MAP:
+        {
+            std::vector<MapEntryHandles> entries;
+            status = ComgrEntryPoints::Instance()->amd_comgr_iterate_map_metadata_fn(handle, SnapshotMapIterCallback, &entries);
+            retCode = (status == AMD_COMGR_STATUS_SUCCESS);
+
+            if (!retCode)
+            {
+                CodeObj::SetError(status);
+            }
+
+            uint32_t first = static_cast<uint32_t>(m_nodes.size());
+            Node child = {MDNode::Kind::None, s_NO_KEY, 0, 0};
+            m_nodes.resize(m_nodes.size() + entries.size(), child);
+            m_nodes[index].m_kind = MDNode::Kind::Map;
+            m_nodes[index].m_first = first;
+            m_nodes[index].m_count = static_cast<uint32_t>(entries.size());
+
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                uint32_t childIndex = first + static_cast<uint32_t>(i);
+
+                if (retCode)
+                {
+                    // Keys are interned through the string pool; only the first copy of a key is kept
+                    uint32_t offset = 0;
+                    uint32_t length = 0;
+                    retCode = StoreString(entries[i].m_key.Get(), offset, length);
+
+                    if (retCode)
+                    {
+                        uint32_t keyId = FindKeyId(&m_strings[offset], length);
+
+                        if (keyId == s_NO_KEY)
+                        {
+                            keyId = static_cast<uint32_t>(m_keys.size());
+                            m_keys.push_back(m_keyIndex.Insert(&m_strings[offset], length, keyId));
+                        }
+
+                        m_strings.resize(offset);
+                        m_nodes[childIndex].m_keyId = keyId;
+                        retCode = StoreNode(entries[i].m_value.Get(), childIndex);
+                    }
+                }
+            }
+
+            break;
+        }
+
+        case AMD_COMGR_METADATA_KIND_NULL:
+        default:
+            m_nodes[index].m_kind = MDNode::Kind::None;
+            break;
+    }
+
+    return retCode;
+}
+
+MDNode::Kind MetadataSnapshotNode::GetKind() const
+{
+    return IsValid() ? m_pSnapshot->m_nodes[m_index].m_kind : MDNode::Kind::None;
+}
+
+MetadataSnapshotNode MetadataSnapshotNode::operator[](size_t idx) const
+{
+    if (GetKind() == MDNode::Kind::List && idx < m_pSnapshot->m_nodes[m_index].m_count)
+    {
+        return MetadataSnapshotNode(m_pSnapshot, m_pSnapshot->m_nodes[m_index].m_first + static_cast<uint32_t>(idx));
+    }
+
+    return MetadataSnapshotNode();
+}
+
+MetadataSnapshotNode MetadataSnapshotNode::operator[](const std::string& key) const
+{
+    if (GetKind() == MDNode::Kind::Map)
+    {
+        const MetadataSnapshot::Node& node = m_pSnapshot->m_nodes[m_index];
+        uint32_t keyId = m_pSnapshot->FindKeyId(key.data(), key.size());
+
+        for (uint32_t i = node.m_first; keyId != MetadataSnapshot::s_NO_KEY && i < node.m_first + node.m_count; ++i)
+        {
+            if (m_pSnapshot->m_nodes[i].m_keyId == keyId)
+            {
+                return MetadataSnapshotNode(m_pSnapshot, i);
+            }
+        }
+    }
+
+    return MetadataSnapshotNode();
+}
+
+MetadataSnapshotNode MetadataSnapshotNode::operator[](const char* key) const
+{
+    if (GetKind() == MDNode::Kind::Map && key != nullptr)
+    {
+        const MetadataSnapshot::Node& node = m_pSnapshot->m_nodes[m_index];
+        uint32_t keyId = m_pSnapshot->FindKeyId(key, strlen(key));
+
+        for (uint32_t i = node.m_first; keyId != MetadataSnapshot::s_NO_KEY && i < node.m_first + node.m_count; ++i)
+        {
+            if (m_pSnapshot->m_nodes[i].m_keyId == keyId)
+            {
+                return MetadataSnapshotNode(m_pSnapshot, i);
+            }
+        }
+    }
+
+    return MetadataSnapshotNode();
+}
+
+bool MetadataSnapshotNode::Find(const std::string& key) const
+{
+    return (*this)[key].IsValid();
+}
+
+const char* MetadataSnapshotNode::GetString() const
+{
+    if (GetKind() == MDNode::Kind::String)
+    {
+        return &m_pSnapshot->m_strings[m_pSnapshot->m_nodes[m_index].m_first];
+    }
+
+    return "";
+}
+
+const char* MetadataSnapshotNode::GetKey() const
+{
+    if (IsValid() && m_pSnapshot->m_nodes[m_index].m_keyId != MetadataSnapshot::s_NO_KEY)
+    {
+        return m_pSnapshot->m_keys[m_pSnapshot->m_nodes[m_index].m_keyId];
+    }
+
+    return "";
+}
+
+size_t MetadataSnapshotNode::size() const
+{
+    MDNode::Kind kind = GetKind();
+    return (kind == MDNode::Kind::List || kind == MDNode::Kind::Map) ? m_pSnapshot->m_nodes[m_index].m_count : 0;
+}
+
+std::vector<std::string> MetadataSnapshotNode::GetKeys() const
+{
+    std::vector<std::string> keys;
+
+    if (GetKind() == MDNode::Kind::Map)
+    {
+        const MetadataSnapshot::Node& node = m_pSnapshot->m_nodes[m_index];
+        keys.reserve(node.m_count);
+
+        for (uint32_t i = node.m_first; i < node.m_first + node.m_count; ++i)
+        {
+            keys.push_back(m_pSnapshot->m_keys[m_pSnapshot->m_nodes[i].m_keyId]);
+        }
+    }
+
+    return keys;
+}
+
+uint64_t MetadataSnapshotNode::GetUInt64() const
+{
+    // Decoded like MDNode::value, booleans are stored as strings as well.
+    const char* pString = GetString();
+    uint64_t val = 0;
+    ParseMDUnsigned(pString, strlen(pString), val);
+    return val;
+}
+
+int64_t MetadataSnapshotNode::GetInt64() const
+{
+    const char* pString = GetString();
+    int64_t val = 0;
+    ParseMDSigned(pString, strlen(pString), val);
+    return val;
+}
+
+double MetadataSnapshotNode::GetDouble() const
+{
+    return strtod(GetString(), nullptr);
+}
+}
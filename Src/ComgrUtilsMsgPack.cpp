@@ -0,0 +1,300 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal forward-only MsgPack reader used to decode code object metadata notes.
+//============================================================================================
+#include "ComgrUtilsMsgPack.h"
+
+namespace AMDT
+{
+bool MsgPackReader::ReadBigEndian(uint32_t numBytes, uint64_t& value)
+{
+    if (m_size - m_offset < numBytes)
+    {
+        return false;
+    }
+
+    value = 0;
+
+    for (uint32_t i = 0; i < numBytes; ++i)
+    {
+        value = (value << 8) | m_pData[m_offset++];
+    }
+
+    return true;
+}
+
+bool MsgPackReader::Read(Object& object)
+{
+    object.m_type = Type::Invalid;
+    object.m_value = 0;
+    object.m_length = 0;
+    object.m_pPayload = nullptr;
+
+    if (AtEnd())
+    {
+        return false;
+    }
+
+    size_t start = m_offset;
+    uint8_t marker = m_pData[m_offset++];
+    uint64_t length = 0;
+    bool ok = true;
+
+    if (marker <= 0x7f)
+    {
+        object.m_type = Type::UInt;
+        object.m_value = marker;
+    }
+    else if (marker <= 0x8f)
+    {
+        object.m_type = Type::Map;
+        object.m_length = marker & 0x0f;
+    }
+    else if (marker <= 0x9f)
+    {
+        object.m_type = Type::Array;
+        object.m_length = marker & 0x0f;
+    }
+    else if (marker <= 0xbf)
+    {
+        object.m_type = Type::String;
+        length = marker & 0x1f;
+    }
+    else if (marker >= 0xe0)
+    {
+        object.m_type = Type::Int;
+        object.m_value = static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(marker)));
+    }
+    else
+    {
+        switch (marker)
+        {
+            case 0xc0:
+                object.m_type = Type::Nil;
+                break;
+
+            case 0xc2:
+            case 0xc3:
+                object.m_type = Type::Bool;
+                object.m_value = marker - 0xc2;
+                break;
+
+            case 0xc4:
+            case 0xc5:
+            case 0xc6:
+                object.m_type = Type::Binary;
+                ok = ReadBigEndian(1u << (marker - 0xc4), length);
+                break;
+
+            case 0xc7:
+            case 0xc8:
+            case 0xc9:
+                object.m_type = Type::Extension;
+                ok = ReadBigEndian(1u << (marker - 0xc7), length);
+                length += 1;    // The extension type byte is part of the payload.
+                break;
+
+            case 0xca:
+            case 0xcb:
+                object.m_type = Type::Float;
+                ok = ReadBigEndian(marker == 0xca ? 4 : 8, object.m_value);
+                break;
+
+            case 0xcc:
+            case 0xcd:
+            case 0xce:
+            case 0xcf:
+                object.m_type = Type::UInt;
+                ok = ReadBigEndian(1u << (marker - 0xcc), object.m_value);
+                break;
+
+            case 0xd0:
+            case 0xd1:
+            case 0xd2:
+            case 0xd3:
+            {
+                uint32_t numBytes = 1u << (marker - 0xd0);
+                uint64_t rawValue = 0;
+                ok = ReadBigEndian(numBytes, rawValue);
+
+                // Sign extend to 64 bits.
+                if (ok && numBytes < 8 && (rawValue >> (numBytes * 8 - 1)) != 0)
+                {
+                    rawValue |= ~0ull << (numBytes * 8);
+                }
+
+                object.m_type = (static_cast<int64_t>(rawValue) < 0 ? Type::Int : Type::UInt);
+                object.m_value = rawValue;
+                break;
+            }
+
+            case 0xd4:
+            case 0xd5:
+            case 0xd6:
+            case 0xd7:
+            case 0xd8:
+                object.m_type = Type::Extension;
+                length = (1u << (marker - 0xd4)) + 1;
+                break;
+
+            case 0xd9:
+            case 0xda:
+            case 0xdb:
+                object.m_type = Type::String;
+                ok = ReadBigEndian(1u << (marker - 0xd9), length);
+                break;
+
+            case 0xdc:
+            case 0xdd:
+                object.m_type = Type::Array;
+                ok = ReadBigEndian(marker == 0xdc ? 2 : 4, length);
+                object.m_length = static_cast<uint32_t>(length);
+                length = 0;
+                break;
+
+            case 0xde:
+            case 0xdf:
+                object.m_type = Type::Map;
+                ok = ReadBigEndian(marker == 0xde ? 2 : 4, length);
+                object.m_length = static_cast<uint32_t>(length);
+                length = 0;
+                break;
+
+            default:
+                ok = false;
+                break;
+        }
+    }
+
+    if (ok && (object.m_type == Type::String || object.m_type == Type::Binary || object.m_type == Type::Extension))
+    {
+        if (length > m_size - m_offset)
+        {
+            ok = false;
+        }
+        else
+        {
+            object.m_pPayload = m_pData + m_offset;
+            object.m_length = static_cast<uint32_t>(length);
+            m_offset += static_cast<size_t>(length);
+        }
+    }
+
+    // Every element takes at least one byte, so a count beyond the bytes left is malformed. This
+    // is checked here, before a caller sizes an allocation by the count of an untrusted header.
+    if (ok && (object.m_type == Type::Array || object.m_type == Type::Map))
+    {
+        uint64_t minSize = static_cast<uint64_t>(object.m_length) * (object.m_type == Type::Map ? 2 : 1);
+        ok = minSize <= m_size - m_offset;
+    }
+
+    if (!ok)
+    {
+        m_offset = start;
+        object.m_type = Type::Invalid;
+        return false;
+    }
+
+    return true;
+}
+
+MsgPackReader::Type MsgPackReader::PeekType() const
+{
+    MsgPackReader reader(*this);
+    Object object;
+    reader.Read(object);
+    return object.m_type;
+}
+
+bool MsgPackReader::ReadMap(uint32_t& count)
+{
+    size_t start = m_offset;
+    Object object;
+
+    if (!Read(object) || object.m_type != Type::Map)
+    {
+        m_offset = start;
+        return false;
+    }
+
+    count = object.m_length;
+    return true;
+}
+
+bool MsgPackReader::ReadArray(uint32_t& count)
+{
+    size_t start = m_offset;
+    Object object;
+
+    if (!Read(object) || object.m_type != Type::Array)
+    {
+        m_offset = start;
+        return false;
+    }
+
+    count = object.m_length;
+    return true;
+}
+
+bool MsgPackReader::ReadString(const char*& pString, uint32_t& length)
+{
+    size_t start = m_offset;
+    Object object;
+
+    if (!Read(object) || object.m_type != Type::String)
+    {
+        m_offset = start;
+        return false;
+    }
+
+    pString = reinterpret_cast<const char*>(object.m_pPayload);
+    length = object.m_length;
+    return true;
+}
+
+bool MsgPackReader::ReadUInt(uint64_t& value)
+{
+    size_t start = m_offset;
+    Object object;
+
+    if (!Read(object) || (object.m_type != Type::UInt && object.m_type != Type::Bool))
+    {
+        m_offset = start;
+        return false;
+    }
+
+    value = object.m_value;
+    return true;
+}
+
+bool MsgPackReader::Skip()
+{
+    // Number of objects still to skip; arrays and maps add their elements.
+    uint64_t pending = 1;
+
+    while (pending > 0)
+    {
+        Object object;
+
+        if (!Read(object))
+        {
+            return false;
+        }
+
+        --pending;
+
+        if (object.m_type == Type::Array)
+        {
+            pending += object.m_length;
+        }
+        else if (object.m_type == Type::Map)
+        {
+            pending += 2ull * object.m_length;
+        }
+    }
+
+    return true;
+}
+}
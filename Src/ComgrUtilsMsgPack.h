@@ -0,0 +1,105 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal forward-only MsgPack reader used to decode code object metadata notes.
+//============================================================================================
+#ifndef COMGR_UTILS_MSGPACK_H_
+#define COMGR_UTILS_MSGPACK_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AMDT
+{
+/// Forward-only reader over a MsgPack encoded buffer.
+/// The reader never allocates; strings are returned as pointers into the buffer.
+class MsgPackReader
+{
+public:
+    /// MsgPack object types.
+    enum class Type
+    {
+        Invalid = 0,    ///< Malformed or truncated data.
+        Nil,            ///< Nil.
+        Bool,           ///< Boolean.
+        UInt,           ///< Unsigned integer.
+        Int,            ///< Negative integer.
+        Float,          ///< Floating point number.
+        String,         ///< UTF-8 string.
+        Binary,         ///< Binary blob.
+        Array,          ///< Array.
+        Map,            ///< Map.
+        Extension       ///< Extension type.
+    };
+
+    /// Header of one decoded MsgPack object.
+    struct Object
+    {
+        Type            m_type;         ///< The object type.
+        uint64_t        m_value;        ///< Integer/bool value, or raw bits of a float.
+        uint32_t        m_length;       ///< Payload length of strings/binaries/extensions, element count of arrays and maps.
+        const uint8_t*  m_pPayload;     ///< Payload of strings/binaries/extensions.
+    };
+
+    /// Constructor.
+    /// \param pData the MsgPack bytes.
+    /// \param size the size of the MsgPack bytes.
+    MsgPackReader(const uint8_t* pData, size_t size) : m_pData(pData), m_size(size), m_offset(0) {}
+
+    /// Indicates whether all bytes were consumed.
+    /// \return true if the reader is at the end of the buffer.
+    bool AtEnd() const
+    {
+        return m_offset >= m_size;
+    }
+
+    /// Get the type of the next object without consuming it.
+    /// \return the type of the next object.
+    Type PeekType() const;
+
+    /// Read the next object header. Arrays and maps leave their elements to be read next.
+    /// \param object receives the object header.
+    /// \return true if successful, false if the data is malformed, including arrays and maps
+    /// with more elements than bytes left.
+    bool Read(Object& object);
+
+    /// Read a map header.
+    /// \param count receives the number of key/value pairs.
+    /// \return true if the next object is a map, false otherwise (nothing is consumed).
+    bool ReadMap(uint32_t& count);
+
+    /// Read an array header.
+    /// \param count receives the number of elements.
+    /// \return true if the next object is an array, false otherwise (nothing is consumed).
+    bool ReadArray(uint32_t& count);
+
+    /// Read a string.
+    /// \param pString receives a pointer to the string bytes (not null terminated).
+    /// \param length receives the string length.
+    /// \return true if the next object is a string, false otherwise (nothing is consumed).
+    bool ReadString(const char*& pString, uint32_t& length);
+
+    /// Read an unsigned integer. Booleans are read as 0 or 1.
+    /// \param value receives the value.
+    /// \return true if the next object is a non-negative integer or a boolean, false otherwise (nothing is consumed).
+    bool ReadUInt(uint64_t& value);
+
+    /// Skip the next object including all nested elements.
+    /// \return true if successful, false if the data is malformed.
+    bool Skip();
+
+private:
+    /// Read a big-endian unsigned integer.
+    /// \param numBytes the size of the integer (1, 2, 4 or 8).
+    /// \param value receives the value.
+    /// \return true if successful, false if the data is truncated.
+    bool ReadBigEndian(uint32_t numBytes, uint64_t& value);
+
+    const uint8_t*  m_pData;    ///< The MsgPack bytes.
+    size_t          m_size;     ///< The size of the MsgPack bytes.
+    size_t          m_offset;   ///< The offset of the next object.
+};
+}
+
+#endif
@@ -0,0 +1,881 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal pool of forked worker processes running comgr actions.
+//============================================================================================
+#include "ComgrUtilsProcessPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#ifndef _WIN32
+    #include <dirent.h>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+namespace AMDT
+{
+#ifndef _WIN32
+// Size of the shared memory names, including the null terminator; macOS allows 31 characters
+static const size_t s_SHARED_NAME_SIZE = 32;
+
+// Suffix of the shared memory holding the output of a request
+static const char* s_OUTPUT_NAME_SUFFIX = "r";
+
+#ifdef MSG_NOSIGNAL
+// A worker that died must fail the request, not raise SIGPIPE in the calling process
+static const int s_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int s_SEND_FLAGS = 0;
+#endif
+
+// Set in the spawner and worker processes after the fork
+static bool s_isWorkerProcess = false;
+
+// Time limit of a socket operation, Deadline::max() for none
+typedef std::chrono::steady_clock::time_point Deadline;
+
+// Commands of the spawner process
+enum SpawnerCommandType
+{
+    SPAWNER_COMMAND_START_WORKER = 0,   // Fork a worker and send back its pid and socket
+    SPAWNER_COMMAND_STOP_WORKER         // Wait for a worker to exit, killing it first if asked to
+};
+
+// Command sent to the spawner process, answered with a pid and for a started worker its socket
+struct SpawnerCommand
+{
+    uint32_t    m_command;  // SpawnerCommandType
+    int32_t     m_pid;      // The worker to stop
+    uint32_t    m_kill;     // Nonzero to kill the worker to stop
+};
+
+// Request sent to a worker, followed by the ISA name
+struct ProcessPoolRequest
+{
+    uint32_t    m_task;                             // ProcessPoolTask
+    int32_t     m_dataKind;                         // amd_comgr_data_kind_t of the input
+    int32_t     m_language;                         // amd_comgr_language_t of a compile
+    uint32_t    m_isaNameSize;                      // Size of the ISA name that follows
+    uint64_t    m_inputSize;                        // Size of the input in the shared memory
+    char        m_sharedName[s_SHARED_NAME_SIZE];   // Name of the shared memory holding the input
+};
+
+// Reply of a worker, followed by the error message
+struct ProcessPoolReply
+{
+    int32_t     m_status;       // amd_comgr_status_t of the task
+    uint32_t    m_errMsgSize;   // Size of the error message that follows
+    uint64_t    m_outputSize;   // Size of the output in the shared memory named after the input
+};
+
+// Wait until a socket is ready; fails if the deadline passes first
+static bool WaitForSocket(int socket, short events, const Deadline& deadline)
+{
+    while (true)
+    {
+        int timeout = -1;
+
+        if (deadline != Deadline::max())
+        {
+            Deadline now = std::chrono::steady_clock::now();
+
+            if (now >= deadline)
+            {
+                return false;
+            }
+
+            // Rounded up, so poll does not return before the deadline.
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now + std::chrono::milliseconds(1) - std::chrono::nanoseconds(1)).count();
+            timeout = static_cast<int>(std::min<decltype(remaining)>(remaining, INT_MAX));
+        }
+
+        struct pollfd pollSocket;
+        pollSocket.fd = socket;
+        pollSocket.events = events;
+        pollSocket.revents = 0;
+        int ready = poll(&pollSocket, 1, timeout);
+
+        if (ready < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // A closed or failed socket is reported as ready, the following send or recv then fails.
+        return ready > 0;
+    }
+}
+
+// Send a whole buffer over a socket
+static bool SendAll(int socket, const void* pData, size_t size, const Deadline& deadline)
+{
+    const char* pBytes = static_cast<const char*>(pData);
+
+    while (size > 0)
+    {
+        if (!WaitForSocket(socket, POLLOUT, deadline))
+        {
+            return false;
+        }
+
+        ssize_t sent = send(socket, pBytes, size, s_SEND_FLAGS);
+
+        if (sent < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (sent <= 0)
+        {
+            return false;
+        }
+
+        pBytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+
+    return true;
+}
+
+// Receive a whole buffer from a socket; fails if the other side closed the socket
+static bool RecvAll(int socket, void* pData, size_t size, const Deadline& deadline)
+{
+    char* pBytes = static_cast<char*>(pData);
+
+    while (size > 0)
+    {
+        if (!WaitForSocket(socket, POLLIN, deadline))
+        {
+            return false;
+        }
+
+        ssize_t received = recv(socket, pBytes, size, 0);
+
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (received <= 0)
+        {
+            return false;
+        }
+
+        pBytes += received;
+        size -= static_cast<size_t>(received);
+    }
+
+    return true;
+}
+
+// Create a connected socket pair that is not inherited across exec
+static bool CreateSocketPair(int sockets[2])
+{
+#ifdef SOCK_CLOEXEC
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0)
+    {
+        return false;
+    }
+#else
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+    {
+        return false;
+    }
+
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+    fcntl(sockets[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(sockets[0], SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+    return true;
+}
+
+// Close every descriptor inherited from the parent process except the standard streams and one socket.
+// Otherwise a spawner or worker keeps the sockets of other pools open, and their processes never see them closed.
+static void CloseInheritedDescriptors(int keep)
+{
+    std::vector<int> descriptors;
+    DIR* pDir = opendir("/proc/self/fd");
+
+    if (pDir == nullptr)
+    {
+        pDir = opendir("/dev/fd");
+    }
+
+    if (pDir != nullptr)
+    {
+        int dirDescriptor = dirfd(pDir);
+
+        for (struct dirent* pEntry = readdir(pDir); pEntry != nullptr; pEntry = readdir(pDir))
+        {
+            char* pEnd = nullptr;
+            long descriptor = strtol(pEntry->d_name, &pEnd, 10);
+
+            if (pEnd != pEntry->d_name && *pEnd == '\0' && descriptor != dirDescriptor)
+            {
+                descriptors.push_back(static_cast<int>(descriptor));
+            }
+        }
+
+        closedir(pDir);
+    }
+    else
+    {
+        long maxDescriptors = sysconf(_SC_OPEN_MAX);
+
+        for (long descriptor = 0; descriptor < (maxDescriptors > 0 ? maxDescriptors : 1024); ++descriptor)
+        {
+            descriptors.push_back(static_cast<int>(descriptor));
+        }
+    }
+
+    for (int descriptor : descriptors)
+    {
+        if (descriptor > STDERR_FILENO && descriptor != keep)
+        {
+            close(descriptor);
+        }
+    }
+}
+
+// Send a pid and optionally a file descriptor over a socket
+static bool SendPid(int socket, int32_t pid, int fd)
+{
+    struct iovec data;
+    data.iov_base = &pid;
+    data.iov_len = sizeof(pid);
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+
+    union
+    {
+        struct cmsghdr  m_header;
+        char            m_buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    if (fd >= 0)
+    {
+        memset(&control, 0, sizeof(control));
+        message.msg_control = control.m_buffer;
+        message.msg_controllen = sizeof(control.m_buffer);
+
+        struct cmsghdr* pHeader = CMSG_FIRSTHDR(&message);
+        pHeader->cmsg_level = SOL_SOCKET;
+        pHeader->cmsg_type = SCM_RIGHTS;
+        pHeader->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(pHeader), &fd, sizeof(int));
+    }
+
+    ssize_t sent;
+
+    do
+    {
+        sent = sendmsg(socket, &message, s_SEND_FLAGS);
+    } while (sent < 0 && errno == EINTR);
+
+    return sent == static_cast<ssize_t>(sizeof(pid));
+}
+
+// Receive a pid and the file descriptor sent with it, -1 if none
+static bool RecvPid(int socket, int32_t& pid, int& fd)
+{
+    fd = -1;
+
+    struct iovec data;
+    data.iov_base = &pid;
+    data.iov_len = sizeof(pid);
+
+    union
+    {
+        struct cmsghdr  m_header;
+        char            m_buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    message.msg_control = control.m_buffer;
+    message.msg_controllen = sizeof(control.m_buffer);
+
+    ssize_t received;
+
+    do
+    {
+        received = recvmsg(socket, &message, 0);
+    } while (received < 0 && errno == EINTR);
+
+    for (struct cmsghdr* pHeader = (received > 0 ? CMSG_FIRSTHDR(&message) : nullptr); pHeader != nullptr; pHeader = CMSG_NXTHDR(&message, pHeader))
+    {
+        if (pHeader->cmsg_level == SOL_SOCKET && pHeader->cmsg_type == SCM_RIGHTS)
+        {
+            memcpy(&fd, CMSG_DATA(pHeader), sizeof(int));
+        }
+    }
+
+    if (received != static_cast<ssize_t>(sizeof(pid)))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+// Create a shared memory object holding a copy of a buffer
+static bool CreateSharedBuffer(const std::string& name, const char* pData, size_t size)
+{
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    bool retCode = ftruncate(fd, static_cast<off_t>(size)) == 0;
+    void* pShared = (retCode ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED);
+    close(fd);
+
+    if (pShared == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    memcpy(pShared, pData, size);
+    munmap(pShared, size);
+    return true;
+}
+
+// Map a shared memory object read-only
+static const char* MapSharedBuffer(const std::string& name, size_t size)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+
+    void* pShared = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return (pShared != MAP_FAILED ? static_cast<const char*>(pShared) : nullptr);
+}
+
+// Get a shared memory name that is unique in the system
+static std::string MakeSharedName()
+{
+    static std::atomic<uint32_t> s_sharedCounter(0);
+
+    char name[s_SHARED_NAME_SIZE];
+    snprintf(name, sizeof(name), "/cu%lu.%u", static_cast<unsigned long>(getpid()), s_sharedCounter.fetch_add(1));
+    return name;
+}
+
+#endif
+
+void ProcessPool::RunTask(ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+                          amd_comgr_language_t languageInfo, const std::string& isaName, std::vector<char>& output)
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBufferView(pInput, inputSize, dataKind);
+
+    if (pCodeObj == nullptr)
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT, "ERROR: The worker process could not open the input");
+    }
+    else if (task == COMGR_UTILS_PROCESS_POOL_TASK_COMPILE)
+    {
+        pCodeObj->CompileSourceToExecutable(output, languageInfo, isaName);
+    }
+    else
+    {
+        pCodeObj->DisassembleCodeObject(output, isaName);
+    }
+}
+
+#ifdef _WIN32
+ProcessPool::ProcessPool(uint32_t numWorkers, uint32_t timeoutInSeconds) :
+    m_timeoutInSeconds(timeoutInSeconds), m_spawnerPid(-1), m_spawnerSocket(-1)
+{
+    (void)numWorkers;
+}
+
+ProcessPool::~ProcessPool()
+{
+}
+
+bool ProcessPool::IsWorkerProcess()
+{
+    return false;
+}
+
+bool ProcessPool::Run(ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+                      amd_comgr_language_t languageInfo, const std::string& isaName, std::vector<char>& output)
+{
+    (void)task;
+    (void)pInput;
+    (void)inputSize;
+    (void)dataKind;
+    (void)languageInfo;
+    (void)isaName;
+    (void)output;
+    CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Worker processes are not supported on this platform");
+    return false;
+}
+#else
+ProcessPool::ProcessPool(uint32_t numWorkers, uint32_t timeoutInSeconds) :
+    m_timeoutInSeconds(timeoutInSeconds), m_spawnerPid(-1), m_spawnerSocket(-1)
+{
+    if (numWorkers == 0)
+    {
+        numWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!StartSpawner())
+    {
+        return;
+    }
+
+    m_workers.resize(numWorkers);
+
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        m_workers[i].m_pid = -1;
+        m_workers[i].m_socket = -1;
+        m_workers[i].m_busy = false;
+    }
+
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        if (!StartWorker(i))
+        {
+            // Without a single worker the pool is not valid, see IsValid.
+            for (size_t j = 0; j < i; ++j)
+            {
+                StopWorker(j, false);
+            }
+
+            m_workers.clear();
+            StopSpawner();
+            break;
+        }
+    }
+}
+
+ProcessPool::~ProcessPool()
+{
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        StopWorker(i, false);
+    }
+
+    StopSpawner();
+}
+
+bool ProcessPool::IsWorkerProcess()
+{
+    return s_isWorkerProcess;
+}
+
+bool ProcessPool::StartSpawner()
+{
+    int sockets[2];
+
+    if (!CreateSocketPair(sockets))
+    {
+        return false;
+    }
+
+    pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        s_isWorkerProcess = true;
+        CloseInheritedDescriptors(sockets[1]);
+        SpawnerMain(sockets[1]);
+    }
+
+    close(sockets[1]);
+
+    if (pid < 0)
+    {
+        close(sockets[0]);
+        return false;
+    }
+
+    m_spawnerPid = static_cast<int>(pid);
+    m_spawnerSocket = sockets[0];
+    return true;
+}
+
+void ProcessPool::StopSpawner()
+{
+    // The spawner exits when its socket is closed.
+    if (m_spawnerSocket >= 0)
+    {
+        close(m_spawnerSocket);
+        m_spawnerSocket = -1;
+    }
+
+    if (m_spawnerPid > 0)
+    {
+        while (waitpid(static_cast<pid_t>(m_spawnerPid), nullptr, 0) < 0 && errno == EINTR)
+        {
+        }
+
+        m_spawnerPid = -1;
+    }
+}
+
+bool ProcessPool::StartWorker(size_t index)
+{
+    SpawnerCommand command;
+    command.m_command = SPAWNER_COMMAND_START_WORKER;
+    command.m_pid = -1;
+    command.m_kill = 0;
+
+    int32_t pid = -1;
+    int socket = -1;
+
+    if (m_spawnerSocket < 0 || !SendAll(m_spawnerSocket, &command, sizeof(command), Deadline::max()) || !RecvPid(m_spawnerSocket, pid, socket))
+    {
+        return false;
+    }
+
+    m_workers[index].m_pid = static_cast<int>(pid);
+    m_workers[index].m_socket = socket;
+
+    if (pid < 0 || socket < 0)
+    {
+        // A worker whose socket did not arrive has nothing to do but exit.
+        StopWorker(index, true);
+        return false;
+    }
+
+    return true;
+}
+
+void ProcessPool::StopWorker(size_t index, bool kill)
+{
+    Worker& worker = m_workers[index];
+
+    // A worker exits when its socket is closed.
+    if (worker.m_socket >= 0)
+    {
+        close(worker.m_socket);
+        worker.m_socket = -1;
+    }
+
+    // Only the spawner may wait for the worker, which also keeps its pid from being reused before the kill.
+    if (worker.m_pid > 0 && m_spawnerSocket >= 0)
+    {
+        SpawnerCommand command;
+        command.m_command = SPAWNER_COMMAND_STOP_WORKER;
+        command.m_pid = static_cast<int32_t>(worker.m_pid);
+        command.m_kill = (kill ? 1 : 0);
+
+        int32_t reply = -1;
+        int socket = -1;
+
+        if (SendAll(m_spawnerSocket, &command, sizeof(command), Deadline::max()))
+        {
+            RecvPid(m_spawnerSocket, reply, socket);
+        }
+    }
+
+    worker.m_pid = -1;
+}
+
+void ProcessPool::SpawnerMain(int socket)
+{
+    SpawnerCommand command;
+
+    while (RecvAll(socket, &command, sizeof(command), Deadline::max()))
+    {
+        int32_t pid = -1;
+        int workerSocket = -1;
+
+        if (command.m_command == SPAWNER_COMMAND_START_WORKER)
+        {
+            int sockets[2];
+
+            if (CreateSocketPair(sockets))
+            {
+                pid_t workerPid = fork();
+
+                if (workerPid == 0)
+                {
+                    // The worker only keeps its own end of its own socket, so it sees the pool closing it.
+                    CloseInheritedDescriptors(sockets[1]);
+                    WorkerMain(sockets[1]);
+                }
+
+                close(sockets[1]);
+
+                if (workerPid > 0)
+                {
+                    pid = static_cast<int32_t>(workerPid);
+                    workerSocket = sockets[0];
+                }
+                else
+                {
+                    close(sockets[0]);
+                }
+            }
+        }
+        else if (command.m_pid > 0)
+        {
+            if (command.m_kill != 0)
+            {
+                kill(static_cast<pid_t>(command.m_pid), SIGKILL);
+            }
+
+            while (waitpid(static_cast<pid_t>(command.m_pid), nullptr, 0) < 0 && errno == EINTR)
+            {
+            }
+
+            pid = command.m_pid;
+        }
+
+        bool sent = SendPid(socket, pid, workerSocket);
+
+        // The pool has its own copy of the worker socket now.
+        if (workerSocket >= 0)
+        {
+            close(workerSocket);
+        }
+
+        if (!sent)
+        {
+            break;
+        }
+    }
+
+    // Workers still running see their sockets closed by the pool and exit on their own.
+    _exit(0);
+}
+
+void ProcessPool::WorkerMain(int socket)
+{
+    ProcessPoolRequest request;
+    std::string isaName;
+    std::vector<char> output;
+
+    while (RecvAll(socket, &request, sizeof(request), Deadline::max()))
+    {
+        isaName.resize(request.m_isaNameSize);
+        request.m_sharedName[s_SHARED_NAME_SIZE - 1] = '\0';
+
+        if (!RecvAll(socket, &isaName[0], isaName.size(), Deadline::max()))
+        {
+            break;
+        }
+        CodeObj::GetLastError();
+        output.clear();
+
+        // comgr keeps its own copy of the input, the mapping is only needed while the task runs.
+        size_t inputSize = static_cast<size_t>(request.m_inputSize);
+        const char* pInput = (inputSize > 0 ? MapSharedBuffer(request.m_sharedName, inputSize) : nullptr);
+        RunTask(static_cast<ProcessPoolTask>(request.m_task), pInput, inputSize, static_cast<amd_comgr_data_kind_t>(request.m_dataKind),
+                static_cast<amd_comgr_language_t>(request.m_language), isaName, output);
+
+        if (pInput != nullptr)
+        {
+            munmap(const_cast<char*>(pInput), inputSize);
+        }
+
+        std::pair<amd_comgr_status_t, std::string> lastError = CodeObj::GetLastError();
+        std::string outputName = std::string(request.m_sharedName) + s_OUTPUT_NAME_SUFFIX;
+
+        if (lastError.first == AMD_COMGR_STATUS_SUCCESS && !output.empty() && !CreateSharedBuffer(outputName, output.data(), output.size()))
+        {
+            lastError = std::make_pair(AMD_COMGR_STATUS_ERROR, std::string("ERROR: The worker process could not share the output"));
+        }
+
+        ProcessPoolReply reply;
+        reply.m_status = static_cast<int32_t>(lastError.first);
+        reply.m_errMsgSize = static_cast<uint32_t>(lastError.second.size());
+        reply.m_outputSize = (lastError.first == AMD_COMGR_STATUS_SUCCESS ? output.size() : 0);
+
+        if (!SendAll(socket, &reply, sizeof(reply), Deadline::max()) || !SendAll(socket, lastError.second.data(), lastError.second.size(), Deadline::max()))
+        {
+            break;
+        }
+    }
+
+    // Exit without the static destructors of the parent process.
+    _exit(0);
+}
+
+bool ProcessPool::RunOnWorker(const Worker& worker, ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+                              amd_comgr_language_t languageInfo, const std::string& isaName, const std::string& inputName, std::vector<char>& output,
+                              bool& workerFailed) const
+{
+    ProcessPoolRequest request;
+    memset(&request, 0, sizeof(request));
+    request.m_task = static_cast<uint32_t>(task);
+    request.m_dataKind = static_cast<int32_t>(dataKind);
+    request.m_language = static_cast<int32_t>(languageInfo);
+    request.m_isaNameSize = static_cast<uint32_t>(isaName.size());
+    request.m_inputSize = inputSize;
+
+    std::string outputName = inputName + s_OUTPUT_NAME_SUFFIX;
+    strncpy(request.m_sharedName, inputName.c_str(), s_SHARED_NAME_SIZE - 1);
+
+    if (inputSize > 0 && !CreateSharedBuffer(inputName, pInput, inputSize))
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Could not share the input with the worker process");
+        return false;
+    }
+
+    // The whole exchange must finish by the deadline, a worker that hangs is then treated like one that died.
+    Deadline deadline = Deadline::max();
+
+    if (m_timeoutInSeconds > 0)
+    {
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(m_timeoutInSeconds);
+    }
+
+    ProcessPoolReply reply;
+    std::string errMsg;
+    workerFailed = !SendAll(worker.m_socket, &request, sizeof(request), deadline) || !SendAll(worker.m_socket, isaName.data(), isaName.size(), deadline) ||
+                   !RecvAll(worker.m_socket, &reply, sizeof(reply), deadline);
+
+    if (!workerFailed)
+    {
+        errMsg.resize(reply.m_errMsgSize);
+        workerFailed = !RecvAll(worker.m_socket, &errMsg[0], errMsg.size(), deadline);
+    }
+
+    shm_unlink(inputName.c_str());
+
+    if (workerFailed)
+    {
+        // The output is unlinked by Run once the worker is gone, a late worker could still create it before.
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: The comgr worker process did not answer in time");
+        }
+        else
+        {
+            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: The comgr worker process failed");
+        }
+
+        return false;
+    }
+
+    output.clear();
+
+    if (reply.m_status != AMD_COMGR_STATUS_SUCCESS)
+    {
+        CodeObj::SetError(static_cast<amd_comgr_status_t>(reply.m_status), errMsg);
+        return false;
+    }
+
+    bool retCode = true;
+
+    if (reply.m_outputSize > 0)
+    {
+        size_t outputSize = static_cast<size_t>(reply.m_outputSize);
+        const char* pOutput = MapSharedBuffer(outputName, outputSize);
+        retCode = pOutput != nullptr;
+
+        if (retCode)
+        {
+            output.assign(pOutput, pOutput + outputSize);
+            munmap(const_cast<char*>(pOutput), outputSize);
+        }
+        else
+        {
+            CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Could not read the output of the worker process");
+        }
+
+        shm_unlink(outputName.c_str());
+    }
+
+    return retCode;
+}
+
+bool ProcessPool::Run(ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+                      amd_comgr_language_t languageInfo, const std::string& isaName, std::vector<char>& output)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if (m_workers.empty())
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: The process pool has no workers");
+        return false;
+    }
+
+    auto freeWorker = m_workers.end();
+    m_workerFree.wait(lock, [&]()
+    {
+        freeWorker = std::find_if(m_workers.begin(), m_workers.end(), [](const Worker& worker) { return !worker.m_busy; });
+        return freeWorker != m_workers.end();
+    });
+
+    size_t index = static_cast<size_t>(freeWorker - m_workers.begin());
+
+    // A worker that could not be forked again after a failure is retried here.
+    if (m_workers[index].m_pid < 0 && !StartWorker(index))
+    {
+        CodeObj::SetError(AMD_COMGR_STATUS_ERROR, "ERROR: Could not start a comgr worker process");
+        return false;
+    }
+
+    m_workers[index].m_busy = true;
+    Worker worker = m_workers[index];
+    lock.unlock();
+
+    bool workerFailed = false;
+    std::string inputName = MakeSharedName();
+    bool retCode = RunOnWorker(worker, task, pInput, inputSize, dataKind, languageInfo, isaName, inputName, output, workerFailed);
+
+    lock.lock();
+
+    // A worker that crashed or missed the deadline is killed and replaced by the spawner. Its output, if
+    // it got as far as creating one, is unlinked only after it was reaped, so it cannot be created later.
+    if (workerFailed)
+    {
+        StopWorker(index, true);
+        shm_unlink((inputName + s_OUTPUT_NAME_SUFFIX).c_str());
+        StartWorker(index);
+    }
+
+    m_workers[index].m_busy = false;
+    lock.unlock();
+    m_workerFree.notify_one();
+    return retCode;
+}
+#endif
+}
@@ -0,0 +1,145 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal pool of forked worker processes running comgr actions.
+//============================================================================================
+#ifndef COMGR_UTILS_PROCESS_POOL_H_
+#define COMGR_UTILS_PROCESS_POOL_H_
+
+#include "ComgrUtils.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace AMDT
+{
+/// Work run by a ProcessPool worker.
+enum ProcessPoolTask
+{
+    COMGR_UTILS_PROCESS_POOL_TASK_DISASSEMBLE = 0,  ///< Disassemble a code object, see CodeObj::ExtractAssemblyData.
+    COMGR_UTILS_PROCESS_POOL_TASK_COMPILE           ///< Compile a source, see CodeObj::ConvertSourceToCodeObject.
+};
+
+/// Runs comgr actions in forked worker processes, one request per worker at a time.
+/// The input and the output of a request are exchanged through POSIX shared memory, the request
+/// itself over a socket pair. A worker that dies or does not answer in time fails its request and
+/// is replaced, so a crash or a hang inside comgr never takes the calling process down.
+/// The workers are forked by a spawner process, which is forked when the pool is created and stays
+/// single-threaded, so replacing a worker never forks the multithreaded calling process. The pool
+/// should be created before the process starts other threads.
+/// Not available on Windows, where the pool starts no workers.
+class ProcessPool
+{
+public:
+    /// Constructor, forks the spawner process and starts the workers.
+    /// \param numWorkers the number of workers, 0 to use one worker per hardware thread.
+    /// \param timeoutInSeconds the time a worker has to answer a request before it is killed, 0 for no limit.
+    ProcessPool(uint32_t numWorkers, uint32_t timeoutInSeconds);
+
+    /// Destructor, stops the workers.
+    ~ProcessPool();
+
+    /// Check that workers could be started.
+    /// \return true if the pool has workers, false otherwise.
+    bool IsValid() const
+    {
+        return !m_workers.empty();
+    }
+
+    /// Check if the calling process is a pool worker.
+    /// \return true in a worker process, false otherwise.
+    static bool IsWorkerProcess();
+
+    /// Run a task on a free worker, waiting for one if all are busy. Thread-safe.
+    /// Errors of the worker are set as the error of the calling thread.
+    /// \param task the task.
+    /// \param pInput the code object or the source.
+    /// \param inputSize the size of the input in bytes.
+    /// \param dataKind the comgr data kind of the input.
+    /// \param languageInfo the language of a compile.
+    /// \param isaName the ISA name.
+    /// \param output receives the disassembly or the executable.
+    /// \return true if successful, false otherwise.
+    bool Run(ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+             amd_comgr_language_t languageInfo, const std::string& isaName, std::vector<char>& output);
+
+private:
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    /// A worker process.
+    struct Worker
+    {
+        int     m_pid;      ///< The process id, -1 if the worker is not running.
+        int     m_socket;   ///< The socket connected to the worker, -1 if not running.
+        bool    m_busy;     ///< True while a request runs on the worker.
+    };
+
+    /// Fork the spawner process; called from the constructor.
+    /// \return true if the spawner runs, false otherwise.
+    bool StartSpawner();
+
+    /// Stop the spawner process and wait for it to exit; called from the destructor.
+    void StopSpawner();
+
+    /// Have the spawner fork a worker; called with m_mutex held.
+    /// \param index the index of the worker.
+    /// \return true if the worker runs, false otherwise.
+    bool StartWorker(size_t index);
+
+    /// Stop a worker and have the spawner wait for it to exit; called with m_mutex held or from the destructor.
+    /// \param index the index of the worker.
+    /// \param kill true to kill the worker, false to let it finish its request.
+    void StopWorker(size_t index, bool kill);
+
+    /// Send a request to a worker and receive its result.
+    /// \param worker the worker.
+    /// \param task the task.
+    /// \param pInput the input.
+    /// \param inputSize the size of the input in bytes.
+    /// \param dataKind the comgr data kind of the input.
+    /// \param languageInfo the language of a compile.
+    /// \param isaName the ISA name.
+    /// \param inputName the name of the shared memory holding the input; the output uses it with a suffix.
+    /// \param output receives the output.
+    /// \param workerFailed set to true if the worker did not answer in time; the caller must then
+    ///        stop the worker before it unlinks the output.
+    /// \return true if successful, false otherwise.
+    bool RunOnWorker(const Worker& worker, ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+                     amd_comgr_language_t languageInfo, const std::string& isaName, const std::string& inputName, std::vector<char>& output,
+                     bool& workerFailed) const;
+
+    /// Run a task in the calling process; used by the workers.
+    /// \param task the task.
+    /// \param pInput the input.
+    /// \param inputSize the size of the input in bytes.
+    /// \param dataKind the comgr data kind of the input.
+    /// \param languageInfo the language of a compile.
+    /// \param isaName the ISA name.
+    /// \param output receives the output.
+    static void RunTask(ProcessPoolTask task, const char* pInput, size_t inputSize, amd_comgr_data_kind_t dataKind,
+                        amd_comgr_language_t languageInfo, const std::string& isaName, std::vector<char>& output);
+
+    /// The request loop of a worker process; never returns.
+    /// \param socket the socket connected to the pool.
+    static void WorkerMain(int socket);
+
+    /// The command loop of the spawner process; never returns.
+    /// \param socket the socket connected to the pool.
+    static void SpawnerMain(int socket);
+
+    uint32_t                    m_timeoutInSeconds; ///< The time a worker has to answer a request, 0 for no limit.
+    int                         m_spawnerPid;       ///< The process id of the spawner, -1 if not running.
+    int                         m_spawnerSocket;    ///< The socket connected to the spawner, -1 if not running.
+    std::vector<Worker>         m_workers;          ///< The workers.
+    std::mutex                  m_mutex;            ///< Guards m_workers and the spawner socket.
+    std::condition_variable     m_workerFree;       ///< Signaled when a worker becomes free.
+};
+}
+
+#endif
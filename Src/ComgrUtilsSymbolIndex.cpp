@@ -0,0 +1,349 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Address-to-symbol and name-to-symbol indices over code object symbols.
+//============================================================================================
+#include "ComgrUtils.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+    #include <xmmintrin.h>
+    #define COMGR_UTILS_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+    #define COMGR_UTILS_PREFETCH(p) __builtin_prefetch(p)
+#endif
+
+namespace AMDT
+{
+const uint32_t SymbolIndex::s_INVALID_SYMBOL_INDEX;
+const uint32_t SymbolNameIndex::s_INVALID_SYMBOL_INDEX;
+
+// Number of searches interleaved by the batched lookup
+static const size_t s_BATCH_LANES = 8;
+
+// Initial number of name hash table slots, a power of 2
+static const size_t s_INITIAL_NAME_SLOTS = 64;
+
+// Minimum size of an interned name storage chunk
+static const size_t s_NAME_CHUNK_SIZE = 16 * 1024;
+
+// Address range of one function symbol
+struct SymbolRange
+{
+    uint64_t    m_start;        // First address of the symbol
+    uint64_t    m_end;          // One past the last address of the symbol
+    uint32_t    m_symbolIndex;  // Index into CodeObjSymbolInfo::m_pSymbols
+};
+
+// Fill the Eytzinger array from the sorted ranges with an in-order walk of the implicit tree
+static size_t FillEytzinger(const std::vector<SymbolRange>& ranges,
+                            size_t                          sortedPos,
+                            size_t                          eytzingerPos,
+                            std::vector<uint64_t>&          starts,
+                            std::vector<uint32_t>&          ranks)
+{
+    if (eytzingerPos < starts.size())
+    {
+        sortedPos = FillEytzinger(ranges, sortedPos, 2 * eytzingerPos, starts, ranks);
+        starts[eytzingerPos] = ranges[sortedPos].m_start;
+        ranks[eytzingerPos] = static_cast<uint32_t>(sortedPos);
+        sortedPos = FillEytzinger(ranges, sortedPos + 1, 2 * eytzingerPos + 1, starts, ranks);
+    }
+
+    return sortedPos;
+}
+
+// Undo the right turns taken after the last left turn, yielding the first start above the address
+static size_t LastLeftTurn(size_t eytzingerPos)
+{
+    while ((eytzingerPos & 1) != 0)
+    {
+        eytzingerPos >>= 1;
+    }
+
+    return eytzingerPos >> 1;
+}
+
+void SymbolIndex::Build(const CodeObjSymbolInfo& data)
+{
+    Clear();
+
+    std::vector<SymbolRange> ranges;
+    ranges.reserve(data.m_numSymbols);
+
+    for (uint32_t i = 0; i < data.m_numSymbols && data.m_pSymbols != nullptr; ++i)
+    {
+        const CodeObjSymbol& symbol = data.m_pSymbols[i];
+
+        if (symbol.m_type == COMGR_UTILS_SYMBOL_TYPE_FUNC && symbol.m_symbolFunction.m_symbolSize > 0)
+        {
+            SymbolRange range;
+            range.m_start = symbol.m_symbolFunction.m_symbolValue;
+            range.m_end = range.m_start + symbol.m_symbolFunction.m_symbolSize;
+            range.m_symbolIndex = i;
+
+            // Clamp ranges that wrap around the address space
+            if (range.m_end < range.m_start)
+            {
+                range.m_end = UINT64_MAX;
+            }
+
+            ranges.push_back(range);
+        }
+    }
+
+    // Sort by start address; among equal starts keep the largest range
+    std::sort(ranges.begin(), ranges.end(), [](const SymbolRange& lhs, const SymbolRange& rhs)
+    {
+        return (lhs.m_start != rhs.m_start) ? (lhs.m_start < rhs.m_start) : (lhs.m_end > rhs.m_end);
+    });
+
+    ranges.erase(std::unique(ranges.begin(), ranges.end(), [](const SymbolRange& lhs, const SymbolRange& rhs)
+    {
+        return lhs.m_start == rhs.m_start;
+    }), ranges.end());
+
+    m_ends.reserve(ranges.size());
+    m_symbolIndices.reserve(ranges.size());
+
+    for (const SymbolRange& range : ranges)
+    {
+        m_ends.push_back(range.m_end);
+        m_symbolIndices.push_back(range.m_symbolIndex);
+    }
+
+    m_eytzingerStarts.resize(ranges.size() + 1, 0);
+    m_eytzingerRanks.resize(ranges.size() + 1, 0);
+    FillEytzinger(ranges, 0, 1, m_eytzingerStarts, m_eytzingerRanks);
+}
+
+void SymbolIndex::Clear()
+{
+    m_eytzingerStarts.clear();
+    m_eytzingerRanks.clear();
+    m_ends.clear();
+    m_symbolIndices.clear();
+}
+
+uint32_t SymbolIndex::Resolve(size_t eytzingerPos, uint64_t address) const
+{
+    // eytzingerPos is the first start above the address; the candidate is the range before it
+    size_t sortedPos = (eytzingerPos == 0) ? m_symbolIndices.size() : m_eytzingerRanks[eytzingerPos];
+
+    if (sortedPos == 0 || address >= m_ends[sortedPos - 1])
+    {
+        return s_INVALID_SYMBOL_INDEX;
+    }
+
+    return m_symbolIndices[sortedPos - 1];
+}
+
+uint32_t SymbolIndex::FindByAddress(uint64_t address) const
+{
+    const size_t numRanges = m_symbolIndices.size();
+    const uint64_t* pStarts = m_eytzingerStarts.data();
+    size_t pos = 1;
+
+    while (pos <= numRanges)
+    {
+        // The 16th descendant of pos is 4 levels down; fetch it while this level is compared
+        COMGR_UTILS_PREFETCH(pStarts + std::min(16 * pos, numRanges));
+        pos = 2 * pos + (pStarts[pos] <= address ? 1 : 0);
+    }
+
+    return Resolve(LastLeftTurn(pos), address);
+}
+
+void SymbolIndex::FindByAddress(const uint64_t* pAddresses, size_t numAddresses, uint32_t* pSymbolIndices) const
+{
+    const size_t numRanges = m_symbolIndices.size();
+    const uint64_t* pStarts = m_eytzingerStarts.data();
+
+    for (size_t first = 0; first < numAddresses; first += s_BATCH_LANES)
+    {
+        const size_t numLanes = std::min(s_BATCH_LANES, numAddresses - first);
+        size_t pos[s_BATCH_LANES];
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            pos[lane] = 1;
+        }
+
+        // Step every lane one tree level at a time so the loads of different lanes are in flight together
+        bool active = numRanges > 0;
+
+        while (active)
+        {
+            active = false;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                if (pos[lane] <= numRanges)
+                {
+                    pos[lane] = 2 * pos[lane] + (pStarts[pos[lane]] <= pAddresses[first + lane] ? 1 : 0);
+                    COMGR_UTILS_PREFETCH(pStarts + std::min(pos[lane], numRanges));
+                    active = true;
+                }
+            }
+        }
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            pSymbolIndices[first + lane] = Resolve(LastLeftTurn(pos[lane]), pAddresses[first + lane]);
+        }
+    }
+}
+
+void SymbolIndex::FindByAddress(const std::vector<uint64_t>& addresses, std::vector<uint32_t>& symbolIndices) const
+{
+    symbolIndices.resize(addresses.size());
+
+    if (!addresses.empty())
+    {
+        FindByAddress(addresses.data(), addresses.size(), symbolIndices.data());
+    }
+}
+
+// 64-bit FNV-1a hash of a name
+static uint64_t HashName(const char* pName, size_t nameLen)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < nameLen; ++i)
+    {
+        hash ^= static_cast<uint8_t>(pName[i]);
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+void SymbolNameIndex::Build(const CodeObjSymbolInfo& data)
+{
+    Clear();
+
+    for (uint32_t i = 0; i < data.m_numSymbols && data.m_pSymbols != nullptr; ++i)
+    {
+        const CodeObjSymbol& symbol = data.m_pSymbols[i];
+
+        if (symbol.m_type == COMGR_UTILS_SYMBOL_TYPE_FUNC && symbol.m_symbolFunction.m_pName != nullptr)
+        {
+            Insert(symbol.m_symbolFunction.m_pName, static_cast<size_t>(symbol.m_symbolFunction.m_nameLen), i);
+        }
+    }
+}
+
+void SymbolNameIndex::Clear()
+{
+    m_slots.clear();
+    m_nameChunks.clear();
+    m_numNames = 0;
+    m_chunkUsed = 0;
+    m_chunkSize = 0;
+}
+
+const char* SymbolNameIndex::InternName(const char* pName, size_t nameLen)
+{
+    if (m_chunkSize - m_chunkUsed < nameLen + 1)
+    {
+        m_chunkSize = std::max(s_NAME_CHUNK_SIZE, nameLen + 1);
+        m_nameChunks.emplace_back(new char[m_chunkSize]);
+        m_chunkUsed = 0;
+    }
+
+    char* pInterned = m_nameChunks.back().get() + m_chunkUsed;
+    memcpy(pInterned, pName, nameLen);
+    pInterned[nameLen] = '\0';
+    m_chunkUsed += nameLen + 1;
+
+    return pInterned;
+}
+
+void SymbolNameIndex::Grow()
+{
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(m_slots);
+
+    Slot emptySlot = {};
+    m_slots.resize(oldSlots.empty() ? s_INITIAL_NAME_SLOTS : 2 * oldSlots.size(), emptySlot);
+    const size_t mask = m_slots.size() - 1;
+
+    for (const Slot& slot : oldSlots)
+    {
+        if (slot.m_pName != nullptr)
+        {
+            size_t pos = static_cast<size_t>(slot.m_hash) & mask;
+
+            while (m_slots[pos].m_pName != nullptr)
+            {
+                pos = (pos + 1) & mask;
+            }
+
+            m_slots[pos] = slot;
+        }
+    }
+}
+
+const char* SymbolNameIndex::Insert(const char* pName, size_t nameLen, uint32_t symbolIndex)
+{
+    // Keep the load factor at or below 1/2 so probe sequences stay short
+    if (2 * (m_numNames + 1) > m_slots.size())
+    {
+        Grow();
+    }
+
+    const uint64_t hash = HashName(pName, nameLen);
+    const size_t mask = m_slots.size() - 1;
+    size_t pos = static_cast<size_t>(hash) & mask;
+
+    while (m_slots[pos].m_pName != nullptr)
+    {
+        const Slot& slot = m_slots[pos];
+
+        if (slot.m_hash == hash && slot.m_nameLen == nameLen && memcmp(slot.m_pName, pName, nameLen) == 0)
+        {
+            return slot.m_pName;
+        }
+
+        pos = (pos + 1) & mask;
+    }
+
+    Slot& slot = m_slots[pos];
+    slot.m_hash = hash;
+    slot.m_pName = InternName(pName, nameLen);
+    slot.m_nameLen = nameLen;
+    slot.m_symbolIndex = symbolIndex;
+    ++m_numNames;
+
+    return slot.m_pName;
+}
+
+uint32_t SymbolNameIndex::Find(const char* pName, size_t nameLen) const
+{
+    if (m_numNames == 0)
+    {
+        return s_INVALID_SYMBOL_INDEX;
+    }
+
+    const uint64_t hash = HashName(pName, nameLen);
+    const size_t mask = m_slots.size() - 1;
+    size_t pos = static_cast<size_t>(hash) & mask;
+
+    while (m_slots[pos].m_pName != nullptr)
+    {
+        const Slot& slot = m_slots[pos];
+
+        if (slot.m_hash == hash && slot.m_nameLen == nameLen && memcmp(slot.m_pName, pName, nameLen) == 0)
+        {
+            return slot.m_symbolIndex;
+        }
+
+        pos = (pos + 1) & mask;
+    }
+
+    return s_INVALID_SYMBOL_INDEX;
+}
+}
@@ -0,0 +1,133 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal worker pool used by the ComgrUtils batch APIs.
+//============================================================================================
+#include "ComgrUtilsWorkerPool.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AMDT
+{
+// Range of item indices owned by one worker
+struct WorkerRange
+{
+    std::mutex  m_mutex;    // Guards the range
+    size_t      m_begin;    // First index not yet started
+    size_t      m_end;      // One past the last index of the range
+    WorkerRange(): m_begin(0), m_end(0) {}
+};
+
+// Take the next index from the front of a worker's own range
+static bool PopFront(WorkerRange& range, size_t& index)
+{
+    std::lock_guard<std::mutex> lock(range.m_mutex);
+
+    if (range.m_begin < range.m_end)
+    {
+        index = range.m_begin++;
+        return true;
+    }
+
+    return false;
+}
+
+// Move the upper half of another worker's remaining range into the worker's own range
+static bool Steal(WorkerRange* pRanges, uint32_t numRanges, uint32_t self, size_t& index)
+{
+    for (uint32_t offset = 1; offset < numRanges; ++offset)
+    {
+        WorkerRange& victim = pRanges[(self + offset) % numRanges];
+        size_t stolenBegin = 0;
+        size_t stolenEnd = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(victim.m_mutex);
+
+            if (victim.m_begin >= victim.m_end)
+            {
+                continue;
+            }
+
+            size_t remaining = victim.m_end - victim.m_begin;
+            stolenEnd = victim.m_end;
+            stolenBegin = stolenEnd - (remaining + 1) / 2;
+            victim.m_end = stolenBegin;
+        }
+
+        WorkerRange& own = pRanges[self];
+        std::lock_guard<std::mutex> lock(own.m_mutex);
+        own.m_begin = stolenBegin + 1;
+        own.m_end = stolenEnd;
+        index = stolenBegin;
+        return true;
+    }
+
+    return false;
+}
+
+WorkerPool::WorkerPool(uint32_t numWorkers) : m_numWorkers(numWorkers)
+{
+    if (m_numWorkers == 0)
+    {
+        m_numWorkers = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void WorkerPool::ParallelFor(size_t itemCount, const std::function<void(size_t)>& func) const
+{
+    uint32_t numThreads = static_cast<uint32_t>(std::min<size_t>(m_numWorkers, itemCount));
+
+    if (numThreads <= 1)
+    {
+        for (size_t i = 0; i < itemCount; ++i)
+        {
+            func(i);
+        }
+
+        return;
+    }
+
+    std::unique_ptr<WorkerRange[]> pRanges(new WorkerRange[numThreads]);
+    size_t itemsPerThread = itemCount / numThreads;
+    size_t extraItems = itemCount % numThreads;
+    size_t begin = 0;
+
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        pRanges[i].m_begin = begin;
+        begin += itemsPerThread + (i < extraItems ? 1 : 0);
+        pRanges[i].m_end = begin;
+    }
+
+    auto workerFunc = [&](uint32_t self)
+    {
+        size_t index = 0;
+
+        while (PopFront(pRanges[self], index) || Steal(pRanges.get(), numThreads, self, index))
+        {
+            func(index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+
+    for (uint32_t i = 1; i < numThreads; ++i)
+    {
+        threads.emplace_back(workerFunc, i);
+    }
+
+    workerFunc(0);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+}
@@ -0,0 +1,45 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Internal worker pool used by the ComgrUtils batch APIs.
+//============================================================================================
+#ifndef COMGR_UTILS_WORKER_POOL_H_
+#define COMGR_UTILS_WORKER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace AMDT
+{
+/// Runs index-based work on a set of worker threads.
+/// Each worker starts with a contiguous share of the indices and, once its share is done,
+/// steals the upper half of the remaining indices of another worker. This keeps all workers
+/// busy when the cost of the items varies widely.
+class WorkerPool
+{
+public:
+    /// Constructor.
+    /// \param numWorkers the number of workers, 0 to use one worker per hardware thread.
+    explicit WorkerPool(uint32_t numWorkers);
+
+    /// Get the number of workers.
+    /// \return the number of workers.
+    uint32_t GetNumWorkers() const
+    {
+        return m_numWorkers;
+    }
+
+    /// Call func once for every index in [0, itemCount) and wait for all calls to finish.
+    /// The calling thread acts as one of the workers. func must not throw.
+    /// \param itemCount the number of items.
+    /// \param func the function to call for each item index.
+    void ParallelFor(size_t itemCount, const std::function<void(size_t)>& func) const;
+
+private:
+    uint32_t m_numWorkers;   ///< The number of workers.
+};
+}
+
+#endif
@@ -0,0 +1,259 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the function listing, its stream, and the disassembly kept for ExtractAssemblyRaw.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "ComgrUtilsElf.h"
+#include "StubComgr.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// Address of the .text section of the test code objects
+static const uint64_t s_TEXT_ADDRESS = 0x1000;
+
+// Functions of the large code object, enough for every worker to get several groups
+static const uint32_t s_NUM_LARGE_FUNCTIONS = 200;
+
+// The small code object: three functions, a gap between two of them, a gap at the end of .text and
+// a second executable section without symbols.
+static std::vector<char> BuildSmallCodeObject()
+{
+    ElfBuilder elf;
+    uint16_t text = elf.AddText(s_TEXT_ADDRESS, {0x00010002, 0xFF000000, 0x12345678, 0xBF810000,    // kern_a
+                                                 0x0000ABCD,                                        // gap
+                                                 0xDEADDEAD, 0x00020003, 0xBF810000,                // kern_b
+                                                 0x00000005, 0xBF810000,                            // kern_c
+                                                 0x0000BEEF});                                      // gap
+    std::vector<char> cold(8, 0);
+    cold[0] = 0x01;
+    elf.AddSection(".text.cold", 1, ELF_SHF_EXECINSTR, 0x3000, cold);
+    elf.AddSymbols({{"kern_c", ELF_STT_FUNC, text, 0x1020, 8},
+                    {"data_x", 1, text, 0x1000, 8},
+                    {"kern_a", ELF_STT_FUNC, text, 0x1000, 0x10},
+                    {"kern_b", ELF_STT_FUNC, text, 0x1014, 0xC}});
+    return elf.Build();
+}
+
+// The large code object: many functions in reverse symbol order, with a gap after every fifth.
+static std::vector<char> BuildLargeCodeObject(uint64_t& textSize)
+{
+    std::vector<uint32_t> words;
+    std::vector<TestSymbol> symbols;
+
+    for (uint32_t i = 0; i < s_NUM_LARGE_FUNCTIONS; ++i)
+    {
+        uint64_t address = s_TEXT_ADDRESS + words.size() * 4;
+        words.insert(words.end(), {0x00010000 | i, 0xFF000000, i, 0xBF810000});
+        symbols.insert(symbols.begin(), TestSymbol{"function_" + std::to_string(i), ELF_STT_FUNC, 1, address, 16});
+
+        if (i % 5 == 4)
+        {
+            words.push_back(0xCAFE0000 | i);
+        }
+    }
+
+    ElfBuilder elf;
+    elf.AddText(s_TEXT_ADDRESS, words);
+    elf.AddSymbols(symbols);
+    textSize = words.size() * 4;
+    return elf.Build();
+}
+
+// Count the encoding words of the listing lines, the 32 bit words after the address of each line.
+static uint64_t CountListedWords(const std::string& listing)
+{
+    uint64_t numWords = 0;
+    size_t lineStart = 0;
+
+    while (lineStart < listing.size())
+    {
+        size_t lineEnd = listing.find('\n', lineStart);
+        std::string line = listing.substr(lineStart, lineEnd - lineStart);
+        size_t encoding = line.find(": ", line.find(" // "));
+
+        if (line.find(" // ") != std::string::npos && encoding != std::string::npos)
+        {
+            numWords += (line.size() - encoding) / 9;
+        }
+
+        lineStart = lineEnd + 1;
+    }
+
+    return numWords;
+}
+
+// The listing covers every byte of the executable sections, functions decoded and gaps as data.
+static void TestListingFormat()
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildSmallCodeObject());
+    std::vector<char> listing;
+    COMGR_UTILS_CHECK(pCodeObj->ExtractFunctionListing(listing, s_STUB_ISA, 1));
+
+    const char* pExpected =
+        "kern_a:\n"
+        "\tv_op_2 v1 // 000000001000: 00010002\n"
+        "\ts_mov_b32 s0, 0x12345678 // 000000001004: FF000000 12345678\n"
+        "\ts_endpgm // 00000000100C: BF810000\n"
+        "\n"
+        ".text+0x10:\n"
+        "\t.long 0x0000ABCD // 000000001010: 0000ABCD\n"
+        "\n"
+        "kern_b:\n"
+        "\t.long 0xDEADDEAD // 000000001014: DEADDEAD\n"
+        "\tv_op_3 v2 // 000000001018: 00020003\n"
+        "\ts_endpgm // 00000000101C: BF810000\n"
+        "\n"
+        "kern_c:\n"
+        "\tv_op_5 v0 // 000000001020: 00000005\n"
+        "\ts_endpgm // 000000001024: BF810000\n"
+        "\n"
+        ".text+0x28:\n"
+        "\t.long 0x0000BEEF // 000000001028: 0000BEEF\n"
+        "\n"
+        ".text.cold+0x0:\n"
+        "\t.long 0x00000001 // 000000003000: 00000001\n"
+        "\t.long 0x00000000 // 000000003004: 00000000\n"
+        "\n";
+    COMGR_UTILS_CHECK(std::string(listing.begin(), listing.end()) == pExpected);
+
+    // A single function has the same text as in the listing.
+    std::vector<char> function;
+    COMGR_UTILS_CHECK(pCodeObj->DisassembleFunction("kern_b", s_STUB_ISA, function));
+    COMGR_UTILS_CHECK(std::string(pExpected).find(std::string(function.begin(), function.end())) != std::string::npos);
+
+    // ExtractAssemblyData still returns the text of the comgr disassembly action.
+    std::vector<char> assembly;
+    COMGR_UTILS_CHECK(pCodeObj->ExtractAssemblyData(assembly, s_STUB_ISA));
+    COMGR_UTILS_CHECK(std::string(assembly.begin(), assembly.end()).find(" disassembly of ") != std::string::npos);
+}
+
+// The listing is the same for any number of workers and covers every word of .text once.
+static void TestParallelMatchesSerial()
+{
+    uint64_t textSize = 0;
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildLargeCodeObject(textSize));
+    std::vector<char> serial;
+    COMGR_UTILS_CHECK(pCodeObj->ExtractFunctionListing(serial, s_STUB_ISA, 1));
+    COMGR_UTILS_CHECK(CountListedWords(std::string(serial.begin(), serial.end())) == textSize / 4);
+
+    for (uint32_t numWorkers : {0u, 2u, 3u, 8u})
+    {
+        std::vector<char> parallel;
+        COMGR_UTILS_CHECK(pCodeObj->ExtractFunctionListing(parallel, s_STUB_ISA, numWorkers));
+        COMGR_UTILS_CHECK(parallel == serial);
+    }
+
+    std::string text(serial.begin(), serial.end());
+    COMGR_UTILS_CHECK(text.compare(0, 11, "function_0:") == 0);
+    COMGR_UTILS_CHECK(text.find(".text+0x50:\n\t.long 0xCAFE0004 // 000000001050: CAFE0004\n") != std::string::npos);
+}
+
+// Collected chunks of ExtractFunctionListingStream
+struct StreamedListing
+{
+    std::string m_text;         // The chunks joined in order
+    size_t      m_chunkSize;    // The chunk size the stream was asked for
+    size_t      m_numChunks;    // The number of chunks
+    size_t      m_stopAfter;    // The number of chunks after which the callback stops the stream
+    bool        m_chunksValid;  // False if a chunk was too long or did not end with a line
+};
+
+// ListingTextCallback collecting the chunks into a StreamedListing
+static bool CollectChunk(const char* pText, size_t size, void* pUserData)
+{
+    StreamedListing* pListing = static_cast<StreamedListing*>(pUserData);
+    std::string chunk(pText, size);
+
+    // Only a single line may exceed the chunk size.
+    bool singleLine = (chunk.find('\n') == size - 1);
+    pListing->m_chunksValid &= (size > 0 && chunk[size - 1] == '\n' && (size <= pListing->m_chunkSize || singleLine));
+    pListing->m_text.append(chunk);
+    return ++pListing->m_numChunks < pListing->m_stopAfter;
+}
+
+// The streamed chunks joined in order are the listing.
+static void TestListingStream()
+{
+    uint64_t textSize = 0;
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildLargeCodeObject(textSize));
+    std::vector<char> listing;
+    COMGR_UTILS_CHECK(pCodeObj->ExtractFunctionListing(listing, s_STUB_ISA, 1));
+
+    for (size_t chunkSize : {1, 64, 4096, 1 << 20})
+    {
+        StreamedListing streamed = {std::string(), chunkSize, 0, SIZE_MAX, true};
+        COMGR_UTILS_CHECK(pCodeObj->ExtractFunctionListingStream(s_STUB_ISA, chunkSize, CollectChunk, &streamed));
+        COMGR_UTILS_CHECK(streamed.m_chunksValid);
+        COMGR_UTILS_CHECK(streamed.m_text == std::string(listing.begin(), listing.end()));
+    }
+
+    // The gaps of the small code object are streamed too.
+    std::unique_ptr<CodeObj> pSmall = CodeObj::OpenBuffer(BuildSmallCodeObject());
+    COMGR_UTILS_CHECK(pSmall->ExtractFunctionListing(listing, s_STUB_ISA, 1));
+    StreamedListing streamed = {std::string(), 16, 0, SIZE_MAX, true};
+    COMGR_UTILS_CHECK(pSmall->ExtractFunctionListingStream(s_STUB_ISA, 16, CollectChunk, &streamed));
+    COMGR_UTILS_CHECK(streamed.m_text == std::string(listing.begin(), listing.end()));
+
+    // A callback returning false stops the stream.
+    StreamedListing stopped = {std::string(), 64, 0, 3, true};
+    COMGR_UTILS_CHECK(!pCodeObj->ExtractFunctionListingStream(s_STUB_ISA, 64, CollectChunk, &stopped));
+    COMGR_UTILS_CHECK(stopped.m_numChunks == 3);
+}
+
+// The disassembly kept for ExtractAssemblyRaw is released once it was copied.
+static void TestAssemblyRawCache()
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildSmallCodeObject());
+    size_t actionsBefore = GetStubDisassemblyActions();
+    uint32_t size = 0;
+
+    COMGR_UTILS_CHECK(pCodeObj->ExtractAssemblySizeInBytes(s_STUB_ISA, &size));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 1);
+
+    // A wrong size fails and keeps the disassembly for the next attempt.
+    std::vector<char> assembly(size);
+    COMGR_UTILS_CHECK(!pCodeObj->ExtractAssemblyRaw(s_STUB_ISA, size + 1, assembly.data()));
+    COMGR_UTILS_CHECK(pCodeObj->ExtractAssemblyRaw(s_STUB_ISA, size, assembly.data()));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 1);
+
+    // The copied disassembly is no longer kept, the next call disassembles again.
+    std::vector<char> again(size);
+    COMGR_UTILS_CHECK(pCodeObj->ExtractAssemblyRaw(s_STUB_ISA, size, again.data()));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 2);
+    COMGR_UTILS_CHECK(again == assembly);
+}
+
+// A disassembler that can not be created fails the listing, serial or parallel.
+static void TestListingFailure()
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildSmallCodeObject());
+    std::vector<char> listing;
+
+    COMGR_UTILS_CHECK(!pCodeObj->ExtractFunctionListing(listing, s_STUB_ISA_FAIL, 1));
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+    COMGR_UTILS_CHECK(!pCodeObj->ExtractFunctionListing(listing, s_STUB_ISA_FAIL, 4));
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+}
+
+int main()
+{
+    size_t liveHandles = GetStubLiveHandles();
+
+    COMGR_UTILS_RUN_TEST(TestListingFormat);
+    COMGR_UTILS_RUN_TEST(TestParallelMatchesSerial);
+    COMGR_UTILS_RUN_TEST(TestListingStream);
+    COMGR_UTILS_RUN_TEST(TestListingFailure);
+    COMGR_UTILS_RUN_TEST(TestAssemblyRawCache);
+
+    COMGR_UTILS_CHECK(GetStubLiveHandles() == liveHandles);
+    return GetFailureCount();
+}
@@ -0,0 +1,118 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the disassembly disk cache and the comgr library identity in its keys.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "StubComgr.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <string>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// The cache directory of the tests
+static std::string g_cacheDirectory;
+
+// Disassemble a small code object, through the disk cache when it is enabled.
+static bool Disassemble(std::vector<char>& assembly)
+{
+    ElfBuilder elf;
+    elf.AddText(0x1000, {0x00010002, 0xBF810000});
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(elf.Build());
+    return pCodeObj != nullptr && pCodeObj->ExtractAssemblyData(assembly, s_STUB_ISA);
+}
+
+// Delete a cache directory and its entries.
+static void RemoveDirectory(const std::string& directory)
+{
+    DIR* pDir = opendir(directory.c_str());
+
+    if (pDir != nullptr)
+    {
+        for (dirent* pEntry = readdir(pDir); pEntry != nullptr; pEntry = readdir(pDir))
+        {
+            unlink((directory + "/" + pEntry->d_name).c_str());
+        }
+
+        closedir(pDir);
+    }
+
+    rmdir(directory.c_str());
+}
+
+// A second request for the same code object is served from the cache.
+static void TestCacheHit()
+{
+    std::vector<char> first;
+    std::vector<char> second;
+
+    size_t actionsBefore = GetStubDisassemblyActions();
+    COMGR_UTILS_CHECK(Disassemble(first));
+    COMGR_UTILS_CHECK(Disassemble(second));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 1);
+    COMGR_UTILS_CHECK(first == second);
+
+    // Another cache is empty.
+    std::string otherDirectory = g_cacheDirectory + ".other";
+    CodeObj::SetDisassemblyDiskCache(otherDirectory, 0);
+    COMGR_UTILS_CHECK(Disassemble(second));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 2);
+    CodeObj::SetDisassemblyDiskCache(g_cacheDirectory, 0);
+    RemoveDirectory(otherDirectory);
+}
+
+// A rebuilt comgr binary misses the entries of the old one, even though it reports the same version.
+static void TestLibraryRebuilt()
+{
+    // The stub comgr is linked into the test executable, so that is the binary the keys name.
+    Dl_info info;
+    struct stat fileStat;
+    COMGR_UTILS_CHECK(dladdr(reinterpret_cast<void*>(&amd_comgr_get_version), &info) != 0);
+    COMGR_UTILS_CHECK(stat(info.dli_fname, &fileStat) == 0);
+
+    std::vector<char> assembly;
+    size_t actionsBefore = GetStubDisassemblyActions();
+    COMGR_UTILS_CHECK(Disassemble(assembly));
+
+    struct timeval times[2] = {{fileStat.st_atime, 0}, {fileStat.st_mtime - 60, 0}};
+    COMGR_UTILS_CHECK(utimes(info.dli_fname, times) == 0);
+    COMGR_UTILS_CHECK(Disassemble(assembly));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 1);
+
+    // Restore the modification time, the entries of the original binary are found again.
+    times[1].tv_sec = fileStat.st_mtime;
+    COMGR_UTILS_CHECK(utimes(info.dli_fname, times) == 0);
+    COMGR_UTILS_CHECK(Disassemble(assembly));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 1);
+}
+
+int main()
+{
+    char directoryTemplate[] = "/tmp/ComgrUtilsDiskCacheTest.XXXXXX";
+
+    if (mkdtemp(directoryTemplate) == nullptr)
+    {
+        return 1;
+    }
+
+    g_cacheDirectory = directoryTemplate;
+    CodeObj::SetDisassemblyDiskCache(g_cacheDirectory, 0);
+
+    COMGR_UTILS_RUN_TEST(TestCacheHit);
+    COMGR_UTILS_RUN_TEST(TestLibraryRebuilt);
+
+    CodeObj::SetDisassemblyDiskCache("", 0);
+    RemoveDirectory(g_cacheDirectory);
+    return GetFailureCount();
+}
@@ -0,0 +1,142 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the decoding of numbers from metadata strings.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "StubComgr.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// Value the outputs are preset to, to check they are left unchanged on failure
+static const uint64_t s_UNCHANGED = 0x5A5A5A5A;
+
+// Decode an unsigned number from a null terminated string.
+static MDNumberStatus ParseUnsigned(const char* pStr, uint64_t& value)
+{
+    value = s_UNCHANGED;
+    return ParseMDUnsigned(pStr, strlen(pStr), value);
+}
+
+// Decode a signed number from a null terminated string.
+static MDNumberStatus ParseSigned(const char* pStr, int64_t& value)
+{
+    value = static_cast<int64_t>(s_UNCHANGED);
+    return ParseMDSigned(pStr, strlen(pStr), value);
+}
+
+// Unsigned decoding accepts the whole uint64_t range and reports anything above it as overflow.
+static void TestParseUnsigned()
+{
+    uint64_t value = 0;
+
+    COMGR_UTILS_CHECK(ParseUnsigned("0", value) == MDNumberStatus::Success && value == 0);
+    COMGR_UTILS_CHECK(ParseUnsigned("18446744073709551615", value) == MDNumberStatus::Success && value == UINT64_MAX);
+    COMGR_UTILS_CHECK(ParseUnsigned("0xFFFFFFFFFFFFFFFF", value) == MDNumberStatus::Success && value == UINT64_MAX);
+    COMGR_UTILS_CHECK(ParseUnsigned("0x00000000000000001", value) == MDNumberStatus::Success && value == 1);
+    COMGR_UTILS_CHECK(ParseUnsigned("0xdeadBEEF", value) == MDNumberStatus::Success && value == 0xdeadbeef);
+    COMGR_UTILS_CHECK(ParseUnsigned("true", value) == MDNumberStatus::Success && value == 1);
+    COMGR_UTILS_CHECK(ParseUnsigned("false", value) == MDNumberStatus::Success && value == 0);
+
+    COMGR_UTILS_CHECK(ParseUnsigned("18446744073709551616", value) == MDNumberStatus::Overflow && value == s_UNCHANGED);
+    COMGR_UTILS_CHECK(ParseUnsigned("99999999999999999999", value) == MDNumberStatus::Overflow && value == s_UNCHANGED);
+    COMGR_UTILS_CHECK(ParseUnsigned("0x10000000000000000", value) == MDNumberStatus::Overflow && value == s_UNCHANGED);
+
+    const char* invalid[] = {"", "0x", "-1", "12a", " 1", "1 ", "0xg", "True", "1.5"};
+
+    for (const char* pStr : invalid)
+    {
+        COMGR_UTILS_CHECK(ParseUnsigned(pStr, value) == MDNumberStatus::Invalid && value == s_UNCHANGED);
+    }
+
+    // Only length characters are read.
+    COMGR_UTILS_CHECK(ParseMDUnsigned("1234", 2, value) == MDNumberStatus::Success && value == 12);
+}
+
+// Signed decoding accepts the whole int64_t range, including its minimum.
+static void TestParseSigned()
+{
+    int64_t value = 0;
+
+    COMGR_UTILS_CHECK(ParseSigned("9223372036854775807", value) == MDNumberStatus::Success && value == INT64_MAX);
+    COMGR_UTILS_CHECK(ParseSigned("-9223372036854775808", value) == MDNumberStatus::Success && value == INT64_MIN);
+    COMGR_UTILS_CHECK(ParseSigned("-0x10", value) == MDNumberStatus::Success && value == -16);
+    COMGR_UTILS_CHECK(ParseSigned("-0", value) == MDNumberStatus::Success && value == 0);
+    COMGR_UTILS_CHECK(ParseSigned("true", value) == MDNumberStatus::Success && value == 1);
+
+    const int64_t unchanged = static_cast<int64_t>(s_UNCHANGED);
+    COMGR_UTILS_CHECK(ParseSigned("9223372036854775808", value) == MDNumberStatus::Overflow && value == unchanged);
+    COMGR_UTILS_CHECK(ParseSigned("-9223372036854775809", value) == MDNumberStatus::Overflow && value == unchanged);
+    COMGR_UTILS_CHECK(ParseSigned("18446744073709551615", value) == MDNumberStatus::Overflow && value == unchanged);
+    COMGR_UTILS_CHECK(ParseSigned("-18446744073709551616", value) == MDNumberStatus::Overflow && value == unchanged);
+
+    const char* invalid[] = {"", "-", "--1", "+1", "- 1", "-true", "1-"};
+
+    for (const char* pStr : invalid)
+    {
+        COMGR_UTILS_CHECK(ParseSigned(pStr, value) == MDNumberStatus::Invalid && value == unchanged);
+    }
+}
+
+// MDNode::value reports numbers that do not fit the requested type as errors and reads them as 0.
+static void TestNodeValue()
+{
+    MsgPackWriter metadata;
+    metadata.Map(4);
+    metadata.String("small");
+    metadata.UInt(0xffffffff);
+    metadata.String("large");
+    metadata.UInt(0x100000000);
+    metadata.String("negative");
+    metadata.Int(-100);
+    metadata.String("text");
+    metadata.String("not a number");
+
+    ElfBuilder elf;
+    elf.AddMetadata(metadata);
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(elf.Build());
+    COMGR_UTILS_CHECK(pCodeObj != nullptr);
+
+    MDNode root = pCodeObj->GetMD();
+    COMGR_UTILS_CHECK(root.IsValid());
+    CodeObj::GetLastError();
+
+    COMGR_UTILS_CHECK(root["small"].value<uint32_t>() == 0xffffffff);
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first == AMD_COMGR_STATUS_SUCCESS);
+
+    COMGR_UTILS_CHECK(root["large"].value<uint32_t>() == 0);
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+    COMGR_UTILS_CHECK(root["large"].value<uint64_t>() == 0x100000000);
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first == AMD_COMGR_STATUS_SUCCESS);
+
+    int64_t signedValue = 0;
+    uint64_t unsignedValue = s_UNCHANGED;
+    COMGR_UTILS_CHECK(root["negative"].GetSigned(signedValue) == MDNumberStatus::Success && signedValue == -100);
+    COMGR_UTILS_CHECK(root["negative"].GetUnsigned(unsignedValue) == MDNumberStatus::Invalid && unsignedValue == s_UNCHANGED);
+
+    COMGR_UTILS_CHECK(root["text"].value<uint64_t>() == 0);
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+
+    // Nodes that are not strings are not numbers either.
+    COMGR_UTILS_CHECK(root.GetUnsigned(unsignedValue) == MDNumberStatus::Invalid);
+}
+
+int main()
+{
+    size_t liveHandles = GetStubLiveHandles();
+
+    COMGR_UTILS_RUN_TEST(TestParseUnsigned);
+    COMGR_UTILS_RUN_TEST(TestParseSigned);
+    COMGR_UTILS_RUN_TEST(TestNodeValue);
+
+    COMGR_UTILS_CHECK(GetStubLiveHandles() == liveHandles);
+    return GetFailureCount();
+}
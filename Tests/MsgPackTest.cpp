@@ -0,0 +1,114 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the bounds checks of the MsgPack reader.
+//============================================================================================
+#include "ComgrUtilsMsgPack.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// Skip every object of a buffer.
+// \return true if the whole buffer was skipped, false if the reader failed.
+static bool SkipAll(const std::vector<uint8_t>& bytes)
+{
+    MsgPackReader reader(bytes.data(), bytes.size());
+
+    while (!reader.AtEnd())
+    {
+        if (!reader.Skip())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Well formed objects are read with their values.
+static void TestRead()
+{
+    MsgPackWriter writer;
+    writer.Map(1);
+    writer.String("key");
+    writer.Array(3);
+    writer.UInt(0x123456789);
+    writer.Int(-5);
+    writer.Bool(true);
+
+    std::vector<uint8_t> bytes = writer.GetBytes();
+    MsgPackReader reader(bytes.data(), bytes.size());
+    uint32_t count = 0;
+    const char* pString = nullptr;
+    uint32_t length = 0;
+    uint64_t value = 0;
+    MsgPackReader::Object object;
+
+    COMGR_UTILS_CHECK(reader.ReadMap(count) && count == 1);
+    COMGR_UTILS_CHECK(reader.ReadString(pString, length) && length == 3);
+    COMGR_UTILS_CHECK(reader.ReadArray(count) && count == 3);
+    COMGR_UTILS_CHECK(reader.ReadUInt(value) && value == 0x123456789);
+    COMGR_UTILS_CHECK(!reader.ReadUInt(value));
+    COMGR_UTILS_CHECK(reader.Read(object) && object.m_type == MsgPackReader::Type::Int && static_cast<int64_t>(object.m_value) == -5);
+    COMGR_UTILS_CHECK(reader.ReadUInt(value) && value == 1);
+    COMGR_UTILS_CHECK(reader.AtEnd());
+    COMGR_UTILS_CHECK(!reader.Read(object));
+    COMGR_UTILS_CHECK(SkipAll(bytes));
+}
+
+// Every prefix of a buffer that cuts an object fails instead of reading past the end.
+static void TestTruncated()
+{
+    MsgPackWriter writer;
+    WritePalMetadata(writer);
+    std::vector<uint8_t> bytes = writer.GetBytes();
+
+    COMGR_UTILS_CHECK(SkipAll(bytes));
+
+    for (size_t size = 1; size < bytes.size(); ++size)
+    {
+        std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + size);
+        COMGR_UTILS_CHECK(!SkipAll(truncated));
+    }
+}
+
+// Lengths and element counts larger than the bytes left are rejected by the header read.
+static void TestOversizedCounts()
+{
+    // str32 of 4 GiB, bin8 of 200 bytes, array32 and map32 of 2^32 - 1 elements, with a few bytes after them
+    const std::vector<std::vector<uint8_t>> oversized =
+    {
+        {0xdb, 0xff, 0xff, 0xff, 0xff, 'a', 'b'},
+        {0xc4, 200, 0, 0},
+        {0xdd, 0xff, 0xff, 0xff, 0xff, 0x01, 0x02},
+        {0xdf, 0xff, 0xff, 0xff, 0xff, 0x01, 0x02},
+        {0xde, 0x00, 0x03, 0x01, 0x02, 0x03, 0x04},
+        {0xcf, 0x01, 0x02},
+    };
+
+    for (const std::vector<uint8_t>& bytes : oversized)
+    {
+        MsgPackReader reader(bytes.data(), bytes.size());
+        MsgPackReader::Object object;
+        COMGR_UTILS_CHECK(!reader.Read(object));
+        COMGR_UTILS_CHECK(!SkipAll(bytes));
+    }
+
+    // Reserved marker
+    std::vector<uint8_t> reserved = {0xc1};
+    COMGR_UTILS_CHECK(!SkipAll(reserved));
+}
+
+int main()
+{
+    COMGR_UTILS_RUN_TEST(TestRead);
+    COMGR_UTILS_RUN_TEST(TestTruncated);
+    COMGR_UTILS_RUN_TEST(TestOversizedCounts);
+    return GetFailureCount();
+}
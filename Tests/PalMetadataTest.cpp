@@ -0,0 +1,233 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the PAL metadata backends and layouts, and of the metadata snapshot.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "StubComgr.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// A code object with the PAL metadata sample.
+static std::vector<char> BuildCodeObject()
+{
+    MsgPackWriter metadata;
+    WritePalMetadata(metadata);
+
+    ElfBuilder elf;
+    elf.AddText(0x1000, {0xBF810000});
+    elf.AddMetadata(metadata);
+    return elf.Build();
+}
+
+// Extract the PAL pipeline data of a code object with a backend and a layout.
+static bool Extract(const std::vector<char>& codeObject, CodeObjParseBackend backend, PalPipelineDataLayout layout, PalPipelineData& data)
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(codeObject);
+    return pCodeObj != nullptr && pCodeObj->ExtractPalPipelineData(data, backend, layout);
+}
+
+// Check the decoded sample against the values WritePalMetadata wrote.
+static void CheckSample(const PalPipelineData& data)
+{
+    COMGR_UTILS_CHECK(data.m_version.m_major == 2 && data.m_version.m_minor == 6);
+    COMGR_UTILS_CHECK(data.m_numPipelines == 1);
+
+    if (data.m_numPipelines != 1)
+    {
+        return;
+    }
+
+    const Pipeline& pipeline = data.m_pPipelines[0];
+    COMGR_UTILS_CHECK(pipeline.m_pName != nullptr && std::string(pipeline.m_pName) == "MyPipeline_" + std::string(300, 'x'));
+    COMGR_UTILS_CHECK(pipeline.m_userDataLimit == 16 && pipeline.m_spillThreshold == 0xffff);
+    COMGR_UTILS_CHECK(pipeline.m_wavefrontSize == 64 && pipeline.m_api == 1);
+    COMGR_UTILS_CHECK(pipeline.m_numShaders == 2 && pipeline.m_numStages == 1 && pipeline.m_numRegisterWrites == 3);
+
+    if (pipeline.m_numStages == 1)
+    {
+        const HWStageInfo& stage = pipeline.m_pStageList[0];
+        COMGR_UTILS_CHECK(stage.m_stageType == CS);
+        COMGR_UTILS_CHECK(stage.m_numUsedSgprs == 20 && stage.m_numUsedVgprs == 48 && stage.m_usesUavs == 1);
+        COMGR_UTILS_CHECK(stage.m_localDataShareSize == 4096 && stage.m_maxPrimsPerPsWave == 3);
+        COMGR_UTILS_CHECK(stage.m_pEntryPointSymbolName != nullptr && strcmp(stage.m_pEntryPointSymbolName, "_amdgpu_cs_main") == 0);
+    }
+
+    if (pipeline.m_numRegisterWrites == 3)
+    {
+        COMGR_UTILS_CHECK(pipeline.m_pRegisterDataList[0].m_address == 0x2e12 && pipeline.m_pRegisterDataList[0].m_data == 0xdeadbeef);
+        COMGR_UTILS_CHECK(pipeline.m_pRegisterDataList[2].m_address == 11 && pipeline.m_pRegisterDataList[2].m_data == 0xffffffff);
+    }
+}
+
+// The native MsgPack decoder and the comgr metadata walk produce the same pipeline data.
+static void TestBackendParity()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    PalPipelineData native;
+    PalPipelineData comgr;
+    PalPipelineData automatic;
+
+    COMGR_UTILS_CHECK(Extract(codeObject, COMGR_UTILS_PARSE_BACKEND_NATIVE, COMGR_UTILS_PAL_LAYOUT_SEPARATE, native));
+    COMGR_UTILS_CHECK(Extract(codeObject, COMGR_UTILS_PARSE_BACKEND_COMGR, COMGR_UTILS_PAL_LAYOUT_SEPARATE, comgr));
+    COMGR_UTILS_CHECK(Extract(codeObject, COMGR_UTILS_PARSE_BACKEND_AUTO, COMGR_UTILS_PAL_LAYOUT_SEPARATE, automatic));
+
+    CheckSample(native);
+    COMGR_UTILS_CHECK(CodeObj::ComparePalPipelineData(native, comgr));
+    COMGR_UTILS_CHECK(CodeObj::ComparePalPipelineData(native, automatic));
+
+    CodeObj::ClearPalPipelineData(native);
+    CodeObj::ClearPalPipelineData(comgr);
+    CodeObj::ClearPalPipelineData(automatic);
+}
+
+// The arena layout holds the same data as the separate allocations, on both backends, and clearing
+// it releases the arena and resets the structure.
+static void TestArenaLayout()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    const CodeObjParseBackend backends[] = {COMGR_UTILS_PARSE_BACKEND_NATIVE, COMGR_UTILS_PARSE_BACKEND_COMGR};
+
+    for (CodeObjParseBackend backend : backends)
+    {
+        PalPipelineData separate;
+        PalPipelineData arena;
+
+        COMGR_UTILS_CHECK(Extract(codeObject, backend, COMGR_UTILS_PAL_LAYOUT_SEPARATE, separate));
+        COMGR_UTILS_CHECK(Extract(codeObject, backend, COMGR_UTILS_PAL_LAYOUT_ARENA, arena));
+        COMGR_UTILS_CHECK(separate.m_pArena == nullptr && arena.m_pArena != nullptr);
+        CheckSample(arena);
+        COMGR_UTILS_CHECK(CodeObj::ComparePalPipelineData(separate, arena));
+
+        CodeObj::ClearPalPipelineData(arena);
+        CodeObj::ClearPalPipelineData(separate);
+        COMGR_UTILS_CHECK(arena.m_pArena == nullptr && arena.m_pPipelines == nullptr && arena.m_numPipelines == 0);
+        COMGR_UTILS_CHECK(separate.m_pPipelines == nullptr && separate.m_numPipelines == 0 && separate.m_version.m_major == 0);
+    }
+}
+
+// Compare a snapshot node with the comgr node it was built from, recursively.
+static bool IsSameNode(const MDNode& node, const MetadataSnapshotNode& snapshotNode)
+{
+    if (!snapshotNode.IsValid() || node.GetKind() != snapshotNode.GetKind())
+    {
+        return false;
+    }
+
+    switch (node.GetKind())
+    {
+        case MDNode::Kind::String:
+            return node.value<std::string>() == snapshotNode.value<std::string>() &&
+                   node.value<uint64_t>() == snapshotNode.value<uint64_t>();
+
+        case MDNode::Kind::List:
+            if (node.size() != snapshotNode.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < node.size(); ++i)
+            {
+                if (!IsSameNode(node[i], snapshotNode[i]))
+                {
+                    return false;
+                }
+            }
+
+            return !snapshotNode[node.size()].IsValid();
+
+        case MDNode::Kind::Map:
+        {
+            std::vector<std::string> keys = node.GetKeys();
+
+            if (keys != snapshotNode.GetKeys())
+            {
+                return false;
+            }
+
+            for (const std::string& key : keys)
+            {
+                if (!snapshotNode.Find(key) || !IsSameNode(node[key], snapshotNode[key]) ||
+                    std::string(snapshotNode[key].GetKey()) != key)
+                {
+                    return false;
+                }
+            }
+
+            return !snapshotNode.Find("missing") && !snapshotNode["missing"].IsValid();
+        }
+
+        default:
+            return true;
+    }
+}
+
+// The snapshot holds the same tree as the comgr metadata nodes.
+static void TestSnapshot()
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildCodeObject());
+    COMGR_UTILS_CHECK(pCodeObj != nullptr);
+
+    const MetadataSnapshot* pSnapshot = pCodeObj->GetMDSnapshot();
+    COMGR_UTILS_CHECK(pSnapshot != nullptr && pSnapshot == pCodeObj->GetMDSnapshot());
+
+    if (pSnapshot != nullptr)
+    {
+        MDNode root = pCodeObj->GetMD();
+        COMGR_UTILS_CHECK(root.IsValid());
+        COMGR_UTILS_CHECK(IsSameNode(root, pSnapshot->GetRoot()));
+
+        MetadataSnapshotNode stage = pSnapshot->GetRoot()["amdpal.pipelines"][0][".hardware_stages"][".cs"];
+        COMGR_UTILS_CHECK(stage[".vgpr_count"].value<uint32_t>() == 48);
+        COMGR_UTILS_CHECK(std::string(stage[".entry_point"].GetString()) == "_amdgpu_cs_main");
+    }
+
+    // Reading the strings that are not numbers as numbers set an error.
+    CodeObj::GetLastError();
+}
+
+// A truncated metadata note fails the native decoder instead of reading past the note.
+static void TestTruncatedNote()
+{
+    MsgPackWriter metadata;
+    WritePalMetadata(metadata);
+    std::vector<uint8_t> bytes = metadata.GetBytes();
+    bool allFailed = true;
+
+    for (size_t size = 0; size < bytes.size(); size += 7)
+    {
+        MsgPackWriter truncated;
+        truncated.Raw(std::vector<uint8_t>(bytes.begin(), bytes.begin() + size));
+
+        ElfBuilder elf;
+        elf.AddMetadata(truncated);
+        PalPipelineData data;
+        allFailed &= !Extract(elf.Build(), COMGR_UTILS_PARSE_BACKEND_NATIVE, COMGR_UTILS_PAL_LAYOUT_SEPARATE, data);
+        CodeObj::ClearPalPipelineData(data);
+    }
+
+    COMGR_UTILS_CHECK(allFailed);
+    CodeObj::GetLastError();
+}
+
+int main()
+{
+    size_t liveHandles = GetStubLiveHandles();
+
+    COMGR_UTILS_RUN_TEST(TestBackendParity);
+    COMGR_UTILS_RUN_TEST(TestArenaLayout);
+    COMGR_UTILS_RUN_TEST(TestSnapshot);
+    COMGR_UTILS_RUN_TEST(TestTruncatedNote);
+
+    COMGR_UTILS_CHECK(GetStubLiveHandles() == liveHandles);
+    return GetFailureCount();
+}
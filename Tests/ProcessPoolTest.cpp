@@ -0,0 +1,155 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the worker process pool: requests, crashed and hung workers, and re-enabling.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "StubComgr.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// Time a hung worker is given before it is killed
+static const uint32_t s_TIMEOUT_IN_SECONDS = 1;
+
+// Time after which the test is aborted, so a hang fails it instead of blocking the run
+static const unsigned int s_WATCHDOG_IN_SECONDS = 120;
+
+// Build a small code object with a .text section.
+static std::vector<char> BuildCodeObject()
+{
+    ElfBuilder elf;
+    elf.AddText(0x1000, {0x00010002, 0xBF810000});
+    return elf.Build();
+}
+
+// Count the shared memory objects the pool of this process left behind.
+static size_t CountSharedMemoryObjects()
+{
+    std::string prefix = "cu" + std::to_string(getpid()) + ".";
+    size_t count = 0;
+    DIR* pDir = opendir("/dev/shm");
+
+    if (pDir == nullptr)
+    {
+        return 0;
+    }
+
+    for (dirent* pEntry = readdir(pDir); pEntry != nullptr; pEntry = readdir(pDir))
+    {
+        count += (strncmp(pEntry->d_name, prefix.c_str(), prefix.size()) == 0 ? 1 : 0);
+    }
+
+    closedir(pDir);
+    return count;
+}
+
+// Disassemble the code object with an ISA name, the stub reacts to the failure ISA names.
+static bool Disassemble(const std::vector<char>& codeObject, const char* pIsaName, std::vector<char>& assembly)
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(codeObject);
+    return pCodeObj != nullptr && pCodeObj->ExtractAssemblyData(assembly, pIsaName);
+}
+
+// Requests run in the workers, not in the calling process.
+static void TestRun()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    size_t actionsBefore = GetStubDisassemblyActions();
+
+    COMGR_UTILS_CHECK(CodeObj::EnableProcessPool(2, s_TIMEOUT_IN_SECONDS));
+
+    std::vector<char> assembly;
+    COMGR_UTILS_CHECK(Disassemble(codeObject, s_STUB_ISA, assembly));
+    std::string expected = "disassembly of " + std::to_string(codeObject.size()) + " bytes";
+    COMGR_UTILS_CHECK(std::string(assembly.begin(), assembly.end()).find(expected) != std::string::npos);
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore);
+
+    std::string source = "kernel void k() {}";
+    std::unique_ptr<CodeObj> pSource = CodeObj::OpenBuffer(std::vector<char>(source.begin(), source.end()), AMD_COMGR_DATA_KIND_SOURCE);
+    std::vector<char> executable;
+    COMGR_UTILS_CHECK(pSource != nullptr && pSource->ConvertSourceToCodeObject(executable, AMD_COMGR_LANGUAGE_OPENCL_2_0, s_STUB_ISA));
+    COMGR_UTILS_CHECK(std::string(executable.begin(), executable.end()) == source + "ocml:" + s_STUB_ISA);
+
+    std::vector<char> failed;
+    COMGR_UTILS_CHECK(!Disassemble(codeObject, s_STUB_ISA_FAIL, failed));
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+
+    CodeObj::DisableProcessPool();
+}
+
+// A crashed worker fails its request and is replaced.
+static void TestWorkerCrash()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    COMGR_UTILS_CHECK(CodeObj::EnableProcessPool(1, s_TIMEOUT_IN_SECONDS));
+
+    std::vector<char> assembly;
+    COMGR_UTILS_CHECK(!Disassemble(codeObject, s_STUB_ISA_CRASH, assembly));
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+    COMGR_UTILS_CHECK(Disassemble(codeObject, s_STUB_ISA, assembly));
+
+    CodeObj::DisableProcessPool();
+    COMGR_UTILS_CHECK(CountSharedMemoryObjects() == 0);
+}
+
+// A hung worker is killed at the deadline, replaced, and leaves no shared memory behind.
+static void TestTimeout()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    COMGR_UTILS_CHECK(CodeObj::EnableProcessPool(1, s_TIMEOUT_IN_SECONDS));
+
+    std::vector<char> assembly;
+    COMGR_UTILS_CHECK(!Disassemble(codeObject, s_STUB_ISA_HANG, assembly));
+    COMGR_UTILS_CHECK(CodeObj::GetLastError().first != AMD_COMGR_STATUS_SUCCESS);
+    COMGR_UTILS_CHECK(CountSharedMemoryObjects() == 0);
+    COMGR_UTILS_CHECK(Disassemble(codeObject, s_STUB_ISA, assembly));
+
+    CodeObj::DisableProcessPool();
+}
+
+// Enabling the pool again replaces the running pool.
+static void TestReEnable()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    std::vector<char> assembly;
+
+    COMGR_UTILS_CHECK(CodeObj::EnableProcessPool(2, 0));
+    COMGR_UTILS_CHECK(CodeObj::EnableProcessPool(2, 0));
+    COMGR_UTILS_CHECK(Disassemble(codeObject, s_STUB_ISA, assembly));
+    COMGR_UTILS_CHECK(CodeObj::EnableProcessPool(1, s_TIMEOUT_IN_SECONDS));
+    COMGR_UTILS_CHECK(Disassemble(codeObject, s_STUB_ISA, assembly));
+
+    CodeObj::DisableProcessPool();
+
+    // Without a pool the action runs in the calling process.
+    size_t actionsBefore = GetStubDisassemblyActions();
+    COMGR_UTILS_CHECK(Disassemble(codeObject, s_STUB_ISA, assembly));
+    COMGR_UTILS_CHECK(GetStubDisassemblyActions() == actionsBefore + 1);
+}
+
+int main()
+{
+    alarm(s_WATCHDOG_IN_SECONDS);
+
+    size_t liveHandles = GetStubLiveHandles();
+
+    COMGR_UTILS_RUN_TEST(TestRun);
+    COMGR_UTILS_RUN_TEST(TestWorkerCrash);
+    COMGR_UTILS_RUN_TEST(TestTimeout);
+    COMGR_UTILS_RUN_TEST(TestReEnable);
+
+    CodeObj::ReleaseCompileDataSets();
+    COMGR_UTILS_CHECK(GetStubLiveHandles() == liveHandles);
+    COMGR_UTILS_CHECK(CountSharedMemoryObjects() == 0);
+    return GetFailureCount();
+}
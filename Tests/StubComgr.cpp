@@ -0,0 +1,1192 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  In-process stand-in for the comgr library, so the tests run without a GPU toolchain.
+///
+/// Data, data sets and metadata behave like comgr's: data is reference counted, metadata is
+/// decoded from the AMDGPU MsgPack note with every scalar as a string, and symbols are read
+/// from the ELF symbol table. The actions are fakes with deterministic output. The ISA names
+/// in StubComgr.h make an action crash, hang or fail, for the process pool tests.
+//============================================================================================
+#include "StubComgr.h"
+
+#include "amd_comgr.h"
+#include "ComgrUtilsElf.h"
+#include "ComgrUtilsMsgPack.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace AMDT;
+
+namespace
+{
+// A comgr data object
+struct StubData
+{
+    amd_comgr_data_kind_t   m_kind;         // The data kind
+    std::string             m_name;         // The data name
+    std::vector<char>       m_bytes;        // The contents
+    uint32_t                m_refCount;     // The number of references
+};
+
+// A comgr action info
+struct StubActionInfo
+{
+    std::string             m_isaName;      // The ISA name
+    std::string             m_options;      // The options
+    std::string             m_path;         // The working directory
+    amd_comgr_language_t    m_language;     // The language
+    bool                    m_logging;      // True to log
+};
+
+// A node of a decoded metadata tree
+struct StubMetadataNode
+{
+    amd_comgr_metadata_kind_t                   m_kind;     // The node kind
+    std::string                                 m_string;   // The value of a string node
+    std::vector<std::pair<uint32_t, uint32_t>>  m_map;      // The key and value node indices of a map node
+    std::vector<uint32_t>                       m_list;     // The element node indices of a list node
+};
+
+// A metadata handle, a node of a shared tree
+struct StubMetadata
+{
+    std::shared_ptr<const std::vector<StubMetadataNode>>    m_pTree;    // The decoded tree
+    uint32_t                                                m_index;    // The index of the node
+};
+
+// A comgr disassembly info
+struct StubDisassemblyInfo
+{
+    uint64_t (*m_pReadMemory)(uint64_t, char*, uint64_t, void*);   // Reads instruction bytes
+    void (*m_pPrintInstruction)(const char*, void*);                // Receives the instruction text
+};
+
+// The live stub objects by handle
+struct StubState
+{
+    std::mutex                                              m_mutex;            // Guards the maps
+    uint64_t                                                m_nextHandle = 1;   // The next handle
+    std::unordered_map<uint64_t, StubData>                  m_data;             // The data objects
+    std::unordered_map<uint64_t, std::vector<uint64_t>>     m_dataSets;         // The data sets, each holding a reference to its data
+    std::unordered_map<uint64_t, StubActionInfo>            m_actionInfos;      // The action infos
+    std::unordered_map<uint64_t, StubMetadata>              m_metadata;         // The metadata nodes
+    std::unordered_map<uint64_t, StubDisassemblyInfo>       m_disassemblyInfos; // The disassembly infos
+};
+
+// Never deleted, so handles released from static destructors stay valid
+StubState& GetState()
+{
+    static StubState* s_pState = new StubState();
+    return *s_pState;
+}
+
+std::atomic<size_t> g_disassemblyActions(0);
+
+// Symbol handles encode the data handle and the index of the symbol table entry
+const uint32_t s_SYMBOL_INDEX_BITS = 24;
+
+// NT_AMDGPU_METADATA, the type of the MsgPack metadata note
+const uint32_t s_METADATA_NOTE_TYPE = 32;
+
+// Copy a string to a comgr size/buffer pair; the size includes the terminator.
+amd_comgr_status_t GetString(const std::string& value, size_t* pSize, char* pString)
+{
+    if (pSize == nullptr)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (pString != nullptr)
+    {
+        if (*pSize < value.size() + 1)
+        {
+            return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+        }
+
+        memcpy(pString, value.c_str(), value.size() + 1);
+    }
+
+    *pSize = value.size() + 1;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+// Add a reference to data; called with the state mutex held.
+bool AddDataReference(StubState& state, uint64_t handle)
+{
+    auto data = state.m_data.find(handle);
+
+    if (data == state.m_data.end())
+    {
+        return false;
+    }
+
+    ++data->second.m_refCount;
+    return true;
+}
+
+// Drop a reference to data; called with the state mutex held.
+void ReleaseDataReference(StubState& state, uint64_t handle)
+{
+    auto data = state.m_data.find(handle);
+
+    if (data != state.m_data.end() && --data->second.m_refCount == 0)
+    {
+        state.m_data.erase(data);
+    }
+}
+
+// Create data holding one reference; called with the state mutex held.
+uint64_t CreateData(StubState& state, amd_comgr_data_kind_t kind, std::vector<char>&& bytes)
+{
+    uint64_t handle = state.m_nextHandle++;
+    StubData& data = state.m_data[handle];
+    data.m_kind = kind;
+    data.m_bytes = std::move(bytes);
+    data.m_refCount = 1;
+    return handle;
+}
+
+// Create a metadata handle; called with the state mutex held.
+amd_comgr_metadata_node_t CreateMetadata(StubState& state, const std::shared_ptr<const std::vector<StubMetadataNode>>& pTree, uint32_t index)
+{
+    amd_comgr_metadata_node_t node;
+    node.handle = state.m_nextHandle++;
+    StubMetadata& metadata = state.m_metadata[node.handle];
+    metadata.m_pTree = pTree;
+    metadata.m_index = index;
+    return node;
+}
+
+// Decode one MsgPack object and its elements into the tree.
+bool DecodeMetadata(MsgPackReader& reader, std::vector<StubMetadataNode>& tree, uint32_t& index)
+{
+    MsgPackReader::Object object;
+
+    if (!reader.Read(object))
+    {
+        return false;
+    }
+
+    index = static_cast<uint32_t>(tree.size());
+    tree.emplace_back();
+    tree[index].m_kind = AMD_COMGR_METADATA_KIND_STRING;
+
+    switch (object.m_type)
+    {
+        case MsgPackReader::Type::Map:
+            tree[index].m_kind = AMD_COMGR_METADATA_KIND_MAP;
+
+            for (uint32_t i = 0; i < object.m_length; ++i)
+            {
+                uint32_t key;
+                uint32_t value;
+
+                if (!DecodeMetadata(reader, tree, key) || !DecodeMetadata(reader, tree, value))
+                {
+                    return false;
+                }
+
+                tree[index].m_map.emplace_back(key, value);
+            }
+
+            break;
+
+        case MsgPackReader::Type::Array:
+            tree[index].m_kind = AMD_COMGR_METADATA_KIND_LIST;
+
+            for (uint32_t i = 0; i < object.m_length; ++i)
+            {
+                uint32_t element;
+
+                if (!DecodeMetadata(reader, tree, element))
+                {
+                    return false;
+                }
+
+                tree[index].m_list.push_back(element);
+            }
+
+            break;
+
+        case MsgPackReader::Type::String:
+            tree[index].m_string.assign(reinterpret_cast<const char*>(object.m_pPayload), object.m_length);
+            break;
+
+        case MsgPackReader::Type::UInt:
+            tree[index].m_string = std::to_string(object.m_value);
+            break;
+
+        case MsgPackReader::Type::Int:
+            tree[index].m_string = std::to_string(static_cast<int64_t>(object.m_value));
+            break;
+
+        case MsgPackReader::Type::Bool:
+            tree[index].m_string = (object.m_value != 0 ? "true" : "false");
+            break;
+
+        default:
+            tree[index].m_kind = AMD_COMGR_METADATA_KIND_NULL;
+            break;
+    }
+
+    return true;
+}
+
+// Find the symbol table of an ELF file.
+bool FindSymbolTable(const ElfReader& elf, Elf64SectionHeader& symbolTable, Elf64SectionHeader& stringTable)
+{
+    for (uint32_t i = 0; i < elf.GetNumSections(); ++i)
+    {
+        if (elf.GetSection(i, symbolTable) && symbolTable.m_type == ELF_SHT_SYMTAB)
+        {
+            return symbolTable.m_entsize == sizeof(Elf64Symbol) && elf.GetSection(symbolTable.m_link, stringTable);
+        }
+    }
+
+    return false;
+}
+
+// Read one symbol of the data a symbol handle refers to.
+bool ReadSymbol(amd_comgr_symbol_t handle, Elf64Symbol& symbol, std::string& name)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto data = state.m_data.find(handle.handle >> s_SYMBOL_INDEX_BITS);
+    ElfReader elf;
+    Elf64SectionHeader symbolTable;
+    Elf64SectionHeader stringTable;
+
+    if (data == state.m_data.end() || !elf.Init(data->second.m_bytes.data(), data->second.m_bytes.size()) ||
+        !FindSymbolTable(elf, symbolTable, stringTable))
+    {
+        return false;
+    }
+
+    uint64_t index = handle.handle & ((1ull << s_SYMBOL_INDEX_BITS) - 1);
+    const char* pSymbols = elf.GetSectionData(symbolTable);
+
+    if (pSymbols == nullptr || index >= symbolTable.m_size / sizeof(Elf64Symbol))
+    {
+        return false;
+    }
+
+    memcpy(&symbol, pSymbols + index * sizeof(Elf64Symbol), sizeof(Elf64Symbol));
+    const char* pName = elf.GetString(stringTable, symbol.m_name, nullptr);
+
+    if (pName == nullptr)
+    {
+        return false;
+    }
+
+    name = pName;
+    return true;
+}
+
+// Get the handles of the symbols of data, without the null entry.
+bool GetSymbolHandles(amd_comgr_data_t data, std::vector<amd_comgr_symbol_t>& symbols, std::vector<std::string>* pNames)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+    ElfReader elf;
+
+    if (stubData == state.m_data.end() || !elf.Init(stubData->second.m_bytes.data(), stubData->second.m_bytes.size()))
+    {
+        return false;
+    }
+
+    Elf64SectionHeader symbolTable;
+    Elf64SectionHeader stringTable;
+
+    if (!FindSymbolTable(elf, symbolTable, stringTable))
+    {
+        return true;
+    }
+
+    const char* pSymbols = elf.GetSectionData(symbolTable);
+    uint64_t numSymbols = symbolTable.m_size / sizeof(Elf64Symbol);
+
+    for (uint64_t i = 1; pSymbols != nullptr && i < numSymbols; ++i)
+    {
+        amd_comgr_symbol_t symbol;
+        symbol.handle = (data.handle << s_SYMBOL_INDEX_BITS) | i;
+        symbols.push_back(symbol);
+
+        if (pNames != nullptr)
+        {
+            Elf64Symbol entry;
+            memcpy(&entry, pSymbols + i * sizeof(Elf64Symbol), sizeof(Elf64Symbol));
+            const char* pName = elf.GetString(stringTable, entry.m_name, nullptr);
+            pNames->push_back(pName != nullptr ? pName : "");
+        }
+    }
+
+    return true;
+}
+
+// Decode one instruction of the toy ISA: an 0xFF top byte starts a 64-bit move, 0xBF810000 ends
+// the program, 0xDEADDEAD does not decode and any other word is a 32-bit vector operation.
+bool DecodeInstruction(const unsigned char* pBytes, uint64_t numBytes, char* pText, size_t textSize, uint64_t& size)
+{
+    if (numBytes < 4)
+    {
+        return false;
+    }
+
+    uint32_t word = pBytes[0] | (pBytes[1] << 8) | (pBytes[2] << 16) | (static_cast<uint32_t>(pBytes[3]) << 24);
+
+    if (word == 0xDEADDEAD)
+    {
+        return false;
+    }
+
+    if ((word >> 24) == 0xFF && numBytes >= 8)
+    {
+        uint32_t literal = pBytes[4] | (pBytes[5] << 8) | (pBytes[6] << 16) | (static_cast<uint32_t>(pBytes[7]) << 24);
+        snprintf(pText, textSize, "s_mov_b32 s0, 0x%x", literal);
+        size = 8;
+    }
+    else if (word == 0xBF810000)
+    {
+        snprintf(pText, textSize, "s_endpgm");
+        size = 4;
+    }
+    else
+    {
+        snprintf(pText, textSize, "v_op_%x v%u", word & 0xFFFF, (word >> 16) & 0xFF);
+        size = 4;
+    }
+
+    return true;
+}
+
+// Act on the ISA names that make an action crash, hang or fail.
+amd_comgr_status_t CheckIsaName(const std::string& isaName)
+{
+    if (isaName == ComgrUtilsTest::s_STUB_ISA_CRASH)
+    {
+        abort();
+    }
+
+    if (isaName == ComgrUtilsTest::s_STUB_ISA_HANG)
+    {
+        for (;;)
+        {
+            pause();
+        }
+    }
+
+    return isaName == ComgrUtilsTest::s_STUB_ISA_FAIL ? AMD_COMGR_STATUS_ERROR : AMD_COMGR_STATUS_SUCCESS;
+}
+}
+
+namespace ComgrUtilsTest
+{
+size_t GetStubLiveHandles()
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    return state.m_data.size() + state.m_dataSets.size() + state.m_actionInfos.size() + state.m_disassemblyInfos.size();
+}
+
+size_t GetStubLiveMetadataNodes()
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    return state.m_metadata.size();
+}
+
+size_t GetStubDisassemblyActions()
+{
+    return g_disassemblyActions;
+}
+}
+
+extern "C" {
+
+amd_comgr_status_t amd_comgr_status_string(amd_comgr_status_t status, const char** status_string)
+{
+    switch (status)
+    {
+        case AMD_COMGR_STATUS_SUCCESS:
+            *status_string = "SUCCESS";
+            break;
+
+        case AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT:
+            *status_string = "ERROR_INVALID_ARGUMENT";
+            break;
+
+        case AMD_COMGR_STATUS_ERROR_OUT_OF_RESOURCES:
+            *status_string = "ERROR_OUT_OF_RESOURCES";
+            break;
+
+        default:
+            *status_string = "ERROR";
+            break;
+    }
+
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+void amd_comgr_get_version(size_t* major, size_t* minor)
+{
+    *major = 2;
+    *minor = 0;
+}
+
+amd_comgr_status_t amd_comgr_get_isa_count(size_t* count)
+{
+    *count = 1;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_isa_name(size_t index, const char** isa_name)
+{
+    if (index != 0)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    *isa_name = ComgrUtilsTest::s_STUB_ISA;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_isa_metadata(const char*, amd_comgr_metadata_node_t*)
+{
+    return AMD_COMGR_STATUS_ERROR;
+}
+
+amd_comgr_status_t amd_comgr_create_data(amd_comgr_data_kind_t kind, amd_comgr_data_t* data)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    data->handle = CreateData(state, kind, std::vector<char>());
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_release_data(amd_comgr_data_t data)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+
+    if (state.m_data.count(data.handle) == 0)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    ReleaseDataReference(state, data.handle);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_data_kind(amd_comgr_data_t data, amd_comgr_data_kind_t* kind)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+
+    if (stubData == state.m_data.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    *kind = stubData->second.m_kind;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_set_data(amd_comgr_data_t data, size_t size, const char* bytes)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+
+    if (stubData == state.m_data.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    stubData->second.m_bytes.assign(bytes, bytes + size);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_set_data_name(amd_comgr_data_t data, const char* name)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+
+    if (stubData == state.m_data.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    stubData->second.m_name = name;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_data(amd_comgr_data_t data, size_t* size, char* bytes)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+
+    if (stubData == state.m_data.end() || size == nullptr)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    const std::vector<char>& contents = stubData->second.m_bytes;
+
+    if (bytes != nullptr)
+    {
+        if (*size < contents.size())
+        {
+            return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+        }
+
+        memcpy(bytes, contents.data(), contents.size());
+    }
+
+    *size = contents.size();
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_data_name(amd_comgr_data_t data, size_t* size, char* name)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+
+    if (stubData == state.m_data.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    return GetString(stubData->second.m_name, size, name);
+}
+
+amd_comgr_status_t amd_comgr_get_data_isa_name(amd_comgr_data_t, size_t* size, char* isa_name)
+{
+    return GetString(ComgrUtilsTest::s_STUB_ISA, size, isa_name);
+}
+
+amd_comgr_status_t amd_comgr_get_data_metadata(amd_comgr_data_t data, amd_comgr_metadata_node_t* metadata)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto stubData = state.m_data.find(data.handle);
+    ElfReader elf;
+    const uint8_t* pDesc = nullptr;
+    size_t descSize = 0;
+
+    if (stubData == state.m_data.end() || !elf.Init(stubData->second.m_bytes.data(), stubData->second.m_bytes.size()) ||
+        !elf.FindNote("AMDGPU", s_METADATA_NOTE_TYPE, pDesc, descSize))
+    {
+        return AMD_COMGR_STATUS_ERROR;
+    }
+
+    std::shared_ptr<std::vector<StubMetadataNode>> pTree = std::make_shared<std::vector<StubMetadataNode>>();
+    MsgPackReader reader(pDesc, descSize);
+    uint32_t root;
+
+    if (!DecodeMetadata(reader, *pTree, root))
+    {
+        return AMD_COMGR_STATUS_ERROR;
+    }
+
+    *metadata = CreateMetadata(state, pTree, root);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_destroy_metadata(amd_comgr_metadata_node_t metadata)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    return state.m_metadata.erase(metadata.handle) != 0 ? AMD_COMGR_STATUS_SUCCESS : AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+}
+
+amd_comgr_status_t amd_comgr_create_data_set(amd_comgr_data_set_t* data_set)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    data_set->handle = state.m_nextHandle++;
+    state.m_dataSets[data_set->handle];
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_destroy_data_set(amd_comgr_data_set_t data_set)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto dataSet = state.m_dataSets.find(data_set.handle);
+
+    if (dataSet == state.m_dataSets.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (uint64_t data : dataSet->second)
+    {
+        ReleaseDataReference(state, data);
+    }
+
+    state.m_dataSets.erase(dataSet);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_data_set_add(amd_comgr_data_set_t data_set, amd_comgr_data_t data)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto dataSet = state.m_dataSets.find(data_set.handle);
+
+    if (dataSet == state.m_dataSets.end() || !AddDataReference(state, data.handle))
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    dataSet->second.push_back(data.handle);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_data_set_remove(amd_comgr_data_set_t data_set, amd_comgr_data_kind_t data_kind)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto dataSet = state.m_dataSets.find(data_set.handle);
+
+    if (dataSet == state.m_dataSets.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::vector<uint64_t> kept;
+
+    for (uint64_t data : dataSet->second)
+    {
+        if (state.m_data[data].m_kind == data_kind)
+        {
+            ReleaseDataReference(state, data);
+        }
+        else
+        {
+            kept.push_back(data);
+        }
+    }
+
+    dataSet->second.swap(kept);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_data_count(amd_comgr_data_set_t data_set, amd_comgr_data_kind_t data_kind, size_t* count)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto dataSet = state.m_dataSets.find(data_set.handle);
+
+    if (dataSet == state.m_dataSets.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    *count = 0;
+
+    for (uint64_t data : dataSet->second)
+    {
+        *count += (state.m_data[data].m_kind == data_kind ? 1 : 0);
+    }
+
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_data_get_data(amd_comgr_data_set_t data_set, amd_comgr_data_kind_t data_kind, size_t index, amd_comgr_data_t* data)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto dataSet = state.m_dataSets.find(data_set.handle);
+
+    if (dataSet == state.m_dataSets.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (uint64_t handle : dataSet->second)
+    {
+        if (state.m_data[handle].m_kind == data_kind && index-- == 0)
+        {
+            AddDataReference(state, handle);
+            data->handle = handle;
+            return AMD_COMGR_STATUS_SUCCESS;
+        }
+    }
+
+    return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+}
+
+amd_comgr_status_t amd_comgr_create_action_info(amd_comgr_action_info_t* action_info)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    action_info->handle = state.m_nextHandle++;
+    StubActionInfo& info = state.m_actionInfos[action_info->handle];
+    info.m_language = AMD_COMGR_LANGUAGE_NONE;
+    info.m_logging = false;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_destroy_action_info(amd_comgr_action_info_t action_info)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    return state.m_actionInfos.erase(action_info.handle) != 0 ? AMD_COMGR_STATUS_SUCCESS : AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+}
+
+// The action info accessors share the lookup; the getters and setters only differ in the field.
+#define COMGR_UTILS_STUB_ACTION_INFO(action_info)                               \
+    StubState& state = GetState();                                              \
+    std::lock_guard<std::mutex> lock(state.m_mutex);                            \
+    auto infoEntry = state.m_actionInfos.find((action_info).handle);           \
+    if (infoEntry == state.m_actionInfos.end())                                 \
+    {                                                                           \
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;                         \
+    }                                                                           \
+    StubActionInfo& info = infoEntry->second
+
+amd_comgr_status_t amd_comgr_action_info_set_isa_name(amd_comgr_action_info_t action_info, const char* isa_name)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    info.m_isaName = isa_name;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_info_get_isa_name(amd_comgr_action_info_t action_info, size_t* size, char* isa_name)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    return GetString(info.m_isaName, size, isa_name);
+}
+
+amd_comgr_status_t amd_comgr_action_info_set_language(amd_comgr_action_info_t action_info, amd_comgr_language_t language)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    info.m_language = language;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_info_get_language(amd_comgr_action_info_t action_info, amd_comgr_language_t* language)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    *language = info.m_language;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_info_set_options(amd_comgr_action_info_t action_info, const char* options)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    info.m_options = options;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_info_get_options(amd_comgr_action_info_t action_info, size_t* size, char* options)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    return GetString(info.m_options, size, options);
+}
+
+amd_comgr_status_t amd_comgr_action_info_set_working_directory_path(amd_comgr_action_info_t action_info, const char* path)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    info.m_path = path;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_info_get_working_directory_path(amd_comgr_action_info_t action_info, size_t* size, char* path)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    return GetString(info.m_path, size, path);
+}
+
+amd_comgr_status_t amd_comgr_action_info_set_logging(amd_comgr_action_info_t action_info, bool logging)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    info.m_logging = logging;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_action_info_get_logging(amd_comgr_action_info_t action_info, bool* logging)
+{
+    COMGR_UTILS_STUB_ACTION_INFO(action_info);
+    *logging = info.m_logging;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+#undef COMGR_UTILS_STUB_ACTION_INFO
+
+amd_comgr_status_t amd_comgr_do_action(amd_comgr_action_kind_t kind, amd_comgr_action_info_t info, amd_comgr_data_set_t input, amd_comgr_data_set_t result)
+{
+    std::string isaName;
+
+    {
+        StubState& state = GetState();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        auto actionInfo = state.m_actionInfos.find(info.handle);
+
+        if (actionInfo == state.m_actionInfos.end() || state.m_dataSets.count(input.handle) == 0 || state.m_dataSets.count(result.handle) == 0)
+        {
+            return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+        }
+
+        isaName = actionInfo->second.m_isaName;
+    }
+
+    // The crash and hang run outside the lock, so a hung worker thread blocks nothing else.
+    amd_comgr_status_t status = CheckIsaName(isaName);
+
+    if (status != AMD_COMGR_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    std::vector<uint64_t> inputData = state.m_dataSets[input.handle];
+    std::vector<uint64_t>& resultData = state.m_dataSets[result.handle];
+
+    // The output of a transforming action concatenates the inputs of its source kind.
+    amd_comgr_data_kind_t fromKind = AMD_COMGR_DATA_KIND_UNDEF;
+    amd_comgr_data_kind_t toKind = AMD_COMGR_DATA_KIND_UNDEF;
+    std::vector<char> output;
+
+    switch (kind)
+    {
+        case AMD_COMGR_ACTION_ADD_PRECOMPILED_HEADERS:
+        case AMD_COMGR_ACTION_ADD_DEVICE_LIBRARIES:
+        {
+            // The input is passed through and the headers or libraries are added.
+            for (uint64_t data : inputData)
+            {
+                AddDataReference(state, data);
+                resultData.push_back(data);
+            }
+
+            bool headers = (kind == AMD_COMGR_ACTION_ADD_PRECOMPILED_HEADERS);
+            std::string contents = std::string(headers ? "pch:" : "ocml:") + isaName;
+            resultData.push_back(CreateData(state, headers ? AMD_COMGR_DATA_KIND_PRECOMPILED_HEADER : AMD_COMGR_DATA_KIND_BC,
+                                            std::vector<char>(contents.begin(), contents.end())));
+            return AMD_COMGR_STATUS_SUCCESS;
+        }
+
+        case AMD_COMGR_ACTION_COMPILE_SOURCE_TO_BC:
+            fromKind = AMD_COMGR_DATA_KIND_SOURCE;
+            toKind = AMD_COMGR_DATA_KIND_BC;
+            break;
+
+        case AMD_COMGR_ACTION_LINK_BC_TO_BC:
+            fromKind = AMD_COMGR_DATA_KIND_BC;
+            toKind = AMD_COMGR_DATA_KIND_BC;
+            break;
+
+        case AMD_COMGR_ACTION_CODEGEN_BC_TO_RELOCATABLE:
+            fromKind = AMD_COMGR_DATA_KIND_BC;
+            toKind = AMD_COMGR_DATA_KIND_RELOCATABLE;
+            break;
+
+        case AMD_COMGR_ACTION_LINK_RELOCATABLE_TO_EXECUTABLE:
+            fromKind = AMD_COMGR_DATA_KIND_RELOCATABLE;
+            toKind = AMD_COMGR_DATA_KIND_EXECUTABLE;
+            break;
+
+        case AMD_COMGR_ACTION_DISASSEMBLE_RELOCATABLE_TO_SOURCE:
+        case AMD_COMGR_ACTION_DISASSEMBLE_EXECUTABLE_TO_SOURCE:
+        {
+            size_t inputSize = 0;
+
+            for (uint64_t data : inputData)
+            {
+                inputSize += state.m_data[data].m_bytes.size();
+            }
+
+            char text[128];
+            int length = snprintf(text, sizeof(text), "\t.text\n; %s disassembly of %zu bytes\n", isaName.c_str(), inputSize);
+            resultData.push_back(CreateData(state, AMD_COMGR_DATA_KIND_SOURCE, std::vector<char>(text, text + length)));
+            ++g_disassemblyActions;
+            return AMD_COMGR_STATUS_SUCCESS;
+        }
+
+        default:
+            return AMD_COMGR_STATUS_ERROR;
+    }
+
+    for (uint64_t data : inputData)
+    {
+        const StubData& stubData = state.m_data[data];
+
+        if (stubData.m_kind == fromKind)
+        {
+            output.insert(output.end(), stubData.m_bytes.begin(), stubData.m_bytes.end());
+        }
+    }
+
+    resultData.push_back(CreateData(state, toKind, std::move(output)));
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_get_metadata_kind(amd_comgr_metadata_node_t metadata, amd_comgr_metadata_kind_t* kind)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    auto node = state.m_metadata.find(metadata.handle);
+
+    if (node == state.m_metadata.end())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    *kind = (*node->second.m_pTree)[node->second.m_index].m_kind;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+// The metadata accessors share the lookup of the node and the check of its kind.
+#define COMGR_UTILS_STUB_METADATA_NODE(metadata, kind)                                          \
+    StubState& state = GetState();                                                              \
+    std::unique_lock<std::mutex> lock(state.m_mutex);                                           \
+    auto nodeEntry = state.m_metadata.find((metadata).handle);                                  \
+    if (nodeEntry == state.m_metadata.end() ||                                                  \
+        (*nodeEntry->second.m_pTree)[nodeEntry->second.m_index].m_kind != (kind))               \
+    {                                                                                           \
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;                                         \
+    }                                                                                           \
+    std::shared_ptr<const std::vector<StubMetadataNode>> pTree = nodeEntry->second.m_pTree;     \
+    const StubMetadataNode& node = (*pTree)[nodeEntry->second.m_index]
+
+amd_comgr_status_t amd_comgr_get_metadata_string(amd_comgr_metadata_node_t metadata, size_t* size, char* string)
+{
+    COMGR_UTILS_STUB_METADATA_NODE(metadata, AMD_COMGR_METADATA_KIND_STRING);
+    return GetString(node.m_string, size, string);
+}
+
+amd_comgr_status_t amd_comgr_get_metadata_map_size(amd_comgr_metadata_node_t metadata, size_t* size)
+{
+    COMGR_UTILS_STUB_METADATA_NODE(metadata, AMD_COMGR_METADATA_KIND_MAP);
+    *size = node.m_map.size();
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_iterate_map_metadata(amd_comgr_metadata_node_t metadata,
+                                                  amd_comgr_status_t (*callback)(amd_comgr_metadata_node_t, amd_comgr_metadata_node_t, void*),
+                                                  void* user_data)
+{
+    COMGR_UTILS_STUB_METADATA_NODE(metadata, AMD_COMGR_METADATA_KIND_MAP);
+
+    for (const std::pair<uint32_t, uint32_t>& entry : node.m_map)
+    {
+        // The callback owns the key and the value, and runs without the lock so it can query them.
+        amd_comgr_metadata_node_t key = CreateMetadata(state, pTree, entry.first);
+        amd_comgr_metadata_node_t value = CreateMetadata(state, pTree, entry.second);
+        lock.unlock();
+        amd_comgr_status_t status = callback(key, value, user_data);
+        lock.lock();
+
+        if (status != AMD_COMGR_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_metadata_lookup(amd_comgr_metadata_node_t metadata, const char* key, amd_comgr_metadata_node_t* value)
+{
+    COMGR_UTILS_STUB_METADATA_NODE(metadata, AMD_COMGR_METADATA_KIND_MAP);
+
+    for (const std::pair<uint32_t, uint32_t>& entry : node.m_map)
+    {
+        if ((*pTree)[entry.first].m_string == key)
+        {
+            *value = CreateMetadata(state, pTree, entry.second);
+            return AMD_COMGR_STATUS_SUCCESS;
+        }
+    }
+
+    return AMD_COMGR_STATUS_ERROR;
+}
+
+amd_comgr_status_t amd_comgr_get_metadata_list_size(amd_comgr_metadata_node_t metadata, size_t* size)
+{
+    COMGR_UTILS_STUB_METADATA_NODE(metadata, AMD_COMGR_METADATA_KIND_LIST);
+    *size = node.m_list.size();
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_index_list_metadata(amd_comgr_metadata_node_t metadata, size_t index, amd_comgr_metadata_node_t* value)
+{
+    COMGR_UTILS_STUB_METADATA_NODE(metadata, AMD_COMGR_METADATA_KIND_LIST);
+
+    if (index >= node.m_list.size())
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    *value = CreateMetadata(state, pTree, node.m_list[index]);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+#undef COMGR_UTILS_STUB_METADATA_NODE
+
+amd_comgr_status_t amd_comgr_iterate_symbols(amd_comgr_data_t data, amd_comgr_status_t (*callback)(amd_comgr_symbol_t, void*), void* user_data)
+{
+    std::vector<amd_comgr_symbol_t> symbols;
+
+    if (!GetSymbolHandles(data, symbols, nullptr))
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (amd_comgr_symbol_t symbol : symbols)
+    {
+        amd_comgr_status_t status = callback(symbol, user_data);
+
+        if (status != AMD_COMGR_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_symbol_lookup(amd_comgr_data_t data, const char* name, amd_comgr_symbol_t* symbol)
+{
+    std::vector<amd_comgr_symbol_t> symbols;
+    std::vector<std::string> names;
+
+    if (!GetSymbolHandles(data, symbols, &names))
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (size_t i = 0; i < symbols.size(); ++i)
+    {
+        if (names[i] == name)
+        {
+            *symbol = symbols[i];
+            return AMD_COMGR_STATUS_SUCCESS;
+        }
+    }
+
+    return AMD_COMGR_STATUS_ERROR;
+}
+
+amd_comgr_status_t amd_comgr_symbol_get_info(amd_comgr_symbol_t symbol, amd_comgr_symbol_info_t attribute, void* value)
+{
+    Elf64Symbol entry;
+    std::string name;
+
+    if (!ReadSymbol(symbol, entry, name))
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    switch (attribute)
+    {
+        case AMD_COMGR_SYMBOL_INFO_NAME_LENGTH:
+            *static_cast<size_t*>(value) = name.size();
+            break;
+
+        case AMD_COMGR_SYMBOL_INFO_NAME:
+            memcpy(value, name.c_str(), name.size() + 1);
+            break;
+
+        case AMD_COMGR_SYMBOL_INFO_TYPE:
+            // The comgr symbol types share the values of the ELF symbol types.
+            *static_cast<amd_comgr_symbol_type_t*>(value) = static_cast<amd_comgr_symbol_type_t>(entry.m_info & 0xf);
+            break;
+
+        case AMD_COMGR_SYMBOL_INFO_SIZE:
+            *static_cast<uint64_t*>(value) = entry.m_size;
+            break;
+
+        case AMD_COMGR_SYMBOL_INFO_IS_UNDEFINED:
+            *static_cast<bool*>(value) = (entry.m_shndx == 0);
+            break;
+
+        case AMD_COMGR_SYMBOL_INFO_VALUE:
+            *static_cast<uint64_t*>(value) = entry.m_value;
+            break;
+
+        default:
+            return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_create_disassembly_info(const char* isa_name,
+                                                     uint64_t (*read_memory_callback)(uint64_t, char*, uint64_t, void*),
+                                                     void (*print_instruction_callback)(const char*, void*),
+                                                     void (*)(uint64_t, void*),
+                                                     amd_comgr_disassembly_info_t* disassembly_info)
+{
+    if (isa_name == nullptr || std::string(isa_name) == ComgrUtilsTest::s_STUB_ISA_FAIL)
+    {
+        return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+    }
+
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    disassembly_info->handle = state.m_nextHandle++;
+    StubDisassemblyInfo& info = state.m_disassemblyInfos[disassembly_info->handle];
+    info.m_pReadMemory = read_memory_callback;
+    info.m_pPrintInstruction = print_instruction_callback;
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+amd_comgr_status_t amd_comgr_destroy_disassembly_info(amd_comgr_disassembly_info_t disassembly_info)
+{
+    StubState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.m_mutex);
+    return state.m_disassemblyInfos.erase(disassembly_info.handle) != 0 ? AMD_COMGR_STATUS_SUCCESS : AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+}
+
+amd_comgr_status_t amd_comgr_disassemble_instruction(amd_comgr_disassembly_info_t disassembly_info, uint64_t address, void* user_data, uint64_t* size)
+{
+    StubDisassemblyInfo info;
+
+    {
+        StubState& state = GetState();
+        std::lock_guard<std::mutex> lock(state.m_mutex);
+        auto entry = state.m_disassemblyInfos.find(disassembly_info.handle);
+
+        if (entry == state.m_disassemblyInfos.end())
+        {
+            return AMD_COMGR_STATUS_ERROR_INVALID_ARGUMENT;
+        }
+
+        info = entry->second;
+    }
+
+    unsigned char bytes[8];
+    uint64_t numBytes = info.m_pReadMemory(address, reinterpret_cast<char*>(bytes), sizeof(bytes), user_data);
+    char text[64];
+
+    if (!DecodeInstruction(bytes, numBytes, text, sizeof(text), *size))
+    {
+        return AMD_COMGR_STATUS_ERROR;
+    }
+
+    info.m_pPrintInstruction(text, user_data);
+    return AMD_COMGR_STATUS_SUCCESS;
+}
+
+}
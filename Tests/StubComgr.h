@@ -0,0 +1,39 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Test hooks of the in-process comgr stub the tests link against.
+//============================================================================================
+#ifndef COMGR_UTILS_TEST_STUB_COMGR_H_
+#define COMGR_UTILS_TEST_STUB_COMGR_H_
+
+#include <cstddef>
+
+namespace ComgrUtilsTest
+{
+/// ISA name that makes a stub action abort the process.
+static const char* const s_STUB_ISA_CRASH = "stub-crash";
+
+/// ISA name that makes a stub action never return.
+static const char* const s_STUB_ISA_HANG = "stub-hang";
+
+/// ISA name that makes a stub action fail.
+static const char* const s_STUB_ISA_FAIL = "stub-fail";
+
+/// ISA name the stub accepts for every action.
+static const char* const s_STUB_ISA = "amdgcn-amd-amdhsa--stub";
+
+/// Get the number of live stub data, data set, action info and disassembly info handles.
+/// \return the number of handles that were created and not yet released.
+size_t GetStubLiveHandles();
+
+/// Get the number of live stub metadata nodes.
+/// \return the number of metadata nodes that were returned and not yet destroyed.
+size_t GetStubLiveMetadataNodes();
+
+/// Get the number of whole code object disassembly actions the stub ran in this process.
+/// \return the number of disassembly actions.
+size_t GetStubDisassemblyActions();
+}
+
+#endif
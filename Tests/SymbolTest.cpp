@@ -0,0 +1,234 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Tests of the native and comgr symbol backends, FindSymbol and the address index.
+//============================================================================================
+#include "ComgrUtils.h"
+#include "ComgrUtilsElf.h"
+#include "StubComgr.h"
+#include "TestCodeObject.h"
+#include "TestUtils.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace AMDT;
+using namespace ComgrUtilsTest;
+
+// ELF symbol type of data objects
+static const uint8_t s_ELF_STT_OBJECT = 1;
+
+// Symbols of the symbol index tests, and addresses looked up in them
+static const uint32_t s_NUM_INDEX_SYMBOLS = 500;
+static const uint32_t s_NUM_INDEX_ADDRESSES = 5000;
+
+// A function symbol as read by a backend.
+struct ReadSymbol
+{
+    std::string m_name;
+    uint64_t    m_value;
+    uint64_t    m_size;
+
+    bool operator==(const ReadSymbol& other) const
+    {
+        return m_name == other.m_name && m_value == other.m_value && m_size == other.m_size;
+    }
+};
+
+// Read the function symbols of a code object with a backend.
+static bool ReadSymbols(const std::vector<char>& codeObject, CodeObjParseBackend backend, std::vector<ReadSymbol>& symbols)
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(codeObject);
+    CodeObjSymbolInfo data;
+    symbols.clear();
+
+    if (pCodeObj == nullptr || !pCodeObj->ExtractSymbolData(data, backend))
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < data.m_numSymbols; ++i)
+    {
+        const CodeObjSymbolFunction& function = data.m_pSymbols[i].m_symbolFunction;
+        symbols.push_back(ReadSymbol{std::string(function.m_pName, static_cast<size_t>(function.m_nameLen)), function.m_symbolValue, function.m_symbolSize});
+    }
+
+    CodeObj::ClearSymbolData(data);
+    return true;
+}
+
+// A code object with functions, a code object v2 kernel and symbols that are not functions.
+static std::vector<char> BuildCodeObject()
+{
+    ElfBuilder elf;
+    uint16_t text = elf.AddText(0x1000, std::vector<uint32_t>(64, 0xBF810000));
+    elf.AddSymbols({{"func_a", ELF_STT_FUNC, text, 0x1000, 0x40},
+                    {"data_x", s_ELF_STT_OBJECT, text, 0x1040, 8},
+                    {"kernel_v2", ELF_STT_AMDGPU_HSA_KERNEL, text, 0x1040, 0x80},
+                    {"", 0, text, 0x1000, 0},
+                    {"func_b", ELF_STT_FUNC, text, 0x10C0, 0x40}});
+    return elf.Build();
+}
+
+// The native reader and comgr iteration find the same function symbols, in the same order.
+static void TestBackendParity()
+{
+    std::vector<char> codeObject = BuildCodeObject();
+    std::vector<ReadSymbol> native;
+    std::vector<ReadSymbol> comgr;
+    std::vector<ReadSymbol> automatic;
+
+    COMGR_UTILS_CHECK(ReadSymbols(codeObject, COMGR_UTILS_PARSE_BACKEND_NATIVE, native));
+    COMGR_UTILS_CHECK(ReadSymbols(codeObject, COMGR_UTILS_PARSE_BACKEND_COMGR, comgr));
+    COMGR_UTILS_CHECK(ReadSymbols(codeObject, COMGR_UTILS_PARSE_BACKEND_AUTO, automatic));
+
+    std::vector<ReadSymbol> expected = {{"func_a", 0x1000, 0x40}, {"kernel_v2", 0x1040, 0x80}, {"func_b", 0x10C0, 0x40}};
+    COMGR_UTILS_CHECK(native == expected);
+    COMGR_UTILS_CHECK(comgr == expected);
+    COMGR_UTILS_CHECK(automatic == expected);
+}
+
+// A valid code object without function symbols succeeds with none on every backend.
+static void TestNoFunctionSymbols()
+{
+    ElfBuilder withData;
+    uint16_t text = withData.AddText(0x1000, {0xBF810000});
+    withData.AddSymbols({{"data_x", s_ELF_STT_OBJECT, text, 0x1000, 4}});
+
+    ElfBuilder withoutTable;
+    withoutTable.AddText(0x1000, {0xBF810000});
+
+    const CodeObjParseBackend backends[] = {COMGR_UTILS_PARSE_BACKEND_NATIVE, COMGR_UTILS_PARSE_BACKEND_COMGR, COMGR_UTILS_PARSE_BACKEND_AUTO};
+
+    for (const std::vector<char>& codeObject : {withData.Build(), withoutTable.Build()})
+    {
+        for (CodeObjParseBackend backend : backends)
+        {
+            std::vector<ReadSymbol> symbols(1);
+            COMGR_UTILS_CHECK(ReadSymbols(codeObject, backend, symbols));
+            COMGR_UTILS_CHECK(symbols.empty());
+        }
+    }
+
+    // Something that is not an ELF file still fails.
+    std::vector<ReadSymbol> symbols;
+    COMGR_UTILS_CHECK(!ReadSymbols(std::vector<char>(64, 'x'), COMGR_UTILS_PARSE_BACKEND_NATIVE, symbols));
+}
+
+// FindSymbol finds functions and kernels by name, and nothing else.
+static void TestFindSymbol()
+{
+    std::unique_ptr<CodeObj> pCodeObj = CodeObj::OpenBuffer(BuildCodeObject());
+    COMGR_UTILS_CHECK(pCodeObj != nullptr);
+
+    CodeObjSymbol symbol;
+    COMGR_UTILS_CHECK(pCodeObj->FindSymbol("kernel_v2", symbol));
+    COMGR_UTILS_CHECK(symbol.m_symbolFunction.m_symbolValue == 0x1040 && symbol.m_symbolFunction.m_symbolSize == 0x80);
+    COMGR_UTILS_CHECK(pCodeObj->FindSymbol("func_b", symbol));
+    COMGR_UTILS_CHECK(std::string(symbol.m_symbolFunction.m_pName) == "func_b");
+    COMGR_UTILS_CHECK(!pCodeObj->FindSymbol("data_x", symbol));
+    COMGR_UTILS_CHECK(!pCodeObj->FindSymbol("missing", symbol));
+}
+
+// Reference lookup: the indexed symbol with the greatest start not above the address, the largest
+// one among equal starts, if it contains the address.
+static uint32_t FindByAddressBruteForce(const std::vector<CodeObjSymbol>& symbols, uint64_t address)
+{
+    uint32_t found = SymbolIndex::s_INVALID_SYMBOL_INDEX;
+
+    for (uint32_t i = 0; i < symbols.size(); ++i)
+    {
+        const CodeObjSymbolFunction& function = symbols[i].m_symbolFunction;
+
+        if (function.m_symbolSize == 0 || function.m_symbolValue > address)
+        {
+            continue;
+        }
+
+        if (found == SymbolIndex::s_INVALID_SYMBOL_INDEX || function.m_symbolValue > symbols[found].m_symbolFunction.m_symbolValue ||
+            (function.m_symbolValue == symbols[found].m_symbolFunction.m_symbolValue && function.m_symbolSize > symbols[found].m_symbolFunction.m_symbolSize))
+        {
+            found = i;
+        }
+    }
+
+    if (found != SymbolIndex::s_INVALID_SYMBOL_INDEX && address - symbols[found].m_symbolFunction.m_symbolValue >= symbols[found].m_symbolFunction.m_symbolSize)
+    {
+        return SymbolIndex::s_INVALID_SYMBOL_INDEX;
+    }
+
+    return found;
+}
+
+// The address index agrees with a linear search over random, partly overlapping symbols.
+static void TestSymbolIndex()
+{
+    uint64_t random = 0x2545F4914F6CDD1D;
+    auto next = [&random](uint64_t range)
+    {
+        random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (random >> 33) % range;
+    };
+
+    // Distinct starts, so the largest symbol at a start is never a tie.
+    std::vector<CodeObjSymbol> symbols(s_NUM_INDEX_SYMBOLS);
+
+    for (uint32_t i = 0; i < s_NUM_INDEX_SYMBOLS; ++i)
+    {
+        CodeObjSymbolFunction& function = symbols[i].m_symbolFunction;
+        symbols[i].m_type = COMGR_UTILS_SYMBOL_TYPE_FUNC;
+        function.m_pName = nullptr;
+        function.m_nameLen = 0;
+        function.m_symbolValue = 0x1000 + (i * 7919ULL % s_NUM_INDEX_SYMBOLS) * 0x40 + next(0x40);
+        function.m_symbolSize = (i % 10 == 0) ? 0 : next(0x100);
+    }
+
+    CodeObjSymbolInfo data;
+    data.m_numSymbols = s_NUM_INDEX_SYMBOLS;
+    data.m_pSymbols = symbols.data();
+
+    SymbolIndex index;
+    index.Build(data);
+
+    std::vector<uint64_t> addresses;
+
+    for (uint32_t i = 0; i < s_NUM_INDEX_ADDRESSES; ++i)
+    {
+        addresses.push_back(next(0x40 * (s_NUM_INDEX_SYMBOLS + 2)) + 0xFC0);
+    }
+
+    addresses.push_back(0);
+    addresses.push_back(UINT64_MAX);
+
+    std::vector<uint32_t> batched;
+    index.FindByAddress(addresses, batched);
+
+    for (size_t i = 0; i < addresses.size(); ++i)
+    {
+        uint32_t expected = FindByAddressBruteForce(symbols, addresses[i]);
+        COMGR_UTILS_CHECK(index.FindByAddress(addresses[i]) == expected);
+        COMGR_UTILS_CHECK(batched[i] == expected);
+    }
+
+    // An empty index finds nothing.
+    data.m_pSymbols = nullptr;
+    data.m_numSymbols = 0;
+    SymbolIndex empty;
+    empty.Build(data);
+    COMGR_UTILS_CHECK(empty.FindByAddress(0x1000) == SymbolIndex::s_INVALID_SYMBOL_INDEX);
+}
+
+int main()
+{
+    size_t liveHandles = GetStubLiveHandles();
+
+    COMGR_UTILS_RUN_TEST(TestBackendParity);
+    COMGR_UTILS_RUN_TEST(TestNoFunctionSymbols);
+    COMGR_UTILS_RUN_TEST(TestFindSymbol);
+    COMGR_UTILS_RUN_TEST(TestSymbolIndex);
+
+    COMGR_UTILS_CHECK(GetStubLiveHandles() == liveHandles);
+    return GetFailureCount();
+}
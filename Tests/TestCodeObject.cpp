@@ -0,0 +1,364 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Builders of the MsgPack notes and ELF64 code objects the tests run on.
+//============================================================================================
+#include "TestCodeObject.h"
+
+#include "ComgrUtilsElf.h"
+
+#include <cstring>
+
+using namespace AMDT;
+
+namespace ComgrUtilsTest
+{
+// ELF header constants of an AMDGPU relocatable
+static const uint16_t s_ELF_TYPE_RELOCATABLE = 1;
+static const uint16_t s_ELF_MACHINE_AMDGPU = 224;
+static const uint32_t s_ELF_FLAGS_GFX900 = 0x2c;
+
+// Section flag of allocated sections
+static const uint64_t s_ELF_SHF_ALLOC = 0x2;
+
+// NT_AMDGPU_METADATA, the type of the MsgPack metadata note
+static const uint32_t s_METADATA_NOTE_TYPE = 32;
+
+// Alignment of the sections in the file
+static const size_t s_SECTION_ALIGNMENT = 8;
+
+// Append a little-endian value to a byte vector.
+template <typename T>
+static void AppendValue(std::vector<char>& bytes, const T& value)
+{
+    const char* pValue = reinterpret_cast<const char*>(&value);
+    bytes.insert(bytes.end(), pValue, pValue + sizeof(T));
+}
+
+// Pad a byte vector with zeros to a multiple of an alignment.
+static void Align(std::vector<char>& bytes, size_t alignment)
+{
+    bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+void MsgPackWriter::WriteTyped(uint8_t type, uint64_t value, uint32_t numBytes)
+{
+    m_bytes.push_back(type);
+
+    for (uint32_t i = numBytes; i > 0; --i)
+    {
+        m_bytes.push_back(static_cast<uint8_t>(value >> ((i - 1) * 8)));
+    }
+}
+
+void MsgPackWriter::Nil()
+{
+    m_bytes.push_back(0xc0);
+}
+
+void MsgPackWriter::Bool(bool value)
+{
+    m_bytes.push_back(value ? 0xc3 : 0xc2);
+}
+
+void MsgPackWriter::UInt(uint64_t value)
+{
+    if (value < 0x80)
+    {
+        m_bytes.push_back(static_cast<uint8_t>(value));
+    }
+    else if (value <= UINT8_MAX)
+    {
+        WriteTyped(0xcc, value, 1);
+    }
+    else if (value <= UINT16_MAX)
+    {
+        WriteTyped(0xcd, value, 2);
+    }
+    else if (value <= UINT32_MAX)
+    {
+        WriteTyped(0xce, value, 4);
+    }
+    else
+    {
+        WriteTyped(0xcf, value, 8);
+    }
+}
+
+void MsgPackWriter::Int(int64_t value)
+{
+    if (value >= 0)
+    {
+        UInt(static_cast<uint64_t>(value));
+    }
+    else if (value >= -32)
+    {
+        m_bytes.push_back(static_cast<uint8_t>(value));
+    }
+    else
+    {
+        WriteTyped(0xd3, static_cast<uint64_t>(value), 8);
+    }
+}
+
+void MsgPackWriter::String(const std::string& value)
+{
+    if (value.size() < 32)
+    {
+        m_bytes.push_back(static_cast<uint8_t>(0xa0 | value.size()));
+    }
+    else if (value.size() <= UINT8_MAX)
+    {
+        WriteTyped(0xd9, value.size(), 1);
+    }
+    else
+    {
+        WriteTyped(0xda, value.size(), 2);
+    }
+
+    m_bytes.insert(m_bytes.end(), value.begin(), value.end());
+}
+
+void MsgPackWriter::Array(uint32_t count)
+{
+    if (count < 16)
+    {
+        m_bytes.push_back(static_cast<uint8_t>(0x90 | count));
+    }
+    else
+    {
+        WriteTyped(0xdd, count, 4);
+    }
+}
+
+void MsgPackWriter::Map(uint32_t count)
+{
+    if (count < 16)
+    {
+        m_bytes.push_back(static_cast<uint8_t>(0x80 | count));
+    }
+    else
+    {
+        WriteTyped(0xdf, count, 4);
+    }
+}
+
+void MsgPackWriter::Raw(const std::vector<uint8_t>& bytes)
+{
+    m_bytes.insert(m_bytes.end(), bytes.begin(), bytes.end());
+}
+
+ElfBuilder::ElfBuilder()
+{
+    m_sections.push_back(Section{"", 0, 0, 0, std::vector<char>(), 0, 0, 0});
+}
+
+uint16_t ElfBuilder::AddSection(const std::string& name, uint32_t type, uint64_t flags, uint64_t address, const std::vector<char>& bytes)
+{
+    m_sections.push_back(Section{name, type, flags, address, bytes, 0, 0, 0});
+    return static_cast<uint16_t>(m_sections.size() - 1);
+}
+
+uint16_t ElfBuilder::AddText(uint64_t address, const std::vector<uint32_t>& words)
+{
+    std::vector<char> bytes;
+
+    for (uint32_t word : words)
+    {
+        AppendValue(bytes, word);
+    }
+
+    return AddSection(".text", 1, s_ELF_SHF_ALLOC | ELF_SHF_EXECINSTR, address, bytes);
+}
+
+uint16_t ElfBuilder::AddNote(const std::string& owner, uint32_t type, const std::vector<uint8_t>& desc)
+{
+    std::vector<char> note;
+    AppendValue(note, static_cast<uint32_t>(owner.size() + 1));
+    AppendValue(note, static_cast<uint32_t>(desc.size()));
+    AppendValue(note, type);
+    note.insert(note.end(), owner.begin(), owner.end());
+    note.push_back('\0');
+    Align(note, 4);
+    note.insert(note.end(), desc.begin(), desc.end());
+    Align(note, 4);
+    return AddSection(".note", ELF_SHT_NOTE, s_ELF_SHF_ALLOC, 0, note);
+}
+
+uint16_t ElfBuilder::AddMetadata(const MsgPackWriter& metadata)
+{
+    return AddNote("AMDGPU", s_METADATA_NOTE_TYPE, metadata.GetBytes());
+}
+
+void ElfBuilder::AddSymbols(const std::vector<TestSymbol>& symbols)
+{
+    std::vector<char> symbolTable(sizeof(Elf64Symbol), 0);
+    std::vector<char> stringTable(1, '\0');
+
+    for (const TestSymbol& symbol : symbols)
+    {
+        Elf64Symbol entry;
+        entry.m_name = static_cast<uint32_t>(stringTable.size());
+        entry.m_info = static_cast<uint8_t>((1 << 4) | symbol.m_type);
+        entry.m_other = 0;
+        entry.m_shndx = symbol.m_section;
+        entry.m_value = symbol.m_value;
+        entry.m_size = symbol.m_size;
+        AppendValue(symbolTable, entry);
+        stringTable.insert(stringTable.end(), symbol.m_name.begin(), symbol.m_name.end());
+        stringTable.push_back('\0');
+    }
+
+    uint32_t stringTableIndex = static_cast<uint32_t>(m_sections.size() + 1);
+    m_sections.push_back(Section{".symtab", ELF_SHT_SYMTAB, 0, 0, symbolTable, stringTableIndex, 1, sizeof(Elf64Symbol)});
+    m_sections.push_back(Section{".strtab", ELF_SHT_STRTAB, 0, 0, stringTable, 0, 0, 0});
+}
+
+std::vector<char> ElfBuilder::Build() const
+{
+    std::vector<Section> sections = m_sections;
+    std::vector<char> sectionNames(1, '\0');
+    std::vector<uint32_t> nameOffsets;
+    sections.push_back(Section{".shstrtab", ELF_SHT_STRTAB, 0, 0, std::vector<char>(), 0, 0, 0});
+
+    for (const Section& section : sections)
+    {
+        nameOffsets.push_back(section.m_name.empty() ? 0 : static_cast<uint32_t>(sectionNames.size()));
+        sectionNames.insert(sectionNames.end(), section.m_name.begin(), section.m_name.end());
+        sectionNames.push_back('\0');
+    }
+
+    sections.back().m_bytes = sectionNames;
+
+    std::vector<char> file(sizeof(Elf64Header), 0);
+    std::vector<uint64_t> offsets;
+
+    for (const Section& section : sections)
+    {
+        Align(file, s_SECTION_ALIGNMENT);
+        offsets.push_back(section.m_bytes.empty() ? 0 : file.size());
+        file.insert(file.end(), section.m_bytes.begin(), section.m_bytes.end());
+    }
+
+    Align(file, s_SECTION_ALIGNMENT);
+
+    Elf64Header header;
+    memset(&header, 0, sizeof(header));
+    const uint8_t ident[] = {0x7f, 'E', 'L', 'F', 2, 1, 1, 64, 3};
+    memcpy(header.m_ident, ident, sizeof(ident));
+    header.m_type = s_ELF_TYPE_RELOCATABLE;
+    header.m_machine = s_ELF_MACHINE_AMDGPU;
+    header.m_version = 1;
+    header.m_shoff = file.size();
+    header.m_flags = s_ELF_FLAGS_GFX900;
+    header.m_ehsize = sizeof(Elf64Header);
+    header.m_phentsize = sizeof(Elf64ProgramHeader);
+    header.m_shentsize = sizeof(Elf64SectionHeader);
+    header.m_shnum = static_cast<uint16_t>(sections.size());
+    header.m_shstrndx = static_cast<uint16_t>(sections.size() - 1);
+    memcpy(file.data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        Elf64SectionHeader sectionHeader;
+        sectionHeader.m_name = nameOffsets[i];
+        sectionHeader.m_type = sections[i].m_type;
+        sectionHeader.m_flags = sections[i].m_flags;
+        sectionHeader.m_addr = sections[i].m_address;
+        sectionHeader.m_offset = offsets[i];
+        sectionHeader.m_size = sections[i].m_bytes.size();
+        sectionHeader.m_link = sections[i].m_link;
+        sectionHeader.m_info = sections[i].m_info;
+        sectionHeader.m_addralign = (i == 0 ? 0 : 1);
+        sectionHeader.m_entsize = sections[i].m_entsize;
+        AppendValue(file, sectionHeader);
+    }
+
+    return file;
+}
+
+void WritePalMetadata(MsgPackWriter& metadata)
+{
+    metadata.Map(2);
+    metadata.String("amdpal.version");
+    metadata.Array(2);
+    metadata.UInt(2);
+    metadata.UInt(6);
+
+    metadata.String("amdpal.pipelines");
+    metadata.Array(1);
+    metadata.Map(10);
+
+    // Longer than the fixed size name buffers, so the name is stored out of line.
+    metadata.String(".name");
+    metadata.String("MyPipeline_" + std::string(300, 'x'));
+
+    metadata.String(".pipeline_compiler_hash");
+    metadata.Array(2);
+    metadata.UInt(0x1122334455667788);
+    metadata.UInt(0x99);
+
+    metadata.String(".user_data_limit");
+    metadata.UInt(16);
+    metadata.String(".spill_threshold");
+    metadata.UInt(0xffff);
+    metadata.String(".wavefront_size");
+    metadata.UInt(64);
+    metadata.String(".api");
+    metadata.UInt(1);
+
+    // Keys the parser does not know are skipped, including nested ones.
+    metadata.String(".unknown");
+    metadata.Map(1);
+    metadata.String("a");
+    metadata.Array(3);
+    metadata.UInt(1);
+    metadata.UInt(2);
+    metadata.Map(1);
+    metadata.String("b");
+    metadata.Nil();
+
+    metadata.String(".shaders");
+    metadata.Map(2);
+    metadata.String(".compute");
+    metadata.Map(2);
+    metadata.String(".api_shader_hash");
+    metadata.Array(2);
+    metadata.UInt(1);
+    metadata.UInt(2);
+    metadata.String(".hardware_mapping");
+    metadata.Array(1);
+    metadata.String(".cs");
+    metadata.String(".pixel");
+    metadata.Map(1);
+    metadata.String(".hardware_mapping");
+    metadata.UInt(5);
+
+    metadata.String(".hardware_stages");
+    metadata.Map(1);
+    metadata.String(".cs");
+    metadata.Map(6);
+    metadata.String(".entry_point");
+    metadata.String("_amdgpu_cs_main");
+    metadata.String(".sgpr_count");
+    metadata.UInt(20);
+    metadata.String(".vgpr_count");
+    metadata.UInt(48);
+    metadata.String(".uses_uavs");
+    metadata.Bool(true);
+    metadata.String(".lds_size");
+    metadata.UInt(4096);
+    metadata.String(".max_prims_per_ps_wave");
+    metadata.UInt(3);
+
+    metadata.String(".registers");
+    metadata.Map(3);
+    metadata.UInt(0x2e12);
+    metadata.UInt(0xdeadbeef);
+    metadata.UInt(0x2e13);
+    metadata.UInt(5);
+    metadata.UInt(11);
+    metadata.UInt(0xffffffff);
+}
+}
@@ -0,0 +1,142 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Builders of the MsgPack notes and ELF64 code objects the tests run on.
+//============================================================================================
+#ifndef COMGR_UTILS_TEST_CODE_OBJECT_H_
+#define COMGR_UTILS_TEST_CODE_OBJECT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ComgrUtilsTest
+{
+/// Writes MsgPack objects with the shortest encoding of each value.
+class MsgPackWriter
+{
+public:
+    /// Write a nil.
+    void Nil();
+
+    /// Write a boolean.
+    /// \param value the value.
+    void Bool(bool value);
+
+    /// Write an unsigned integer.
+    /// \param value the value.
+    void UInt(uint64_t value);
+
+    /// Write a signed integer.
+    /// \param value the value.
+    void Int(int64_t value);
+
+    /// Write a string.
+    /// \param value the value.
+    void String(const std::string& value);
+
+    /// Write an array header; the elements are written next.
+    /// \param count the number of elements.
+    void Array(uint32_t count);
+
+    /// Write a map header; the keys and values are written next.
+    /// \param count the number of key/value pairs.
+    void Map(uint32_t count);
+
+    /// Append bytes as they are, to write malformed data.
+    /// \param bytes the bytes.
+    void Raw(const std::vector<uint8_t>& bytes);
+
+    /// Get the written bytes.
+    /// \return the MsgPack bytes.
+    const std::vector<uint8_t>& GetBytes() const
+    {
+        return m_bytes;
+    }
+
+private:
+    /// Write a type byte and a big-endian value.
+    /// \param type the type byte.
+    /// \param value the value.
+    /// \param numBytes the size of the value (1, 2, 4 or 8).
+    void WriteTyped(uint8_t type, uint64_t value, uint32_t numBytes);
+
+    std::vector<uint8_t> m_bytes;   ///< The written bytes.
+};
+
+/// A symbol added to an ElfBuilder.
+struct TestSymbol
+{
+    std::string m_name;     ///< The symbol name.
+    uint8_t     m_type;     ///< The ELF symbol type.
+    uint16_t    m_section;  ///< The index of the section the symbol is in.
+    uint64_t    m_value;    ///< The symbol address.
+    uint64_t    m_size;     ///< The symbol size.
+};
+
+/// Builds a little-endian ELF64 relocatable AMDGPU file.
+class ElfBuilder
+{
+public:
+    /// Constructor, adds the null section.
+    ElfBuilder();
+
+    /// Add a section.
+    /// \param name the section name.
+    /// \param type the section type.
+    /// \param flags the section flags.
+    /// \param address the section address.
+    /// \param bytes the section contents.
+    /// \return the section index.
+    uint16_t AddSection(const std::string& name, uint32_t type, uint64_t flags, uint64_t address, const std::vector<char>& bytes);
+
+    /// Add an executable .text section of little-endian words.
+    /// \param address the section address.
+    /// \param words the instruction words.
+    /// \return the section index.
+    uint16_t AddText(uint64_t address, const std::vector<uint32_t>& words);
+
+    /// Add a note section holding one note.
+    /// \param owner the note owner name.
+    /// \param type the note type.
+    /// \param desc the note descriptor.
+    /// \return the section index.
+    uint16_t AddNote(const std::string& owner, uint32_t type, const std::vector<uint8_t>& desc);
+
+    /// Add the AMDGPU MsgPack metadata note.
+    /// \param metadata the MsgPack metadata.
+    /// \return the section index.
+    uint16_t AddMetadata(const MsgPackWriter& metadata);
+
+    /// Add a .symtab section and its .strtab section.
+    /// \param symbols the symbols, in symbol table order.
+    void AddSymbols(const std::vector<TestSymbol>& symbols);
+
+    /// Lay out the file.
+    /// \return the ELF file bytes.
+    std::vector<char> Build() const;
+
+private:
+    /// A section to be written.
+    struct Section
+    {
+        std::string         m_name;     ///< The section name.
+        uint32_t            m_type;     ///< The section type.
+        uint64_t            m_flags;    ///< The section flags.
+        uint64_t            m_address;  ///< The section address.
+        std::vector<char>   m_bytes;    ///< The section contents.
+        uint32_t            m_link;     ///< The linked section.
+        uint32_t            m_info;     ///< The section info.
+        uint64_t            m_entsize;  ///< The table entry size.
+    };
+
+    std::vector<Section> m_sections;    ///< The sections, starting with the null section.
+};
+
+/// Build the PAL pipeline metadata sample the PAL tests parse.
+/// \param metadata receives the MsgPack metadata.
+void WritePalMetadata(MsgPackWriter& metadata);
+}
+
+#endif
@@ -0,0 +1,38 @@
+//============================================================================================
+// Copyright (c) 2018 Advanced Micro Devices, Inc. All rights reserved.
+/// \author AMD Developer Tools
+/// \file
+/// \brief  Minimal check macros of the tests; each test executable returns its failure count.
+//============================================================================================
+#ifndef COMGR_UTILS_TEST_UTILS_H_
+#define COMGR_UTILS_TEST_UTILS_H_
+
+#include <cstdio>
+
+namespace ComgrUtilsTest
+{
+/// Get the number of failed checks of the test executable.
+/// \return the failure count.
+inline int& GetFailureCount()
+{
+    static int s_failureCount = 0;
+    return s_failureCount;
+}
+}
+
+/// Report a failed check with its location and count it; evaluates to the condition.
+#define COMGR_UTILS_CHECK(condition)                                                                \
+    ((condition) ? true :                                                                           \
+     (fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition),                \
+      ++ComgrUtilsTest::GetFailureCount(), false))
+
+/// Run a test function and report its name if any of its checks failed.
+#define COMGR_UTILS_RUN_TEST(test)                                                                  \
+    do                                                                                              \
+    {                                                                                               \
+        int failuresBefore = ComgrUtilsTest::GetFailureCount();                                     \
+        test();                                                                                     \
+        fprintf(stderr, "%s %s\n", ComgrUtilsTest::GetFailureCount() == failuresBefore ? "PASS" : "FAIL", #test);  \
+    } while (false)
+
+#endif